@@ -3,13 +3,29 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdlib>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <functional>
 #include "audit.hpp"
 #include "rpc.hpp"
+#include "log.hpp"
+#include "scheduler.hpp"
+#include "engine.hpp"
+#include "controller.hpp"
+#include "mapped_file.hpp"
+#include "block_cache.hpp"
+#include "nodes.hpp"
+#include "emission.hpp"
 #include <nlohmann/json.hpp>
 
 using namespace std;
@@ -41,53 +57,290 @@ std::map<std::string, std::string> load_config(const std::string &config_file) {
     return config;
 }
 
-// Estrutura para armazenar um registro do CSV
+// Registro do CSV sem strings próprias: os campos de texto (hash, problemas,
+// status) são lidos da linha no arquivo mapeado quando preciso
 struct CSVRecord {
-    int height;
-    string hash;
-    unsigned long long real_reward;
-    unsigned long long coinbase_outputs;
-    unsigned long long total_mined;
-    string issues;
-    string status;
+    int height = 0;
+    uint32_t length = 0; // Tamanho da linha, sem o '\n'
+    uint64_t offset = 0; // Início da linha no arquivo
+    unsigned long long real_reward = 0;
+    unsigned long long coinbase_outputs = 0;
+    unsigned long long total_mined = 0;
+    uint64_t fees = UNKNOWN;      // Colunas Taxas e MoedasGeradas (vazias ou
+    uint64_t generated = UNKNOWN; // ausentes nos CSVs antigos: UNKNOWN)
+    static constexpr uint64_t UNKNOWN = ~uint64_t(0);
 };
 
-bool parseCSVLine(const string& line, CSVRecord& record) {
-    istringstream ss(line);
-    string token;
-    vector<string> tokens;
-    while(getline(ss, token, ',')) {
-        tokens.push_back(token);
-    }
-    if(tokens.size() < 7)
-        return false;
-    try {
-        record.height = stoi(tokens[0]);
-        record.hash = tokens[1];
-        record.real_reward = stoull(tokens[2]);
-        record.coinbase_outputs = stoull(tokens[3]);
-        record.total_mined = stoull(tokens[4]);
-        record.issues = tokens[5];
-        record.status = tokens[6];
-    } catch(...) {
-        return false;
-    }
-    return true;
+// Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status
+// e, a partir da auditoria de taxas, Taxas,MoedasGeradas
+const int CSV_FIELDS = 9;
+const int CSV_BASE_FIELDS = 7;
+
+// Divide a linha nos campos do CSV (os 2 últimos ficam vazios nos CSVs
+// antigos); false se faltar algum ou sobrar vírgula
+static bool split_fields(string_view line, string_view (&fields)[CSV_FIELDS]) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    size_t start = 0;
+    int count = 0;
+    for (; count < CSV_FIELDS; ++count) {
+        size_t comma = line.find(',', start);
+        fields[count] = line.substr(start, comma == string_view::npos ? string_view::npos : comma - start);
+        if (comma == string_view::npos) break;
+        start = comma + 1;
+    }
+    if (count == CSV_FIELDS) return false;
+    for (int i = count + 1; i < CSV_FIELDS; ++i) fields[i] = string_view();
+    return count + 1 == CSV_BASE_FIELDS || count + 1 == CSV_FIELDS;
+}
+
+template <typename T>
+static bool parse_number(string_view field, T& value) {
+    auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+    return res.ec == std::errc() && res.ptr == field.data() + field.size();
+}
+
+// Resumo de uma linha (todas as colunas); o de um trecho é a soma módulo
+// 2^64 dos resumos das linhas, o que permite somas de prefixo na bissecção
+static uint64_t row_digest(int height, string_view hash, uint64_t real_reward, uint64_t coinbase_outputs,
+                           uint64_t total_mined, string_view issues, string_view status) {
+    uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+    auto mix_bytes = [&](const void* p, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; ++i) {
+            h ^= b[i];
+            h *= 0x100000001b3ULL;
+        }
+    };
+    auto mix_text = [&](string_view text) {
+        uint64_t n = text.size();
+        mix_bytes(&n, sizeof(n));
+        mix_bytes(text.data(), text.size());
+    };
+    int64_t hh = height;
+    mix_bytes(&hh, sizeof(hh));
+    mix_text(hash);
+    mix_bytes(&real_reward, sizeof(real_reward));
+    mix_bytes(&coinbase_outputs, sizeof(coinbase_outputs));
+    mix_bytes(&total_mined, sizeof(total_mined));
+    mix_text(issues == "Nenhum" ? string_view() : issues);
+    mix_text(status);
+    // Finalização do splitmix64: espalha os bits antes da soma
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+bool parseCSVLine(string_view line, CSVRecord& record) {
+    string_view fields[CSV_FIELDS];
+    record.length = static_cast<uint32_t>(line.size());
+    return split_fields(line, fields) &&
+           parse_number(fields[0], record.height) &&
+           parse_number(fields[2], record.real_reward) &&
+           parse_number(fields[3], record.coinbase_outputs) &&
+           parse_number(fields[4], record.total_mined) &&
+           !fields[6].empty() &&
+           (fields[7].empty() || parse_number(fields[7], record.fees)) &&
+           (fields[8].empty() || parse_number(fields[8], record.generated));
+}
+
+// Modo emissão, sem RPC: refaz a conta das moedas geradas sobre as colunas
+// Taxas e MoedasGeradas do CSV, em paralelo (verify_emission), e confere a
+// recompensa base de cada bloco. A versão sai da altura (hard forks da
+// mainnet) e o peso não está no CSV, então só o teto é conferido.
+static int check_emission_curve(const vector<CSVRecord>& records, unsigned threads) {
+    uint64_t checked = 0, over = 0, column = 0, unverified = 0;
+    std::optional<uint64_t> last_generated;
+    int last_height = -1;
+    size_t i = 0;
+    while (i < records.size()) {
+        // Trecho de alturas contíguas com as taxas conhecidas
+        size_t j = i;
+        while (j < records.size() && records[j].fees != CSVRecord::UNKNOWN &&
+               (j == i || records[j].height == records[j - 1].height + 1)) ++j;
+        if (j == i) {
+            unverified++;
+            i++;
+            continue;
+        }
+        // Moedas geradas antes do trecho: 0 na altura 0, senão as da coluna
+        const CSVRecord& head = records[i];
+        std::optional<uint64_t> before;
+        if (head.height == 0) before = 0;
+        else if (head.generated != CSVRecord::UNKNOWN && head.fees <= head.coinbase_outputs &&
+                 head.generated >= head.coinbase_outputs - head.fees) before = head.generated - (head.coinbase_outputs - head.fees);
+        if (!before) {
+            cerr << "[AVISO] Moedas geradas antes do bloco " << head.height << " desconhecidas; "
+                 << (j - i) << " bloco(s) sem conferência" << endl;
+            unverified += j - i;
+            i = j;
+            continue;
+        }
+
+        std::vector<EmissionBlock> blocks(j - i);
+        for (size_t k = 0; k < blocks.size(); ++k) {
+            const CSVRecord& rec = records[i + k];
+            blocks[k].coinbase = rec.coinbase_outputs;
+            blocks[k].fees = rec.fees;
+            blocks[k].major_version = mainnet_version(static_cast<uint64_t>(rec.height));
+        }
+        last_generated = verify_emission(blocks, *before, threads);
+        last_height = records[j - 1].height;
+        // Um erro na coluna se propaga às linhas seguintes: só a linha em que
+        // a diferença entre CSV e cálculo muda é apontada
+        uint64_t delta = 0;
+        for (size_t k = 0; k < blocks.size(); ++k) {
+            const CSVRecord& rec = records[i + k];
+            const EmissionBlock& b = blocks[k];
+            ostringstream details;
+            if (b.mismatch) {
+                over++;
+                details << "Reward != Base+Fees (coinbase " << b.coinbase << ", taxas " << b.fees << ", base " << b.base << ") ";
+            }
+            if (rec.generated != CSVRecord::UNKNOWN && rec.generated - b.generated != delta) {
+                delta = rec.generated - b.generated;
+                column++;
+                details << "MoedasGeradas (CSV: " << rec.generated << ", calculado: " << b.generated << ") ";
+            }
+            if (!details.str().empty()) {
+                cout << "Bloco " << setw(6) << rec.height << ": ERRO (" << details.str() << ")" << endl;
+                log_message(g_log_path, "Bloco " + std::to_string(rec.height) + " emissão: ERRO (" + details.str() + ").");
+            }
+        }
+        checked += blocks.size();
+        i = j;
+    }
+
+    cout << "------------------------\n";
+    cout << "Resumo da Emissão\n";
+    cout << "------------------------\n";
+    cout << "Blocos conferidos:        " << setw(6) << checked << "\n";
+    cout << "Acima da base + taxas:    " << setw(6) << over << "\n";
+    cout << "MoedasGeradas divergente: " << setw(6) << column << "\n";
+    cout << "Sem conferência:          " << setw(6) << unverified << "\n";
+    if (last_generated) cout << "Moedas geradas até o bloco " << last_height << ": " << *last_generated << "\n";
+    cout << "------------------------\n";
+    log_message(g_log_path, "Emissão: " + std::to_string(checked) + " blocos conferidos, " + std::to_string(over)
+                + " acima da base + taxas, " + std::to_string(column) + " com MoedasGeradas divergente, "
+                + std::to_string(unverified) + " sem conferência.");
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    log_message(g_log_path, "Início da validação via RPC.");
+    auto config = load_config("audit-xmr.cfg");
 
     // Determina o servidor RPC: tenta --server na linha de comando, senão usa o arquivo de configuração.
     std::string server;
+    // Vários nós, como no audit-xmr: balanceamento e duplicado após o p95
+    std::vector<std::string> servers = config.count("servers") ? parse_server_list(config["servers"])
+                                                               : std::vector<std::string>();
+    bool hedge = !config.count("hedge") || config["hedge"] != "0";
+    string csvFilename;
+    std::string log_level = config.count("log_level") ? config["log_level"] : "info";
+    // Concorrência com as mesmas chaves e opções do audit-xmr
+    int thread_count = config.count("threads") ? std::stoi(config["threads"]) : 1;
+    int chunk_size = config.count("chunk_size") ? std::stoi(config["chunk_size"]) : 16;
+    int max_retries = config.count("max_retries") ? std::stoi(config["max_retries"]) : 3;
+    std::string engine = config.count("engine") ? config["engine"] : "threads";
+    bool adaptive = !config.count("adaptive") || config["adaptive"] != "0";
+    AsyncEngineOptions asyncOptions;
+    // Modo resumo: confere trechos inteiros com poucas requisições em lote
+    bool digest_mode = config.count("check_mode") && config["check_mode"] == "digest";
+    int segment_size = config.count("segment_size") ? std::stoi(config["segment_size"]) : MAX_HEADER_RANGE;
+    std::string block_source = config.count("block_source") ? config["block_source"] : "bin";
+    // Modo emissão: confere a curva de emissão pelo próprio CSV, sem RPC
+    bool emission_mode = config.count("check_mode") && config["check_mode"] == "emission";
+    // Cache de blocos compartilhado com o audit-xmr
+    std::string cache_path = config.count("cache_path") ? config["cache_path"] : "";
+    bool cache_only = config.count("cache_only") && config["cache_only"] == "1";
+    // Verificação do id, para conferir um CSV gerado com --verify-id
+    bool verify_id = config.count("verify_id") && config["verify_id"] == "1";
+    if (config.count("inflight")) asyncOptions.inflight = std::stoi(config["inflight"]);
+    if (config.count("io_threads")) asyncOptions.io_threads = std::stoi(config["io_threads"]);
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if(arg == "--server" && i+1 < argc) {
             server = argv[++i];
+            servers.clear();
+        } else if(arg == "--servers" && i+1 < argc) {
+            servers = parse_server_list(argv[++i]);
+        } else if(arg == "--no-hedge") {
+            hedge = false;
+        } else if(arg == "--log-level" && i+1 < argc) {
+            log_level = argv[++i];
+        } else if(arg == "--threads" && i+1 < argc) {
+            std::string tval = argv[++i];
+            thread_count = tval == "max" ? static_cast<int>(std::thread::hardware_concurrency()) : std::stoi(tval);
+        } else if(arg == "--engine" && i+1 < argc) {
+            engine = argv[++i];
+        } else if(arg == "--inflight" && i+1 < argc) {
+            asyncOptions.inflight = std::stoi(argv[++i]);
+        } else if(arg == "--io-threads" && i+1 < argc) {
+            asyncOptions.io_threads = std::stoi(argv[++i]);
+        } else if(arg == "--max-retries" && i+1 < argc) {
+            max_retries = std::stoi(argv[++i]);
+        } else if(arg == "--no-adaptive") {
+            adaptive = false;
+        } else if(arg == "--digest") {
+            digest_mode = true;
+        } else if(arg == "--emission") {
+            emission_mode = true;
+        } else if(arg == "--segment-size" && i+1 < argc) {
+            segment_size = std::stoi(argv[++i]);
+        } else if(arg == "--source" && i+1 < argc) {
+            block_source = argv[++i];
+        } else if(arg == "--cache" && i+1 < argc) {
+            cache_path = argv[++i];
+        } else if(arg == "--cache-only") {
+            cache_only = true;
+        } else if(arg == "--verify-id") {
+            verify_id = true;
+        } else if(csvFilename.empty() && arg.compare(0, 2, "--") != 0) {
+            csvFilename = arg;
         }
     }
 
-    auto config = load_config("audit-xmr.cfg");
+    LogLevel level;
+    if(!parse_log_level(log_level, level)) {
+        cerr << "[AVISO] Nível de log inválido: " << log_level << ". Usando info.\n";
+        level = LogLevel::Info;
+    }
+    set_log_level(level);
+    thread_count = std::max(1, thread_count);
+    segment_size = std::max(1, std::min(segment_size, MAX_HEADER_RANGE));
+    if (block_source != "bin" && block_source != "batch") block_source = "bin"; // O modo resumo só usa fontes em lote
+    if (engine != "threads" && engine != "async") {
+        cerr << "[AVISO] Motor inválido: " << engine << ". Usando threads.\n";
+        engine = "threads";
+    }
+    // Como no audit-xmr: sem blob na fonte batch nem no cache
+    if (verify_id && block_source == "batch") block_source = "bin";
+    if (verify_id && !cache_path.empty()) {
+        cerr << "[AVISO] --verify-id não se aplica com o cache. Verificação de id desligada.\n";
+        verify_id = false;
+    }
+    set_id_check(verify_id);
+    if (cache_only && cache_path.empty()) {
+        cerr << "[ERRO] --cache-only requer --cache <arquivo> (ou cache_path no audit-xmr.cfg)." << endl;
+        return 1;
+    }
+    std::unique_ptr<BlockCache> cache;
+    if (!cache_path.empty()) {
+        cache.reset(new BlockCache(cache_path, cache_only));
+        std::string error;
+        if (!cache->open(&error)) {
+            cerr << "[ERRO] Não foi possível abrir o cache " << cache_path << ": " << error << endl;
+            return 1;
+        }
+        if (cache_only) max_retries = 0; // Sem nó, uma ausência não muda numa nova tentativa
+        if (engine == "async") {
+            cerr << "[AVISO] --engine async não usa o cache. Usando threads.\n";
+            engine = "threads";
+        }
+    }
+    if(config.find("log_max_size") != config.end()) {
+        set_log_max_size(std::stoull(config["log_max_size"]) * 1024 * 1024);
+    }
+    log_message(g_log_path, "Início da validação via RPC.");
     if(server.empty() && config.find("rpc_url") != config.end()) {
         server = config["rpc_url"];
     }
@@ -96,7 +349,14 @@ int main(int argc, char* argv[]) {
     cout << "------------------------\n";
     cout << "Configurações do audit-xmr-check\n";
     cout << "------------------------\n";
-    if (!server.empty()) {
+    if (!servers.empty()) {
+        set_rpc_url(servers[0]);
+        set_rpc_nodes(servers);
+        cout << "Nós RPC:";
+        for (size_t i = 0; i < servers.size(); ++i) cout << (i ? ", " : " ") << servers[i];
+        cout << "\n  (duplicado após o p95: " << (hedge && servers.size() > 1 ? "sim" : "não") << ")\n";
+        log_message(g_log_path, "Nós RPC configurados: " + std::to_string(servers.size()));
+    } else if (!server.empty()) {
         if(server.find("http://") == std::string::npos && server.find("https://") == std::string::npos)
             server = "http://" + server;
         if(server.find("/json_rpc") == std::string::npos)
@@ -112,75 +372,137 @@ int main(int argc, char* argv[]) {
         set_rpc_url(server);
         log_message(g_log_path, "Nenhum servidor RPC definido; usando o padrão.");
     }
+    set_rpc_hedging(hedge);
+    if (config.find("timeout") != config.end()) {
+        set_rpc_timeout(std::stol(config["timeout"]));
+        cout << "Timeout: " << config["timeout"] << "\n";
+        cout << "  (Origem: audit-xmr.cfg)\n";
+    }
+    cout << "Threads: " << thread_count << "\n";
+    cout << "Motor: " << engine;
+    if (engine == "async") cout << " (" << asyncOptions.inflight << " em voo, " << asyncOptions.io_threads << " thread(s) de I/O)";
+    cout << "\n";
+    cout << "Max Retries: " << max_retries << "\n";
+    if (cache) cout << "Cache: " << cache_path << (cache_only ? " (somente cache, sem RPC)" : "") << "\n";
+    if (verify_id) cout << "Verificação de id: sim\n";
+    if (emission_mode) cout << "Modo: emissão pelo CSV (sem RPC, hard forks da mainnet)\n";
+    else if (digest_mode) cout << "Modo: resumo por trechos de " << segment_size << " blocos (fonte " << block_source << ")\n";
     cout << "Log Path: " << g_log_path << "\n";
     cout << "  (Origem: padrão)\n";
     cout << "------------------------\n";
-    cout << "Nota: Configs do audit-xmr.cfg não usadas aqui:\n";
-    if (config.find("threads") != config.end()) {
-        cout << "- Threads: " << config["threads"] << "\n";
-    }
     if (config.find("output_dir") != config.end()) {
+        cout << "Nota: Configs do audit-xmr.cfg não usadas aqui:\n";
         cout << "- Output Dir: " << config["output_dir"] << "\n";
+        cout << "------------------------\n";
     }
-    if (config.find("max_retries") != config.end()) {
-        cout << "- Max Retries: " << config["max_retries"] << "\n";
-    }
-    if (config.find("timeout") != config.end()) {
-        cout << "- Timeout: " << config["timeout"] << "\n";
-    }
-    cout << "------------------------\n\n";
+    cout << "\n";
 
     // Carrega os registros do arquivo CSV
-    if (argc < 2) {
-        cerr << "Uso: " << argv[0] << " <arquivo.csv>" << endl;
+    if (csvFilename.empty()) {
+        cerr << "Uso: " << argv[0] << " [--server <ip[:porta]> | --servers <a,b,...>] [--threads <N>|max] [--engine threads|async] [--log-level <nível>] [--emission] <arquivo.csv>" << endl;
+        cerr << "  --emission: confere a curva de emissão pelo CSV, sem RPC; só para a mainnet (versões pela tabela de hard forks dela)" << endl;
         return 1;
     }
-    string csvFilename = argv[1];
-    ifstream infile(csvFilename);
-    if(!infile.is_open()){
+    MappedFile csvFile;
+    if(!csvFile.open(csvFilename)){
         cerr << "Erro: não foi possível abrir o arquivo " << csvFilename << endl;
         log_message(g_log_path, "Erro: não foi possível abrir o arquivo CSV: " + csvFilename);
         return 1;
     }
 
+    string_view data = csvFile.view();
     vector<CSVRecord> csvRecords;
-    string line;
+    csvRecords.reserve(data.size() / 120); // Linhas têm ~125 bytes
     bool header = true;
-    while(getline(infile, line)){
+    vector<size_t> malformedLines; // Números das linhas (a partir de 1) que não passaram no parse
+    size_t lineNumber = 0;
+    for (size_t pos = 0; pos < data.size(); ) {
+         size_t end = data.find('\n', pos);
+         if (end == string_view::npos) end = data.size();
+         string_view line = data.substr(pos, end - pos);
+         CSVRecord rec;
+         rec.offset = pos;
+         pos = end + 1;
+         lineNumber++;
          if(header) {
-             if(line.find("Altura") != string::npos) {
+             if(line.find("Altura") != string_view::npos) {
                   header = false;
                   continue;
              }
          }
-         CSVRecord rec;
          if(parseCSVLine(line, rec)) {
               csvRecords.push_back(rec);
+         } else if(!line.empty() && line != "\r") {
+              malformedLines.push_back(lineNumber);
          }
     }
-    infile.close();
     log_message(g_log_path, "Arquivo CSV lido com " + std::to_string(csvRecords.size()) + " registros.");
+    if (!malformedLines.empty()) {
+        // Não vão ao nó, mas contam como erro no resumo
+        ostringstream lines;
+        for (size_t k = 0; k < malformedLines.size(); ++k) lines << (k ? ", " : "") << malformedLines[k];
+        cerr << "[AVISO] Linhas malformadas ignoradas (" << malformedLines.size() << "): " << lines.str() << endl;
+        log_message(g_log_path, "[AVISO] Linhas malformadas ignoradas (" + std::to_string(malformedLines.size())
+                    + "): " + lines.str());
+    }
+
+    // Registros em ordem de altura e sem repetição (o CSV do audit-xmr já vem assim)
+    auto byHeight = [](const CSVRecord& a, const CSVRecord& b) { return a.height < b.height; };
+    if (!std::is_sorted(csvRecords.begin(), csvRecords.end(), byHeight)) {
+        std::stable_sort(csvRecords.begin(), csvRecords.end(), byHeight);
+    }
+    auto last = std::unique(csvRecords.begin(), csvRecords.end(),
+                            [](const CSVRecord& a, const CSVRecord& b) { return a.height == b.height; });
+    if (last != csvRecords.end()) {
+        size_t repeated = static_cast<size_t>(csvRecords.end() - last);
+        cerr << "[AVISO] " << repeated << " linha(s) com altura repetida ignorada(s); vale a primeira." << endl;
+        log_message(g_log_path, "[AVISO] " + std::to_string(repeated) + " linha(s) com altura repetida ignorada(s).");
+        csvRecords.erase(last, csvRecords.end());
+    }
+    if (emission_mode) return check_emission_curve(csvRecords, static_cast<unsigned>(thread_count));
+
+    // O escalonador percorre as posições de csvRecords; cada posição vira a
+    // altura do registro. Sem reordenação na saída, a janela cobre tudo.
+    int total = static_cast<int>(csvRecords.size());
+    // Com o cache, cada lote custa um get_block_headers_range para conferir os hashes
+    int batch = cache ? MAX_HEADER_RANGE : std::max(1, chunk_size);
+    BlockScheduler scheduler(0, total - 1, batch, std::max(1, total));
+    auto height_of = [&](int index) { return csvRecords[index].height; };
+    int max_concurrency = engine == "async" ? std::max(1, asyncOptions.inflight) : thread_count;
+    ConcurrencyController controller(std::max(1, max_concurrency / 4), 1, max_concurrency, adaptive);
 
-    int okCount = 0, errorCount = 0;
+    std::atomic<int> okCount(0), errorCount(static_cast<int>(malformedLines.size()));
+    std::mutex coutMutex;
     cout << "------------------------\n";
     cout << "Resultados da Validação\n";
     cout << "------------------------\n";
-    for(const auto& rec : csvRecords) {
-         log_message(g_log_path, "Auditoria do bloco " + std::to_string(rec.height) + " iniciada.");
-         auto auditResultOpt = audit_block(rec.height);
+
+    // Compara o resultado do nó com o registro e imprime só as divergências,
+    // assim que aparecem (fora de ordem quando há várias threads)
+    auto report = [&](int index, const std::optional<AuditResult>& auditResultOpt) {
+         const CSVRecord& rec = csvRecords[index];
          if(!auditResultOpt.has_value()){
-             cout << "Bloco " << setw(6) << rec.height << ": ERRO (falha ao auditar via RPC)\n";
+             {
+                 lock_guard<mutex> lock(coutMutex);
+                 cout << "Bloco " << setw(6) << rec.height << ": ERRO (falha ao auditar via RPC)" << endl;
+             }
              log_message(g_log_path, "Erro: audit_block(" + std::to_string(rec.height) + ") retornou null.");
-             json blockInfo = get_block_info(rec.height);
-             if(blockInfo.is_null()){
-                 log_message(g_log_path, "Debug: get_block(" + std::to_string(rec.height) + ") retornou null.");
-             } else {
-                 log_message(g_log_path, "Debug: get_block(" + std::to_string(rec.height) + ") retornou:\n" + blockInfo.dump(2));
+             if (!cache_only) {
+                 json blockInfo = get_block_info(rec.height);
+                 if(blockInfo.is_null()){
+                     log_message(g_log_path, "Debug: get_block(" + std::to_string(rec.height) + ") retornou null.");
+                 } else {
+                     log_message(g_log_path, "Debug: get_block(" + std::to_string(rec.height) + ") retornou:\n" + blockInfo.dump(2));
+                 }
              }
              errorCount++;
-             continue;
+             return;
          }
-         auto auditResult = auditResultOpt.value();
+         const auto& auditResult = auditResultOpt.value();
+         string_view fields[CSV_FIELDS];
+         split_fields(data.substr(rec.offset, rec.length), fields);
+         string_view csvIssues = fields[5];
+         string_view csvStatus = fields[6];
          bool match = true;
          ostringstream details;
          if(auditResult.real_reward != rec.real_reward) {
@@ -198,26 +520,197 @@ int main(int argc, char* argv[]) {
              details << "TotalMinerado (CSV: " << rec.total_mined
                      << ", RPC: " << auditResult.total_mined << ") ";
          }
-         string csv_issues = (rec.issues == "Nenhum" ? "" : rec.issues);
-         if(auditResult.issues_string() != csv_issues) {
+         string_view issuesCompared = (csvIssues == "Nenhum" ? string_view() : csvIssues);
+         if(auditResult.issues_string() != issuesCompared) {
              match = false;
-             details << "Issues (CSV: " << rec.issues
+             details << "Issues (CSV: " << csvIssues
                      << ", RPC: " << auditResult.issues_string() << ") ";
          }
-         if(auditResult.status != rec.status) {
+         string_view status = status_name(auditResult.status());
+         if(status != csvStatus) {
              match = false;
-             details << "Status (CSV: " << rec.status
-                     << ", RPC: " << auditResult.status << ") ";
+             details << "Status (CSV: " << csvStatus
+                     << ", RPC: " << status << ") ";
          }
          if(match) {
-             cout << "Bloco " << setw(6) << rec.height << ": OK\n";
-             log_message(g_log_path, "Bloco " + std::to_string(rec.height) + " auditado: OK.");
+             LOG_DEBUG(g_log_path, "[DEBUG] Bloco " + std::to_string(rec.height) + " auditado: OK.");
              okCount++;
          } else {
-             cout << "Bloco " << setw(6) << rec.height << ": ERRO (" << details.str() << ")\n";
+             {
+                 lock_guard<mutex> lock(coutMutex);
+                 cout << "Bloco " << setw(6) << rec.height << ": ERRO (" << details.str() << ")" << endl;
+             }
              log_message(g_log_path, "Bloco " + std::to_string(rec.height) + " auditado: ERRO (" + details.str() + ").");
              errorCount++;
          }
+    };
+
+    if (total > 0 && digest_mode) {
+        // Cada trecho de segment_size alturas é buscado em lote e comparado
+        // pela soma dos resumos das linhas. Só os trechos divergentes são
+        // bissectados, com somas de prefixo, até as linhas erradas.
+        BlockCache::RangeFetch fetch_range;
+        if (block_source == "batch") fetch_range = get_blocks_fields_batch;
+        else fetch_range = get_blocks_fields_bin;
+        if (cache) {
+            BlockCache::RangeFetch source = fetch_range;
+            fetch_range = [&, source](int a, int b, std::vector<BlockFields>& out) {
+                return cache->fetch(a, b, source, out);
+            };
+        }
+        int first_segment = csvRecords.front().height / segment_size;
+        int last_segment = csvRecords.back().height / segment_size;
+        BlockScheduler segments(first_segment, last_segment, 1, last_segment - first_segment + 1);
+        std::atomic<int> segmentsOk(0), segmentsBisected(0);
+
+        auto check_segment = [&](int segment) {
+            auto lo = std::lower_bound(csvRecords.begin(), csvRecords.end(), segment * segment_size,
+                                       [](const CSVRecord& r, int h) { return r.height < h; });
+            auto hi = std::lower_bound(lo, csvRecords.end(), (segment + 1) * segment_size,
+                                       [](const CSVRecord& r, int h) { return r.height < h; });
+            if (lo == hi) return;
+            int first = static_cast<int>(lo - csvRecords.begin());
+            int count = static_cast<int>(hi - lo);
+            int from = lo->height, to = (hi - 1)->height;
+
+            std::vector<BlockFields> fields;
+            bool fetched = false;
+            for (int attempt = 0; ; ++attempt) {
+                controller.acquire();
+                auto t0 = std::chrono::steady_clock::now();
+                fetched = fetch_range(from, to, fields);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                controller.release(fetched, ms);
+                if (fetched || attempt >= max_retries) break;
+                std::this_thread::sleep_for(backoff_delay(attempt + 1));
+            }
+            if (!fetched && cache_only) {
+                for (int i = first; i < first + count; ++i) report(i, std::nullopt);
+                return;
+            }
+            if (!fetched) {
+                log_message(g_log_path, "[AVISO] Falha na busca em lote de " + std::to_string(from) + " a "
+                            + std::to_string(to) + "; conferindo bloco a bloco");
+                for (int i = first; i < first + count; ++i) report(i, audit_block(csvRecords[i].height));
+                return;
+            }
+
+            // Somas de prefixo dos resumos: CSV e nó, na ordem das linhas do trecho
+            std::vector<AuditResult> node(count);
+            std::vector<uint64_t> csvPrefix(count + 1, 0), nodePrefix(count + 1, 0);
+            for (int k = 0; k < count; ++k) {
+                const CSVRecord& rec = csvRecords[first + k];
+                string_view f[CSV_FIELDS];
+                split_fields(data.substr(rec.offset, rec.length), f);
+                csvPrefix[k + 1] = csvPrefix[k] + row_digest(rec.height, f[1], rec.real_reward, rec.coinbase_outputs,
+                                                             rec.total_mined, f[5], f[6]);
+                node[k] = audit_fields(rec.height, fields[rec.height - from]);
+                const AuditResult& r = node[k];
+                std::string issues = r.issues_string();
+                nodePrefix[k + 1] = nodePrefix[k] + row_digest(r.height, r.hash_hex(), r.real_reward, r.coinbase_outputs,
+                                                               r.total_mined, issues, status_name(r.status()));
+            }
+            if (csvPrefix[count] == nodePrefix[count]) {
+                okCount += count;
+                segmentsOk++;
+                return;
+            }
+
+            segmentsBisected++;
+            LOG_DEBUG(g_log_path, "[DEBUG] Trecho " + std::to_string(from) + ".." + std::to_string(to) + " diverge; bissectando");
+            int matched = count;
+            std::function<void(int, int)> bisect = [&](int l, int r) { // Linhas [l, r)
+                if (csvPrefix[r] - csvPrefix[l] == nodePrefix[r] - nodePrefix[l]) return;
+                if (r - l == 1) {
+                    matched--;
+                    report(first + l, node[l]);
+                    return;
+                }
+                int m = l + (r - l) / 2;
+                bisect(l, m);
+                bisect(m, r);
+            };
+            bisect(0, count);
+            okCount += matched;
+        };
+
+        auto worker = [&]() {
+            BlockScheduler::Cursor cursor;
+            int from = 0, to = -1;
+            while (segments.next(cursor, from, to)) {
+                for (int segment = from; segment <= to; ++segment) check_segment(segment);
+            }
+        };
+        vector<thread> threads;
+        for (int i = 0; i < thread_count; ++i) threads.emplace_back(worker);
+        for (auto& t : threads) t.join();
+        std::stringstream ss;
+        ss << "Trechos: " << segmentsOk << " conferidos pelo resumo, " << segmentsBisected << " bissectados";
+        cout << ss.str() << "\n";
+        log_message(g_log_path, "[INFO] " + ss.str());
+    } else if (total > 0 && engine == "async") {
+        asyncOptions.cpu_threads = thread_count;
+        asyncOptions.max_retries = max_retries;
+        asyncOptions.controller = &controller;
+        asyncOptions.height_of = height_of;
+        run_async_engine(scheduler, asyncOptions, [&](int height, std::optional<AuditResult> res) {
+            // Os resultados chegam com a altura; a posição sai da busca nos registros ordenados
+            auto it = std::lower_bound(csvRecords.begin(), csvRecords.end(), height,
+                                       [](const CSVRecord& r, int h) { return r.height < h; });
+            report(static_cast<int>(it - csvRecords.begin()), res);
+        });
+    } else if (total > 0) {
+        // Mesmo esquema do audit-xmr: cada thread reserva lotes do escalonador
+        // e repete com backoff os blocos que falharem
+        auto worker = [&]() {
+            BlockScheduler::Cursor cursor;
+            int from = 0, to = -1;
+            std::vector<BlockFields> fields;
+            while (scheduler.next(cursor, from, to, cache ? batch : 1)) {
+                if (cache) {
+                    // O lote inteiro pelo cache; só as alturas ausentes vão ao nó
+                    int first = height_of(from), last = height_of(to);
+                    bool fetched = false;
+                    for (int attempt = 0; ; ++attempt) {
+                        controller.acquire();
+                        auto t0 = std::chrono::steady_clock::now();
+                        fetched = cache->fetch(first, last, get_blocks_fields_json, fields);
+                        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                        controller.release(fetched, ms);
+                        if (fetched || attempt >= max_retries) break;
+                        std::this_thread::sleep_for(backoff_delay(attempt + 1));
+                    }
+                    if (fetched || cache_only) {
+                        for (int i = from; i <= to; ++i) {
+                            int h = height_of(i);
+                            if (fetched) report(i, audit_fields(h, fields[h - first]));
+                            else report(i, std::nullopt);
+                        }
+                        continue;
+                    }
+                    log_message(g_log_path, "[AVISO] Falha na busca pelo cache de " + std::to_string(first) + " a "
+                                + std::to_string(last) + "; conferindo bloco a bloco");
+                }
+                for (int i = from; i <= to; ++i) {
+                    int h = height_of(i);
+                    LOG_DEBUG(g_log_path, "[DEBUG] Auditoria do bloco " + std::to_string(h) + " iniciada.");
+                    std::optional<AuditResult> res;
+                    for (int attempt = 0; ; ++attempt) {
+                        controller.acquire();
+                        auto t0 = std::chrono::steady_clock::now();
+                        res = audit_block(h);
+                        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                        controller.release(res.has_value(), ms);
+                        if (res.has_value() || attempt >= max_retries) break;
+                        std::this_thread::sleep_for(backoff_delay(attempt + 1));
+                    }
+                    report(i, res);
+                }
+            }
+        };
+        vector<thread> threads;
+        for (int i = 0; i < thread_count; ++i) threads.emplace_back(worker);
+        for (auto& t : threads) t.join();
     }
 
     cout << "------------------------\n";
@@ -225,6 +718,24 @@ int main(int argc, char* argv[]) {
     cout << "------------------------\n";
     cout << "Blocos OK:       " << setw(6) << okCount << "\n";
     cout << "Blocos com erro: " << setw(6) << errorCount << "\n";
+    if (!malformedLines.empty()) cout << "  dos quais linhas malformadas: " << malformedLines.size() << "\n";
+    RpcStats rpcStats = get_rpc_stats();
+    size_t checked = csvRecords.size();
+    cout << "Requisições RPC: " << setw(6) << rpcStats.requests << "\n";
+    cout << "Conexões TCP:    " << setw(6) << rpcStats.connects << " ("
+         << fixed << setprecision(2) << (checked ? rpcStats.connects * 1000.0 / checked : 0.0)
+         << " por 1k blocos)\n";
+    if (cache) {
+        CacheStats cs = cache->stats();
+        cout << "Cache:           " << setw(6) << cs.hits << " acertos, " << cs.misses << " ausentes, "
+             << cs.stale << " reorganizados\n";
+    }
+    if (rpc_node_count() > 1) {
+        for (const auto& n : get_rpc_node_stats()) {
+            cout << "Nó " << n.url << ": " << n.requests << " requisições, " << n.failures << " falhas, p95 "
+                 << setprecision(1) << n.p95_ms << " ms, " << n.hedges << " duplicados (" << n.hedges_won << " vencidos)\n";
+        }
+    }
     cout << "------------------------\n";
     log_message(g_log_path, "Resumo: " + std::to_string(okCount) + " blocos OK, " + std::to_string(errorCount) + " blocos com discrepâncias.");
     log_message(g_log_path, "Validação via RPC finalizada.");
@@ -0,0 +1,419 @@
+// audit-xmr-merge.cpp
+// Junta os CSVs das partes de uma auditoria dividida (audit-xmr --shard i/N)
+// em um único auditoria_monero.csv, em ordem de altura. As entradas são lidas
+// mapeadas em memória e intercaladas por altura, sem carregar as linhas.
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include "block_binary.hpp"
+#include "mapped_file.hpp"
+#include "shard.hpp"
+#include "state.hpp"
+
+#if __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+
+namespace {
+
+// Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status[,Taxas,MoedasGeradas]
+const int CSV_FIELDS = 9;
+
+struct Input {
+    std::string csv_path;
+    std::optional<ShardManifest> manifest;
+    MappedFile file;
+    std::string_view data;
+    std::string_view header;
+    size_t pos = 0;          // Início da próxima linha
+    std::string_view line;   // Linha atual, sem o '\n'
+    int height = -1;         // Altura da linha atual
+    int previous = -1;       // Altura da linha anterior desta entrada
+    uint64_t rows = 0;
+    uint64_t out_of_order = 0;
+    uint64_t invalid = 0;
+};
+
+bool parse_height(std::string_view line, int& height) {
+    size_t comma = line.find(',');
+    if (comma == std::string_view::npos || comma == 0) return false;
+    auto res = std::from_chars(line.data(), line.data() + comma, height);
+    return res.ec == std::errc() && res.ptr == line.data() + comma && height >= 0;
+}
+
+// Avança até a próxima linha válida em ordem crescente; false no fim
+bool next_line(Input& in) {
+    while (in.pos < in.data.size()) {
+        size_t end = in.data.find('\n', in.pos);
+        if (end == std::string_view::npos) end = in.data.size();
+        std::string_view line = in.data.substr(in.pos, end - in.pos);
+        in.pos = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        int height;
+        if (!parse_height(line, height)) {
+            in.invalid++;
+            continue;
+        }
+        if (height <= in.previous) {
+            // O audit-xmr grava cada parte em ordem; fora disso a linha não entra
+            if (in.out_of_order++ == 0) {
+                std::cerr << "[AVISO] " << in.csv_path << ": altura " << height << " depois de "
+                          << in.previous << " (fora de ordem); linha ignorada.\n";
+            }
+            continue;
+        }
+        in.line = line;
+        in.height = height;
+        in.previous = height;
+        in.rows++;
+        return true;
+    }
+    return false;
+}
+
+bool split_fields(std::string_view line, std::string_view (&fields)[CSV_FIELDS], int& count) {
+    size_t start = 0;
+    count = 0;
+    while (count < CSV_FIELDS) {
+        size_t comma = line.find(',', start);
+        fields[count++] = line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start);
+        if (comma == std::string_view::npos) return true;
+        start = comma + 1;
+    }
+    return false;
+}
+
+template <typename T>
+bool parse_number(std::string_view field, T& value) {
+    auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+    return res.ec == std::errc() && res.ptr == field.data() + field.size();
+}
+
+// Alturas faltantes, guardadas como intervalos
+struct Gap {
+    int first;
+    int last;
+};
+
+std::string format_gaps(const std::vector<Gap>& gaps, size_t limit = 20) {
+    std::string list;
+    for (size_t i = 0; i < gaps.size() && i < limit; ++i) {
+        if (!list.empty()) list += ", ";
+        list += std::to_string(gaps[i].first);
+        if (gaps[i].last > gaps[i].first) list += "-" + std::to_string(gaps[i].last);
+    }
+    if (gaps.size() > limit) list += ", ... (+" + std::to_string(gaps.size() - limit) + ")";
+    return list;
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Uso: " << argv0 << " [--output <arquivo.csv>] <parte.manifest | parte.csv | diretório> ...\n"
+              << "  Diretórios entram com todos os manifestos *.manifest que contêm.\n"
+              << "  Padrão da saída: auditoria_monero.csv no diretório da primeira entrada.\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            return 0;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Entradas: manifestos (o CSV fica ao lado), diretórios com manifestos ou CSVs soltos
+    std::vector<std::unique_ptr<Input>> inputs;
+    bool failed = false;
+    auto add_manifest = [&](const fs::path& path) {
+        ShardManifest manifest;
+        std::string error;
+        if (!load_shard_manifest(path.string(), manifest, &error)) {
+            std::cerr << "[ERRO] Manifesto " << path.string() << " inválido: " << error << "\n";
+            failed = true;
+            return;
+        }
+        std::unique_ptr<Input> in(new Input);
+        in->csv_path = (path.parent_path() / manifest.csv).string();
+        in->manifest = manifest;
+        inputs.push_back(std::move(in));
+    };
+    for (const auto& arg : args) {
+        fs::path path(arg);
+        if (fs::is_directory(path)) {
+            std::vector<fs::path> found;
+            for (const auto& entry : fs::directory_iterator(path)) {
+                if (entry.path().extension() == ".manifest") found.push_back(entry.path());
+            }
+            if (found.empty()) {
+                std::cerr << "[ERRO] Nenhum manifesto em " << arg << "\n";
+                failed = true;
+            }
+            std::sort(found.begin(), found.end());
+            for (const auto& p : found) add_manifest(p);
+        } else if (path.extension() == ".manifest") {
+            add_manifest(path);
+        } else {
+            std::unique_ptr<Input> in(new Input);
+            in->csv_path = arg;
+            inputs.push_back(std::move(in));
+        }
+    }
+    if (failed) return 1;
+
+    // Manifestos precisam descrever a mesma divisão, sem partes repetidas
+    int shard_count = 0, span = 0, range_start = -1, range_end = -1;
+    std::vector<int> seen;
+    std::vector<int> failed_heights;
+    for (const auto& in : inputs) {
+        if (!in->manifest) continue;
+        const ShardManifest& m = *in->manifest;
+        if (shard_count == 0) {
+            shard_count = m.count;
+            span = m.span;
+            range_start = m.start;
+            range_end = m.end;
+        } else if (m.count != shard_count || m.span != span || m.start != range_start || m.end != range_end) {
+            std::cerr << "[ERRO] A parte " << m.index << "/" << m.count << " (intervalo " << m.start << "-" << m.end
+                      << ") não é da mesma divisão que as demais (" << shard_count << " partes, intervalo "
+                      << range_start << "-" << range_end << ").\n";
+            return 1;
+        }
+        if (std::find(seen.begin(), seen.end(), m.index) != seen.end()) {
+            std::cerr << "[ERRO] Parte " << m.index << "/" << m.count << " repetida.\n";
+            return 1;
+        }
+        seen.push_back(m.index);
+        failed_heights.insert(failed_heights.end(), m.failed.begin(), m.failed.end());
+    }
+    if (shard_count > 0 && static_cast<int>(seen.size()) < shard_count) {
+        std::string missing;
+        for (int i = 1; i <= shard_count; ++i) {
+            if (std::find(seen.begin(), seen.end(), i) != seen.end()) continue;
+            if (!missing.empty()) missing += ", ";
+            missing += std::to_string(i) + "/" + std::to_string(shard_count);
+        }
+        std::cerr << "[AVISO] Partes ausentes: " << missing << "; as alturas delas aparecem como lacunas.\n";
+    }
+
+    for (auto& in : inputs) {
+        if (!in->file.open(in->csv_path)) {
+            std::cerr << "[ERRO] Não foi possível abrir o CSV " << in->csv_path << "\n";
+            return 1;
+        }
+        in->data = in->file.view();
+        size_t end = in->data.find('\n');
+        std::string_view first = in->data.substr(0, end == std::string_view::npos ? in->data.size() : end);
+        if (first.find("Altura") != std::string_view::npos) {
+            in->header = first;
+            in->pos = end == std::string_view::npos ? in->data.size() : end + 1;
+        }
+    }
+    std::string_view header = "Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status,Taxas,MoedasGeradas";
+    for (const auto& in : inputs) {
+        if (in->header.empty()) continue;
+        if (in->header != inputs.front()->header && !inputs.front()->header.empty()) {
+            std::cerr << "[AVISO] " << in->csv_path << " tem outro cabeçalho; vale o de " << inputs.front()->csv_path << ".\n";
+        }
+    }
+    if (!inputs.front()->header.empty()) header = inputs.front()->header;
+    if (!header.empty() && header.back() == '\r') header.remove_suffix(1);
+
+    if (output.empty()) output = (fs::path(inputs.front()->csv_path).parent_path() / "auditoria_monero.csv").string();
+    for (const auto& in : inputs) {
+        if (fs::exists(output) && fs::equivalent(output, in->csv_path)) {
+            std::cerr << "[ERRO] A saída " << output << " é uma das entradas.\n";
+            return 1;
+        }
+    }
+    std::string tmp_output = output + ".tmp";
+    std::ofstream out(tmp_output, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "[ERRO] Não foi possível criar " << tmp_output << "\n";
+        return 1;
+    }
+    std::vector<char> out_buffer(1 << 20);
+    out.rdbuf()->pubsetbuf(out_buffer.data(), static_cast<std::streamsize>(out_buffer.size()));
+    out << header << '\n';
+    uint64_t out_bytes = header.size() + 1;
+
+    // Intercalação: a menor altura entre as linhas atuais de cada entrada
+    auto later = [&](size_t a, size_t b) {
+        return inputs[a]->height != inputs[b]->height ? inputs[a]->height > inputs[b]->height : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (next_line(*inputs[i])) heap.push(i);
+    }
+
+    // Com a saída começando na altura 0 e sem lacunas, o estado da auditoria
+    // é refeito junto, para o audit-xmr retomar do fim da saída
+    AuditState state((fs::path(output).parent_path() / "audit_state.txt").string());
+    bool track_state = true;
+    state.reset();
+
+    std::vector<Gap> gaps;
+    int expected = range_start >= 0 ? range_start : -1;
+    int first_height = -1, last_height = -1;
+    std::string_view last_line;
+    uint64_t rows = 0, discrepancies = 0, overlaps = 0, divergent = 0, malformed = 0;
+    uint64_t supply = 0, fees = 0;
+    bool fees_known = true;
+    // As partes só sabem as moedas geradas no primeiro trecho de cada uma
+    // (--fees reinicia a conta nos demais); enquanto a saída vem da altura 0
+    // sem lacunas e com as taxas, a coluna MoedasGeradas é refeita aqui
+    bool generated_exact = true;
+    uint64_t generated_filled = 0;
+    std::string rewritten;
+    while (!heap.empty()) {
+        size_t i = heap.top();
+        heap.pop();
+        Input& in = *inputs[i];
+        std::string_view line = in.line;
+        int height = in.height;
+        if (next_line(in)) heap.push(i);
+
+        if (height == last_height) {
+            // Sobreposição: fica a primeira linha; uma segunda diferente é relatada
+            overlaps++;
+            if (line != last_line && divergent++ < 10) {
+                std::cerr << "[AVISO] Altura " << height << " repetida com conteúdo diferente em " << in.csv_path << "\n";
+            }
+            continue;
+        }
+        std::string_view fields[CSV_FIELDS];
+        int count = 0;
+        uint64_t coinbase = 0, block_fees = 0;
+        Hash32 hash;
+        if (!split_fields(line, fields, count) || count < 7 || !parse_number(fields[3], coinbase) ||
+            !hash_from_hex(std::string(fields[1]), hash)) {
+            malformed++;
+            continue;
+        }
+        if (expected < 0) expected = height;
+        if (height > expected) {
+            gaps.push_back({ expected, height - 1 });
+            track_state = false;
+        }
+        if (rows == 0) {
+            first_height = height;
+            track_state = track_state && height == 0;
+        }
+        expected = height + 1;
+
+        bool has_fees = count == CSV_FIELDS && !fields[7].empty() && parse_number(fields[7], block_fees);
+        supply += coinbase;
+        if (has_fees) {
+            fees += block_fees;
+        } else {
+            fees_known = false;
+        }
+        generated_exact = generated_exact && track_state && has_fees && block_fees <= coinbase;
+        std::string_view written = line;
+        if (generated_exact) {
+            // Taxas é o penúltimo campo: troca só o que vem depois da última vírgula
+            std::string generated = std::to_string(supply - fees);
+            if (fields[8] != generated) {
+                if (fields[8].empty()) generated_filled++;
+                rewritten.assign(line.data(), static_cast<size_t>(fields[8].data() - line.data()));
+                rewritten += generated;
+                written = rewritten;
+            }
+        }
+        out << written << '\n';
+        out_bytes += written.size() + 1;
+        last_height = height;
+        last_line = line;
+        rows++;
+        if (fields[6] != "OK") discrepancies++;
+        if (track_state) {
+            state.extend(height, hash, coinbase, out_bytes, has_fees ? std::optional<uint64_t>(block_fees) : std::nullopt);
+        }
+    }
+    if (range_end >= 0 && expected <= range_end) {
+        gaps.push_back({ expected, range_end });
+        track_state = false;
+    }
+
+    out.flush();
+    if (!out) {
+        std::cerr << "[ERRO] Falha ao gravar " << tmp_output << "\n";
+        return 1;
+    }
+    out.close();
+    if (std::rename(tmp_output.c_str(), output.c_str()) != 0) {
+        std::cerr << "[ERRO] Não foi possível renomear " << tmp_output << " para " << output << "\n";
+        return 1;
+    }
+
+    std::cout << "------------------------\n";
+    std::cout << "Junção Concluída\n";
+    std::cout << "------------------------\n";
+    for (const auto& in : inputs) {
+        std::cout << in->csv_path << ": " << in->rows << " linhas";
+        if (in->manifest) {
+            std::cout << " (parte " << in->manifest->index << "/" << in->manifest->count;
+            if (in->manifest->rows != in->rows) std::cout << ", manifesto indica " << in->manifest->rows;
+            std::cout << ")";
+        }
+        if (in->out_of_order) std::cout << ", " << in->out_of_order << " fora de ordem";
+        if (in->invalid) std::cout << ", " << in->invalid << " inválidas";
+        std::cout << "\n";
+    }
+    std::cout << "Resultados salvos em: " << output << "\n";
+    std::cout << "Blocos: " << rows;
+    if (rows > 0) std::cout << " (alturas " << first_height << " a " << last_height << ")";
+    std::cout << "\n";
+    std::cout << "Discrepâncias: " << discrepancies << "\n";
+    std::cout << "Supply (soma de CoinbaseOutputs): " << supply << "\n";
+    if (fees_known && rows > 0) std::cout << "Taxas: " << fees << "\n";
+    if (generated_filled) std::cout << "MoedasGeradas preenchidas: " << generated_filled << " linhas\n";
+    if (overlaps) std::cout << "Alturas repetidas entre entradas: " << overlaps << " (" << divergent << " com conteúdo diferente)\n";
+    if (malformed) std::cout << "Linhas malformadas ignoradas: " << malformed << "\n";
+    if (!failed_heights.empty()) {
+        std::cout << "Blocos com falha definitiva nas partes (" << failed_heights.size() << "): "
+                  << format_height_ranges(failed_heights) << "\n";
+    }
+    if (!gaps.empty()) {
+        uint64_t missing = 0;
+        for (const auto& g : gaps) missing += static_cast<uint64_t>(g.last - g.first + 1);
+        std::cout << "Lacunas (" << missing << " blocos): " << format_gaps(gaps) << "\n";
+    }
+
+    if (track_state && rows > 0) {
+        std::string error;
+        if (state.save(&error)) {
+            std::cout << "Estado salvo em " << state.path() << " (retomada após o bloco " << state.tip().height << ")\n";
+        } else {
+            std::cerr << "[ERRO] Falha ao salvar o estado " << state.path() << ": " << error << "\n";
+        }
+    }
+    std::cout << "------------------------\n";
+
+    bool complete = gaps.empty() && failed_heights.empty() && divergent == 0 && malformed == 0;
+    for (const auto& in : inputs) complete = complete && in->out_of_order == 0;
+    return complete ? 0 : 2;
+}
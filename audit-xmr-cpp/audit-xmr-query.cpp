@@ -0,0 +1,152 @@
+// audit-xmr-query.cpp
+// Consultas ao arquivo colunar do audit-xmr (auditoria_monero.xmrc): supply e
+// taxas de um intervalo, lista de discrepâncias e busca de um bloco, além da
+// conversão de e para o CSV.
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include "columnar.hpp"
+
+// Usado pelo log de audit.cpp e csv_writer.cpp
+std::string g_log_path = "audit_query.log";
+
+namespace {
+
+void usage(const char* argv0) {
+    std::cerr << "Uso: " << argv0 << " <arquivo.xmrc> <consulta>\n"
+              << "  info                       Alturas, linhas e totais do arquivo\n"
+              << "  supply <de> <até>          Soma de CoinbaseOutputs, taxas e emissão no intervalo\n"
+              << "  discrepancies [<de> <até>] Blocos com algum problema\n"
+              << "  block <altura>             Linha de um bloco\n"
+              << "Conversões:\n"
+              << "  " << argv0 << " --from-csv <entrada.csv> <saída.xmrc>\n"
+              << "  " << argv0 << " --to-csv <entrada.xmrc> <saída.csv>\n";
+}
+
+bool parse_height(const char* text, int& height) {
+    try {
+        size_t used = 0;
+        height = std::stoi(text, &used);
+        return text[used] == '\0' && height >= 0;
+    } catch (...) {
+        return false;
+    }
+}
+
+void print_row(const AuditBatch& rows, size_t i) {
+    AuditResult r;
+    r.issues = rows.issues[i];
+    std::cout << rows.height[i] << "," << to_hex(rows.hash[i].data(), rows.hash[i].size()) << ","
+              << rows.real_reward[i] << "," << rows.coinbase_outputs[i] << "," << r.issues_string() << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string first = argv[1];
+    if (first == "--from-csv" || first == "--to-csv") {
+        if (argc != 4) {
+            usage(argv[0]);
+            return 1;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        std::string error;
+        uint64_t rows = 0;
+        bool ok = first == "--from-csv" ? csv_to_columnar(argv[2], argv[3], &error, &rows)
+                                        : columnar_to_csv(argv[2], argv[3], &error, &rows);
+        if (!ok) {
+            std::cerr << "[ERRO] Conversão de " << argv[2] << " falhou: " << error << "\n";
+            return 1;
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << rows << " linhas convertidas para " << argv[3] << " em " << std::fixed << std::setprecision(2)
+                  << s << " s\n";
+        return 0;
+    }
+
+    ColumnarFile file;
+    std::string error;
+    if (!file.open(first, &error)) {
+        std::cerr << "[ERRO] Não foi possível abrir " << first << ": " << error << "\n";
+        return 1;
+    }
+    std::string query = argv[2];
+    auto t0 = std::chrono::steady_clock::now();
+    auto elapsed_us = [&] {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    };
+    int status = 0;
+
+    if (query == "info" && argc == 3) {
+        ColumnarSums s = file.sums(0, file.last_height());
+        std::cout << "Linhas: " << file.rows() << " (alturas " << file.first_height() << " a " << file.last_height()
+                  << ", " << file.block_count() << " blocos de " << COLUMNAR_BLOCK_ROWS << ")\n";
+        std::cout << "Supply (soma de CoinbaseOutputs): " << s.supply << "\n";
+        if (s.fees_unknown == 0) std::cout << "Taxas: " << s.fees << "\n";
+        std::cout << "Discrepâncias: " << s.discrepancies << "\n";
+    } else if (query == "supply" && argc == 5) {
+        int from, to;
+        if (!parse_height(argv[3], from) || !parse_height(argv[4], to) || to < from) {
+            std::cerr << "[ERRO] Intervalo inválido.\n";
+            return 1;
+        }
+        ColumnarSums s = file.sums(from, to);
+        uint64_t expected = static_cast<uint64_t>(to) - static_cast<uint64_t>(from) + 1;
+        std::cout << "Blocos: " << s.rows;
+        if (s.rows != expected) std::cout << " (" << expected - s.rows << " ausentes no arquivo)";
+        std::cout << "\n";
+        std::cout << "Supply (soma de CoinbaseOutputs): " << s.supply << "\n";
+        if (s.fees_unknown == 0) {
+            std::cout << "Taxas: " << s.fees << "\n";
+            std::cout << "Emissão (supply - taxas): " << s.supply - s.fees << "\n";
+        } else {
+            std::cout << "Taxas: desconhecidas em " << s.fees_unknown << " blocos (audite com --fees)\n";
+        }
+        std::cout << "Discrepâncias: " << s.discrepancies << "\n";
+    } else if (query == "discrepancies" && (argc == 3 || argc == 5)) {
+        int from = 0, to = file.last_height();
+        if (argc == 5 && (!parse_height(argv[3], from) || !parse_height(argv[4], to))) {
+            std::cerr << "[ERRO] Intervalo inválido.\n";
+            return 1;
+        }
+        AuditBatch rows;
+        if (!file.discrepancies(from, to, rows)) {
+            std::cerr << "[ERRO] Arquivo corrompido.\n";
+            return 1;
+        }
+        std::cout << "Altura,Hash,RecompensaReal,CoinbaseOutputs,Problemas\n";
+        for (size_t i = 0; i < rows.size(); ++i) print_row(rows, i);
+        std::cout << rows.size() << " blocos com discrepância\n";
+    } else if (query == "block" && argc == 4) {
+        int height;
+        AuditResult r;
+        if (!parse_height(argv[3], height)) {
+            std::cerr << "[ERRO] Altura inválida.\n";
+            return 1;
+        }
+        if (file.find(height, r)) {
+            std::cout << "Altura: " << r.height << "\n"
+                      << "Hash: " << r.hash_hex() << "\n"
+                      << "RecompensaReal: " << r.real_reward << "\n"
+                      << "CoinbaseOutputs: " << r.coinbase_outputs << "\n"
+                      << "TotalMinerado: " << r.total_mined << "\n"
+                      << "Problemas: " << (r.issues ? r.issues_string() : "Nenhum") << "\n"
+                      << "Status: " << status_name(r.status()) << "\n";
+            if (r.fees) std::cout << "Taxas: " << *r.fees << "\n";
+            if (r.generated_after) std::cout << "MoedasGeradas: " << *r.generated_after << "\n";
+        } else {
+            std::cout << "Bloco " << height << " não está no arquivo\n";
+            status = 2;
+        }
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+    std::cerr << "Consulta em " << std::fixed << std::setprecision(1) << elapsed_us() << " µs\n";
+    return status;
+}
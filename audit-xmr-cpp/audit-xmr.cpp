@@ -2,6 +2,22 @@
 #include "audit.hpp"
 #include "rpc.hpp"
 #include "log.hpp"
+#include "scheduler.hpp"
+#include "engine.hpp"
+#include "controller.hpp"
+#include "csv_writer.hpp"
+#include "progress.hpp"
+#include "state.hpp"
+#include "lmdb_source.hpp"
+#include "raw_source.hpp"
+#include "block_cache.hpp"
+#include "nodes.hpp"
+#include "emission.hpp"
+#include "shard.hpp"
+#include "columnar.hpp"
+#include "keccak.hpp"
+#include "linkage.hpp"
+#include "follow.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -21,15 +37,21 @@
     namespace fs = std::experimental::filesystem;
 #endif
 #include <map>
+#include <memory>
+#include <functional>
 #include <chrono>
 #include <iomanip>
-#include <condition_variable>
+#include <csignal>
 
 #define VER "0.1"
 
 std::string g_log_path;
-std::mutex cout_mutex; // Para sincronizar saída no terminal
 std::atomic<int> blocks_written(0); // Contador global de blocos escritos
+std::atomic<bool> g_stop(false);     // SIGINT/SIGTERM no --follow
+
+static void on_stop_signal(int) {
+    g_stop = true;
+}
 
 std::map<std::string, std::string> load_config(const std::string& config_file) {
     std::map<std::string, std::string> config;
@@ -57,22 +79,6 @@ std::map<std::string, std::string> load_config(const std::string& config_file) {
     return config;
 }
 
-// Função para exibir a barra de progresso
-void print_progress(int current, int total) {
-    const int bar_width = 20;
-    float progress = (float)current / total;
-    int pos = bar_width * progress;
-
-    std::lock_guard<std::mutex> lock(cout_mutex);
-    std::cout << "\rProgresso: [";
-    for (int i = 0; i < bar_width; ++i) {
-        if (i < pos) std::cout << "=";
-        else if (i == pos) std::cout << ">";
-        else std::cout << " ";
-    }
-    std::cout << "] " << int(progress * 100.0) << "% (" << current << "/" << total << ")" << std::flush;
-}
-
 int main(int argc, char* argv[]) {
     std::string config_file = "audit-xmr.cfg";
     auto config = load_config(config_file);
@@ -91,13 +97,49 @@ int main(int argc, char* argv[]) {
         rpc_url = "http://127.0.0.1:18081/json_rpc";
     }
 
+    // Vários nós: balanceamento por latência, duplicado após o p95 e quórum opcional
+    std::vector<std::string> servers = config.count("servers") ? parse_server_list(config["servers"])
+                                                               : std::vector<std::string>();
+    bool hedge = !config.count("hedge") || config["hedge"] != "0";
+    bool quorum = config.count("quorum") && config["quorum"] == "1";
+
     int user_thread_count = config.count("threads") ? std::stoi(config["threads"]) : 1;
     std::string output_dir = config.count("output_dir") ? config["output_dir"] : "out";
+    int chunk_size = config.count("chunk_size") ? std::stoi(config["chunk_size"]) : 16;
+    std::string log_level = config.count("log_level") ? config["log_level"] : "info";
+    bool validate_parse = config.count("validate_parse") && config["validate_parse"] == "1";
+    std::string block_source = config.count("block_source") ? config["block_source"] : "json";
+    int batch_size = config.count("batch_size") ? std::stoi(config["batch_size"]) : MAX_HEADER_RANGE;
+    int tx_batch_size = config.count("tx_batch_size") ? std::stoi(config["tx_batch_size"]) : MAX_TX_BATCH;
+    std::string engine = config.count("engine") ? config["engine"] : "threads";
+    int max_retries = config.count("max_retries") ? std::stoi(config["max_retries"]) : 3;
+    bool adaptive = !config.count("adaptive") || config["adaptive"] != "0";
+    std::string csv_sync = config.count("csv_sync") ? config["csv_sync"] : "close";
+    std::string lmdb_path = config.count("lmdb_path") ? config["lmdb_path"]
+                          : std::string(std::getenv("HOME") ? std::getenv("HOME") : ".") + "/.bitmonero/lmdb";
+    std::string raw_path = config.count("raw_path") ? config["raw_path"] : "blockchain.raw";
+    std::string cache_path = config.count("cache_path") ? config["cache_path"] : "";
+    bool cache_only = config.count("cache_only") && config["cache_only"] == "1";
+    bool fee_audit = config.count("fee_audit") && config["fee_audit"] == "1";
+    // Recalcula o id de cada bloco a partir do blob e compara com o hash do nó
+    bool verify_id = config.count("verify_id") && config["verify_id"] == "1";
+    // Cópia colunar do CSV (auditoria_monero.xmrc) para o audit-xmr-query
+    bool columnar = config.count("columnar") && config["columnar"] == "1";
+    // Depois da auditoria completa, continua auditando cada bloco novo
+    bool follow = config.count("follow") && config["follow"] == "1";
+    std::string zmq_endpoint = config.count("zmq_endpoint") ? config["zmq_endpoint"] : "";
+    int poll_ms = config.count("follow_poll_ms") ? std::stoi(config["follow_poll_ms"]) : 1000;
+    // Parte de uma auditoria dividida entre processos: "i/N"
+    std::string shard = config.count("shard") ? config["shard"] : "";
+    AsyncEngineOptions async_options;
+    if (config.count("inflight")) async_options.inflight = std::stoi(config["inflight"]);
+    if (config.count("io_threads")) async_options.io_threads = std::stoi(config["io_threads"]);
 
     int start_block = -1;
     int end_block = -1;
     int single_block = -1;
     bool args_specified = false;
+    bool fresh = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -124,15 +166,104 @@ int main(int argc, char* argv[]) {
             } else {
                 rpc_url = "http://" + server + ":18081/json_rpc";
             }
+            servers.clear();
+        } else if (arg == "--servers" && i + 1 < argc) {
+            servers = parse_server_list(argv[++i]);
+        } else if (arg == "--no-hedge") {
+            hedge = false;
+        } else if (arg == "--quorum") {
+            quorum = true;
         } else if (arg == "--output-dir" && i + 1 < argc) {
             output_dir = argv[++i];
+        } else if (arg == "--chunk-size" && i + 1 < argc) {
+            chunk_size = std::stoi(argv[++i]);
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            log_level = argv[++i];
+        } else if (arg == "--validate-parse") {
+            validate_parse = true;
+        } else if (arg == "--source" && i + 1 < argc) {
+            block_source = argv[++i];
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engine = argv[++i];
+        } else if (arg == "--inflight" && i + 1 < argc) {
+            async_options.inflight = std::stoi(argv[++i]);
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            async_options.io_threads = std::stoi(argv[++i]);
+        } else if (arg == "--max-retries" && i + 1 < argc) {
+            max_retries = std::stoi(argv[++i]);
+        } else if (arg == "--no-adaptive") {
+            adaptive = false;
+        } else if (arg == "--batch") {
+            block_source = "batch";
+        } else if (arg == "--batch-size" && i + 1 < argc) {
+            batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--tx-batch-size" && i + 1 < argc) {
+            tx_batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--fresh") {
+            fresh = true;
+        } else if (arg == "--csv-sync" && i + 1 < argc) {
+            csv_sync = argv[++i];
+        } else if (arg == "--lmdb-path" && i + 1 < argc) {
+            lmdb_path = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--cache-only") {
+            cache_only = true;
+        } else if (arg == "--fees") {
+            fee_audit = true;
+        } else if (arg == "--verify-id") {
+            verify_id = true;
+        } else if (arg == "--columnar") {
+            columnar = true;
+        } else if (arg == "--follow") {
+            follow = true;
+        } else if (arg == "--zmq" && i + 1 < argc) {
+            zmq_endpoint = argv[++i];
+        } else if (arg == "--poll-ms" && i + 1 < argc) {
+            poll_ms = std::stoi(argv[++i]);
+        } else if (arg == "--shard" && i + 1 < argc) {
+            shard = argv[++i];
+        } else if (arg == "--input-raw" && i + 1 < argc) {
+            block_source = "raw";
+            raw_path = argv[++i];
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "\nUso: ./audit-xmr [opções]\n"
                       << "  --range <inicio> <fim>     Audita blocos do início ao fim\n"
                       << "  --block <altura>           Audita apenas um bloco específico\n"
+                      << "  --shard <i>/<N>            Audita só a parte i de N (trechos intercalados de 10000 blocos);\n"
+                      << "                             junte as partes com o audit-xmr-merge\n"
+                      << "  --follow                   Sem --range/--block: depois de auditar até o topo, continua\n"
+                      << "                             auditando cada bloco novo (Ctrl+C encerra)\n"
+                      << "  --zmq <endereço>           Publicador ZMQ do monerod para o --follow (ex. tcp://127.0.0.1:18083)\n"
+                      << "  --poll-ms <ms>             Intervalo do get_last_block_header no --follow (padrão 1000)\n"
+                      << "  --columnar                 Grava também o CSV em colunas binárias (.xmrc) para o audit-xmr-query\n"
                       << "  --threads <N>|max          Define o número de threads\n"
                       << "  --server <ip[:porta]>      Define o servidor RPC\n"
+                      << "  --servers <a,b,...>        Vários nós, balanceados pela latência observada\n"
+                      << "  --no-hedge                 Sem o pedido duplicado em outro nó após o p95\n"
+                      << "  --quorum                   Compara hash e reward entre todos os nós\n"
                       << "  --output-dir <dir>         Define o diretório de saída\n"
+                      << "  --chunk-size <N>           Blocos por lote do escalonador (padrão 16)\n"
+                      << "  --log-level <nível>        debug|info|aviso|erro (padrão info)\n"
+                      << "  --validate-parse           Confere a extração rápida de cada bloco contra o DOM\n"
+                      << "  --source json|bin|batch|lmdb|raw Fonte dos blocos: get_block por bloco, get_blocks_by_height.bin,\n"
+                      << "                             lote, o banco LMDB do monerod ou um blockchain.raw (offline, sem RPC)\n"
+                      << "  --lmdb-path <dir>          Banco da fonte lmdb (padrão ~/.bitmonero/lmdb)\n"
+                      << "  --input-raw <arquivo>      Audita uma exportação do monero-blockchain-export (fonte raw)\n"
+                      << "  --cache <arquivo>          Cache local de blocos, compartilhado com o audit-xmr-check\n"
+                      << "  --cache-only               Só o cache, sem RPC (reexecução offline)\n"
+                      << "  --fees                     Confere reward == recompensa base + taxas das txs do bloco\n"
+                      << "  --verify-id                Recalcula o id de cada bloco pelo blob e compara com o hash do nó\n"
+                      << "  --engine threads|async     Uma thread por requisição ou laço curl_multi (padrão threads)\n"
+                      << "  --inflight <N>             Requisições simultâneas no motor async (padrão 128)\n"
+                      << "  --io-threads <N>           Threads de I/O do motor async (padrão 1)\n"
+                      << "  --max-retries <N>          Novas tentativas por bloco com backoff (padrão 3)\n"
+                      << "  --no-adaptive              Concorrência fixa em vez do controle adaptativo\n"
+                      << "  --batch                    Atalho para --source batch (cabeçalhos + miner txs em lote)\n"
+                      << "  --batch-size <N>           Blocos por lote no modo batch (padrão e máximo 1000)\n"
+                      << "  --tx-batch-size <N>        Hashes por /get_transactions no modo batch (padrão e máximo 100)\n"
+                      << "  --fresh                    Sem argumentos: ignora o estado salvo e audita do zero\n"
+                      << "  --csv-sync none|close|flush fsync do CSV: nunca, ao fechar (padrão) ou a cada escrita\n"
                       << "  -h, --help                 Mostra esta ajuda\n"
                       << "  -v, --version              Mostra a versão\n";
             return 0;
@@ -142,84 +273,507 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    LogLevel level;
+    if (!parse_log_level(log_level, level)) {
+        std::cerr << "[AVISO] Nível de log inválido: " << log_level << ". Usando info.\n";
+        level = LogLevel::Info;
+    }
+    set_log_level(level);
+    if (engine != "threads" && engine != "async") {
+        std::cerr << "[AVISO] Motor inválido: " << engine << ". Usando threads.\n";
+        engine = "threads";
+    }
+    if (block_source != "json" && block_source != "bin" && block_source != "batch" &&
+        block_source != "lmdb" && block_source != "raw") {
+        std::cerr << "[AVISO] Fonte de blocos inválida: " << block_source << ". Usando json.\n";
+        block_source = "json";
+    }
+    SyncPolicy sync_policy;
+    if (!parse_sync_policy(csv_sync, sync_policy)) {
+        std::cerr << "[AVISO] Política de fsync inválida: " << csv_sync << ". Usando close.\n";
+        csv_sync = "close";
+        sync_policy = SyncPolicy::Close;
+    }
+    if (config.count("log_max_size")) set_log_max_size(std::stoull(config["log_max_size"]) * 1024 * 1024);
+
     set_rpc_url(rpc_url);
+    if (!servers.empty()) {
+        rpc_url = servers[0];
+        set_rpc_url(rpc_url);
+        set_rpc_nodes(servers);
+    }
+    set_rpc_hedging(hedge);
+    set_parse_validation(validate_parse);
+    // Limites de resposta do RPC restrito
+    batch_size = std::max(1, std::min(batch_size, MAX_HEADER_RANGE));
+    set_tx_batch_size(tx_batch_size);
+    if (config.count("timeout")) set_rpc_timeout(std::stol(config["timeout"]));
+
+    int shard_index = 1, shard_count = 1;
+    if (!shard.empty() && !parse_shard(shard, shard_index, shard_count)) {
+        std::cerr << "[ERRO] --shard inválido: " << shard << " (use i/N, com 1 <= i <= N)." << std::endl;
+        return 1;
+    }
+    if (shard_count > 1 && single_block >= 0) {
+        std::cerr << "[AVISO] --shard não se aplica a --block. Ignorado.\n";
+        shard_count = 1;
+    }
+    bool sharded = shard_count > 1;
 
     fs::path out_dir = fs::path(output_dir);
     fs::create_directories(out_dir);
 
-    std::string csv_path = (out_dir / "auditoria_monero.csv").string();
-    std::string log_path = (out_dir / "audit_log.txt").string();
+    // Cada parte tem CSV, log e manifesto próprios, então várias podem
+    // gravar no mesmo diretório
+    std::string stem = shard_file_stem(shard_index, shard_count);
+    std::string csv_path = (out_dir / (sharded ? stem + ".csv" : "auditoria_monero.csv")).string();
+    std::string log_path = (out_dir / (sharded ? "audit_log.shard-" + std::to_string(shard_index) + "-"
+                                                 + std::to_string(shard_count) + ".txt"
+                                               : "audit_log.txt")).string();
+    std::string manifest_path = (out_dir / (stem + ".manifest")).string();
+    std::string columnar_path = (out_dir / (sharded ? stem + ".xmrc" : "auditoria_monero.xmrc")).string();
     g_log_path = log_path;
 
+    // Fontes offline: o banco ou o arquivo é aberto antes de tudo e
+    // substitui o RPC na altura da cadeia, na conferência do estado salvo e
+    // na auditoria
+    bool offline = block_source == "lmdb" || block_source == "raw";
+    std::function<bool(int, int, std::vector<BlockFields>&)> offline_fetch;
+    std::function<int()> offline_height;
+    if (offline) {
+        std::string error;
+        bool lmdb = block_source == "lmdb";
+        const std::string& path = lmdb ? lmdb_path : raw_path;
+        if (!(lmdb ? open_lmdb_source(path, &error) : open_raw_source(path, &error))) {
+            std::cerr << "[ERRO] Não foi possível abrir " << (lmdb ? "o banco LMDB " : "a exportação ") << path
+                      << ": " << error << std::endl;
+            log_message(log_path, "[ERRO] Falha ao abrir " + path + ": " + error);
+            return 1;
+        }
+        offline_fetch = lmdb ? get_blocks_fields_lmdb : get_blocks_fields_raw;
+        offline_height = lmdb ? get_blockchain_height_lmdb : get_blockchain_height_raw;
+        // Arquivo local: uma leitura inválida não muda numa nova tentativa
+        if (!lmdb) max_retries = 0;
+    }
+
+    // Cache de blocos: o nó só é consultado pelas alturas ausentes ou
+    // reorganizadas; com --cache-only ele vira uma fonte offline como as acima
+    std::unique_ptr<BlockCache> cache;
+    if (cache_only && cache_path.empty()) {
+        std::cerr << "[ERRO] --cache-only requer --cache <arquivo> (ou cache_path no audit-xmr.cfg)." << std::endl;
+        return 1;
+    }
+    if (!cache_path.empty() && offline) {
+        std::cerr << "[AVISO] Cache ignorado com a fonte offline " << block_source << ".\n";
+        log_message(log_path, "[AVISO] Cache ignorado com a fonte " + block_source);
+    } else if (!cache_path.empty()) {
+        cache.reset(new BlockCache(cache_path, cache_only));
+        std::string error;
+        if (!cache->open(&error)) {
+            std::cerr << "[ERRO] Não foi possível abrir o cache " << cache_path << ": " << error << std::endl;
+            log_message(log_path, "[ERRO] Falha ao abrir o cache " + cache_path + ": " + error);
+            return 1;
+        }
+        if (cache_only) {
+            offline = true;
+            offline_fetch = [&](int from, int to, std::vector<BlockFields>& out) {
+                return cache->fetch(from, to, nullptr, out);
+            };
+            offline_height = [&] { return cache->contiguous_height(); };
+            max_retries = 0;
+            block_source = "cache";
+        }
+    }
+
     auto log = [&](const std::string& msg, bool is_block_end = false) {
         log_message(log_path, msg, is_block_end);
     };
+    // Auditoria de taxas: a fonte batch não tem os hashes das txs e o cache
+    // não guarda as taxas
+    if (fee_audit && block_source == "batch") {
+        std::cerr << "[AVISO] --fees não se aplica à fonte batch. Usando bin.\n";
+        log_message(log_path, "[AVISO] Fonte batch trocada por bin para a auditoria de taxas");
+        block_source = "bin";
+    }
+    if (fee_audit && cache) {
+        std::cerr << "[AVISO] --fees não se aplica com o cache. Auditoria de taxas desligada.\n";
+        log_message(log_path, "[AVISO] Auditoria de taxas ignorada com o cache");
+        fee_audit = false;
+    }
+    set_fee_audit(fee_audit);
+
+    // Verificação do id: a fonte batch não tem o blob do bloco, o cache não o
+    // guarda e a fonte raw já usa o id calculado como hash
+    if (verify_id && block_source == "batch") {
+        std::cerr << "[AVISO] --verify-id não se aplica à fonte batch. Usando bin.\n";
+        log_message(log_path, "[AVISO] Fonte batch trocada por bin para a verificação de id");
+        block_source = "bin";
+    }
+    if (verify_id && (cache || block_source == "raw")) {
+        std::cerr << "[AVISO] --verify-id não se aplica " << (cache ? "com o cache" : "à fonte raw")
+                  << ". Verificação de id desligada.\n";
+        log_message(log_path, "[AVISO] Verificação de id ignorada com " + std::string(cache ? "o cache" : "a fonte raw"));
+        verify_id = false;
+    }
+    set_id_check(verify_id);
+    set_lmdb_id_check(verify_id);
+
+    if (quorum && (offline || rpc_node_count() < 2)) {
+        std::cerr << "[AVISO] --quorum requer dois ou mais nós em servers= (ou --servers) e uma fonte RPC. Ignorado.\n";
+        log("[AVISO] Quórum ignorado: requer dois ou mais nós e uma fonte RPC");
+        quorum = false;
+    }
+
+    // O acompanhamento continua o estado da auditoria completa (sem
+    // argumentos) e precisa de um nó para saber dos blocos novos
+    if (follow && (args_specified || sharded || offline)) {
+        std::cerr << "[AVISO] --follow requer a auditoria sem --range/--block, sem --shard e com uma fonte RPC. Ignorado.\n";
+        log("[AVISO] Acompanhamento ignorado: requer a auditoria completa por RPC");
+        follow = false;
+    }
 
     // Exibir configurações
     std::cout << "------------------------\n";
     std::cout << "Configurações do audit-xmr\n";
     std::cout << "------------------------\n";
-    std::cout << "RPC URL: " << rpc_url << "\n";
-    std::cout << "  (Origem: " << (config.count("rpc_url") ? "audit-xmr.cfg" : config.count("server") ? "audit-xmr.cfg (server)" : "--server ou padrão") << ")\n";
+    if (rpc_node_count() > 1) {
+        std::cout << "Nós RPC:";
+        for (size_t i = 0; i < rpc_node_count(); ++i) std::cout << (i ? ", " : " ") << rpc_node_url(static_cast<int>(i));
+        std::cout << "\n  (duplicado após o p95: " << (hedge ? "sim" : "não") << ", quórum: " << (quorum ? "sim" : "não") << ")\n";
+    } else {
+        std::cout << "RPC URL: " << rpc_url << "\n";
+        std::cout << "  (Origem: " << (config.count("rpc_url") ? "audit-xmr.cfg" : config.count("server") ? "audit-xmr.cfg (server)" : "--server ou padrão") << ")\n";
+    }
     std::cout << "Threads: " << user_thread_count << "\n";
     std::cout << "  (Origem: " << (config.count("threads") ? "audit-xmr.cfg" : "--threads ou padrão") << ")\n";
     std::cout << "Output Dir: " << output_dir << "\n";
     std::cout << "  (Origem: " << (config.count("output_dir") ? "audit-xmr.cfg" : "--output-dir ou padrão") << ")\n";
-    if (config.count("max_retries")) std::cout << "Max Retries: " << config["max_retries"] << " (audit-xmr.cfg)\n";
+    std::cout << "Max Retries: " << max_retries << "\n";
+    std::cout << "  (Origem: " << (config.count("max_retries") ? "audit-xmr.cfg" : "--max-retries ou padrão") << ")\n";
+    std::cout << "Concorrência adaptativa: " << (adaptive ? "sim" : "não") << "\n";
     if (config.count("timeout")) std::cout << "Timeout: " << config["timeout"] << " (audit-xmr.cfg)\n";
-    std::cout << "CSV Path: " << csv_path << "\n";
+    std::cout << "Log Level: " << log_level << "\n";
+    std::cout << "Fonte de blocos: " << block_source << "\n";
+    if (block_source == "lmdb") std::cout << "Banco LMDB: " << lmdb_path << "\n";
+    if (cache) std::cout << "Cache: " << cache_path << (cache_only ? " (somente cache, sem RPC)" : "") << "\n";
+    if (block_source == "raw") {
+        std::cout << "Exportação: " << raw_path << " (blocos " << get_raw_first_height() << " a "
+                  << get_blockchain_height_raw() - 1 << ")\n";
+    }
+    if (block_source == "batch" || offline) std::cout << "Tamanho do lote: " << batch_size << " blocos\n";
+    if (fee_audit) std::cout << "Auditoria de taxas: sim (reward == base + taxas)\n";
+    if (verify_id) std::cout << "Verificação de id: sim (Keccak " << keccak_many_impl() << ")\n";
+    if (follow) {
+        std::cout << "Acompanhamento: sim (" << (zmq_endpoint.empty() ? "" : "ZMQ " + zmq_endpoint + " e ")
+                  << "consulta a cada " << poll_ms << " ms)\n";
+    }
+    if (sharded) std::cout << "Parte: " << shard_index << " de " << shard_count << " (trechos de " << SHARD_SPAN << " blocos)\n";
+    std::cout << "Motor: " << engine;
+    if (engine == "async") std::cout << " (" << async_options.inflight << " em voo, " << async_options.io_threads << " thread(s) de I/O)";
+    std::cout << "\n";
+    std::cout << "CSV Path: " << csv_path << " (fsync: " << csv_sync << ")\n";
     std::cout << "Log Path: " << log_path << "\n";
     std::cout << "------------------------\n\n";
 
     log("[INFO] Script iniciado");
 
-    // Variáveis para controle de escrita ordenada
+    // Controle de escrita ordenada: os resultados chegam fora de ordem na
+    // janela de reordenação e saem dela em ordem de altura para o CSV
     std::mutex csv_mutex;
-    std::condition_variable csv_cv;
-    std::map<int, AuditResult> pending_results;
-    int next_block_to_write = 0;
+    std::unique_ptr<BlockScheduler> scheduler;
+    // O escalonador e a janela trabalham com as posições do plano; sem
+    // --shard, posição = altura - início
+    std::unique_ptr<ShardPlan> plan;
+    std::unique_ptr<ReorderWindow<AuditResult>> pending_results;
+    std::unique_ptr<ConcurrencyController> controller;
+    std::unique_ptr<ProgressReporter> progress;
+    std::vector<int> failed_heights; // Protegido por csv_mutex
+    AuditBatch ready;  // Linhas liberadas pela janela, em colunas; protegido por csv_mutex
+    std::atomic<uint64_t> retries_done(0);
+
+    // Altura da cadeia, hash de um bloco e auditoria de um bloco, pelo nó ou pelo banco
+    auto chain_height = [&] {
+        return offline ? offline_height() : get_blockchain_height();
+    };
+    auto block_hash_at = [&](int height, std::string& hash) {
+        if (offline) {
+            std::vector<BlockFields> fields;
+            if (!offline_fetch(height, height, fields)) return false;
+            hash = fields[0].hash;
+            return true;
+        }
+        std::vector<BlockHeader> headers;
+        if (!get_block_headers_range(height, height, headers)) return false;
+        hash = headers[0].hash;
+        return true;
+    };
+    auto audit_one = [&](int height) -> std::optional<AuditResult> {
+        std::vector<BlockFields> fields;
+        if (offline) {
+            if (!offline_fetch(height, height, fields)) return std::nullopt;
+        } else if (cache) {
+            if (!cache->fetch(height, height, get_blocks_fields_json, fields)) return std::nullopt;
+        } else if (fee_audit) {
+            if (!get_blocks_fields_json(height, height, fields)) return std::nullopt;
+        } else {
+            return audit_block(height);
+        }
+        return audit_fields(height, fields[0]);
+    };
 
-    // Inicializa o CSV com o cabeçalho
+    // Estado da auditoria: sem argumentos, retoma do último ponto salvo que
+    // confere com o CSV e com a cadeia do nó. Só execuções que começam na
+    // altura 0 (ou retomam) mantêm o estado; as demais reescrevem o CSV e o
+    // invalidam.
+    AuditState state((out_dir / "audit_state.txt").string());
+    bool track_state = false;
+    std::optional<Checkpoint> resume_from;
+    if (single_block < 0) {
+        if (!args_specified) {
+            // Uma exportação pode começar depois da altura 0
+            start_block = block_source == "raw" ? get_raw_first_height() : 0;
+            end_block = chain_height() - 1;
+            if (end_block < 0) {
+                std::cerr << "[ERRO] Não foi possível obter a altura da blockchain." << std::endl;
+                log(offline ? "[ERRO] Falha ao obter altura da blockchain em " + block_source + "."
+                            : "[ERRO] Falha ao obter altura da blockchain via RPC.");
+                return 1;
+            }
+            track_state = start_block == 0 && !sharded;
+        } else {
+            track_state = start_block == 0 && !sharded;
+        }
+    }
+    if (track_state && !args_specified && !fresh) {
+        std::string error;
+        if (state.load(&error) && state.tip().height >= 0) {
+            // Um ponto vale se o CSV ainda tem a linha dele e o nó tem o mesmo
+            // hash naquela altura. Como cada bloco aponta para o anterior, os
+            // pontos válidos formam um prefixo: basta uma busca binária.
+            std::vector<Checkpoint> checkpoints = state.checkpoints();
+            bool rpc_failed = false;
+            auto valid = [&](const Checkpoint& cp) {
+                if (cp.height > end_block || !csv_matches_checkpoint(csv_path, cp)) return false;
+                std::string hash;
+                if (!block_hash_at(cp.height, hash)) {
+                    rpc_failed = true;
+                    return false;
+                }
+                return hash == cp.hash;
+            };
+            const Checkpoint& saved_tip = checkpoints.back();
+            if (valid(saved_tip)) {
+                resume_from = saved_tip;
+            } else if (!rpc_failed) {
+                size_t lo = 0, hi = checkpoints.size() - 1; // checkpoints[hi] é inválido
+                while (lo < hi && !rpc_failed) {
+                    size_t mid = lo + (hi - lo) / 2;
+                    if (valid(checkpoints[mid])) {
+                        resume_from = checkpoints[mid];
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                if (!rpc_failed) {
+                    std::string to = resume_from ? "o bloco " + std::to_string(resume_from->height) : "o início";
+                    std::cout << "[AVISO] O estado salvo (bloco " << saved_tip.height
+                              << ") não confere com o CSV ou com o nó (reorganização?). Voltando para " << to << ".\n";
+                    log("[AVISO] Estado salvo no bloco " + std::to_string(saved_tip.height)
+                        + " não confere com o CSV ou com o nó; retomando após " + to);
+                }
+            }
+            if (rpc_failed) {
+                std::cerr << "[ERRO] Falha ao conferir o estado salvo com o nó via RPC." << std::endl;
+                log("[ERRO] Falha ao conferir o estado salvo com o nó via RPC.");
+                return 1;
+            }
+        } else if (error != "arquivo inexistente") {
+            std::cerr << "[AVISO] Estado " << state.path() << " ignorado: " << error << "\n";
+            log("[AVISO] Estado " + state.path() + " ignorado: " + error);
+        }
+    }
+    if (resume_from) {
+        state.rewind(*resume_from);
+        start_block = resume_from->height + 1;
+    } else if (track_state) {
+        state.reset();
+    } else if (!sharded) {
+        state.remove(); // Uma parte não mexe no estado da auditoria inteira
+    }
+    // O CSV é criado com o cabeçalho e fica com a thread de escrita até o fim
+    CsvWriter csv_writer(csv_path, sync_policy);
+    if (track_state) {
+        // Cada linha gravada em sequência avança o estado, salvo a cada gravação do CSV
+        csv_writer.set_on_flush([&](const std::vector<WrittenRow>& rows) {
+            for (const auto& r : rows) state.extend(r.height, r.hash, r.coinbase_outputs, r.end_offset, r.fees);
+            std::string error;
+            if (!state.save(&error)) log("[ERRO] Falha ao salvar o estado " + state.path() + ": " + error);
+        });
+    }
     {
-        std::lock_guard<std::mutex> lock(csv_mutex);
-        std::ofstream csv(csv_path);
-        if (!csv.is_open()) {
-            std::cerr << "[ERRO] Não foi possível abrir o arquivo CSV para escrita: " << csv_path << std::endl;
-            log("[ERRO] Não foi possível abrir o arquivo CSV para escrita: " + csv_path);
+        std::string error;
+        bool opened = resume_from ? csv_writer.open_append(resume_from->csv_bytes, &error) : csv_writer.open(&error);
+        if (!opened) {
+            std::cerr << "[ERRO] Não foi possível abrir o arquivo CSV para escrita: " << csv_path << " (" << error << ")" << std::endl;
+            log("[ERRO] Não foi possível abrir o arquivo CSV para escrita: " + csv_path + " (" + error + ")");
             return 1;
         }
-        csv << "Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status\n";
-        csv.close();
     }
 
-    auto write_to_csv = [&](const AuditResult& res, int total_blocks) {
-        std::unique_lock<std::mutex> lock(csv_mutex);
-        pending_results[res.height] = res;
+    // Emissão: as linhas saem da janela em ordem de altura, então as moedas
+    // geradas são acompanhadas ali, bloco a bloco. Do início da cadeia ou de
+    // um estado salvo com as taxas, o valor é exato.
+    EmissionTracker emission;
+    if (fee_audit) {
+        std::optional<uint64_t> generated;
+        if (single_block < 0 && start_block == 0) generated = 0;
+        if (resume_from && resume_from->fees) generated = resume_from->supply - *resume_from->fees;
+        int first = single_block >= 0 ? single_block : start_block;
+        emission.reset(first, generated);
+        if (!generated && !offline) {
+            log("[INFO] Moedas geradas antes do bloco " + std::to_string(first)
+                + " desconhecidas; a base é estimada a partir dos primeiros blocos auditados");
+        }
+    }
+    auto check_emission = [&](AuditResult& r) {
+        std::string detail;
+        if (!emission.check(r, &detail)) {
+            log("[AVISO] Bloco " + std::to_string(r.height) + " sem conferência de base + taxas: " + detail);
+        } else if (!detail.empty()) {
+            log("[AVISO] Reward != Base+Fees no bloco " + std::to_string(r.height) + ": " + detail);
+        }
+        r.generated_after = emission.generated();
+    };
+
+    // Ligação prev_hash -> hash anterior: cada lote confere a dos seus blocos
+    // e só as pontas passam pelo linker, na mesma seção em que o lote entra
+    // na janela. Na retomada, o primeiro bloco tem que ligar ao checkpoint.
+    ChainLinker linker;
+    std::atomic<uint64_t> links_inside(0), link_breaks_inside(0), link_refetches(0);
+    if (resume_from) {
+        Hash32 seed;
+        if (hash_from_hex(resume_from->hash, seed)) linker.seed(resume_from->height, seed);
+    }
+    auto log_link_break = [&](int height, const Hash32& prev, const Hash32& previous_hash) {
+        log("[AVISO] Bloco " + std::to_string(height) + " não liga ao anterior: prev_hash " + to_hex(prev.data(), 32)
+            + ", hash do bloco " + std::to_string(height - 1) + " " + to_hex(previous_hash.data(), 32));
+    };
+    // Com csv_mutex: uma quebra na ponta direita marca o bloco seguinte, que
+    // já está na janela (só chegou antes por isso)
+    auto link_ends = [&](int position, std::vector<std::optional<AuditResult>>& results) {
+        int from = plan->height_of(position);
+        int to = from + static_cast<int>(results.size()) - 1;
+        Hash32 found;
+        std::optional<AuditResult>& head = results.front();
+        if (head && head->prev_hash && !linker.link_head(from, *head->prev_hash, &found)) {
+            head->add_issue(ISSUE_CHAIN_LINK);
+            log_link_break(from, *head->prev_hash, found);
+        }
+        std::optional<AuditResult>& tail = results.back();
+        if (tail && !linker.link_tail(to, tail->hash, &found)) {
+            int next = plan->position_of(to + 1);
+            std::optional<AuditResult>* slot = next >= 0 ? pending_results->pending(next) : nullptr;
+            if (slot && *slot) (*slot)->add_issue(ISSUE_CHAIN_LINK);
+            log_link_break(to + 1, found, tail->hash);
+        }
+    };
+
+    // Pontas do trecho que não ligam às vizinhas já entregues: 1 a esquerda,
+    // 2 a direita
+    auto broken_ends = [&](int position, const std::vector<std::optional<AuditResult>>& results) {
+        int from = plan->height_of(position);
+        int to = from + static_cast<int>(results.size()) - 1;
+        const std::optional<AuditResult>& head = results.front();
+        const std::optional<AuditResult>& tail = results.back();
+        int broken = 0;
+        if (head && head->prev_hash && !linker.head_links(from, *head->prev_hash)) broken |= 1;
+        if (tail && !linker.tail_links(to, tail->hash)) broken |= 2;
+        return broken;
+    };
+
+    // Põe um trecho de alturas contíguas na janela e só move as linhas
+    // liberadas para o escritor; formatação e disco ficam com ele. Com
+    // 'refetch', um trecho com ponta quebrada volta sem ser entregue e o
+    // retorno diz quais (broken_ends), para o worker buscar de novo.
+    auto write_to_csv = [&](int position, std::vector<std::optional<AuditResult>>& results, bool refetch = false) {
+        if (results.empty()) return 0;
+        std::lock_guard<std::mutex> lock(csv_mutex);
+        if (refetch) {
+            int broken = broken_ends(position, results);
+            if (broken) return broken;
+        }
+        link_ends(position, results);
+        for (size_t k = 0; k < results.size(); ++k) {
+            pending_results->put(position + static_cast<int>(k), std::move(results[k]));
+        }
+        results.clear();
 
-        while (pending_results.find(next_block_to_write) != pending_results.end()) {
-            const auto& r = pending_results[next_block_to_write];
-            std::ofstream csv(csv_path, std::ios::app);
-            if (!csv.is_open()) {
-                std::cerr << "[ERRO] Não foi possível abrir o arquivo CSV para escrita: " << csv_path << std::endl;
-                log("[ERRO] Não foi possível abrir o arquivo CSV para escrita: " + csv_path);
+        pending_results->drain([&](int p, std::optional<AuditResult>& pending) {
+            int h = plan->height_of(p);
+            if (!pending.has_value()) {
+                log("[ERRO] Bloco " + std::to_string(h) + " não escrito no CSV (falha na auditoria)");
+                failed_heights.push_back(h);
+                int next = plan->position_of(h + 1);
+                linker.drop(h, next >= 0 && !pending_results->pending(next));
                 return;
             }
-            csv << r.height << ',' << r.hash << ',' << r.real_reward << ','
-                << r.coinbase_outputs << ',' << r.total_mined << ','
-                << (r.issues.empty() ? "Nenhum" : r.issues_string()) << ',' << r.status << '\n';
-            csv.close();
-
-            log("[INFO] Bloco " + std::to_string(r.height) + " escrito no CSV: status=" + r.status);
-            blocks_written++; // Incrementa o contador global
-            if (total_blocks > 0) { // Só exibe progresso no modo intervalo
-                print_progress(blocks_written, total_blocks);
-            }
+            if (fee_audit) check_emission(*pending);
+            LOG_DEBUG(log_path, "[DEBUG] Bloco " + std::to_string(h) + " enviado ao CSV: status="
+                      + status_name(pending->status()));
+            ready.push_back(*pending);
+        });
+        blocks_written += static_cast<int>(ready.size());
+        csv_writer.push(ready);
+        scheduler->advance(pending_results->next_height());
+        if (progress) progress->update(blocks_written);
+        return 0;
+    };
+
+    // Executa uma busca com novas tentativas (backoff exponencial com jitter)
+    // e alimenta o controle de concorrência com o resultado e a latência
+    auto with_retry = [&](const std::string& what, const std::function<bool()>& attempt_fn) {
+        for (int attempt = 0; ; ++attempt) {
+            if (controller) controller->acquire();
+            auto t0 = std::chrono::steady_clock::now();
+            bool ok = attempt_fn();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (controller) controller->release(ok, ms);
+            if (ok) return true;
+            if (attempt >= max_retries) return false;
 
-            pending_results.erase(next_block_to_write);
-            next_block_to_write++;
+            auto delay = backoff_delay(attempt + 1);
+            retries_done++;
+            log("[AVISO] " + what + " falhou (tentativa " + std::to_string(attempt + 1) + " de "
+                + std::to_string(max_retries + 1) + "); nova tentativa em " + std::to_string(delay.count()) + " ms");
+            std::this_thread::sleep_for(delay);
+        }
+    };
+
+    // Quórum: hash e reward de cada bloco auditado são pedidos a todos os
+    // nós; qualquer nó que discorde vira o problema "Divergência entre nós"
+    std::atomic<uint64_t> quorum_disagreements(0);
+    auto apply_quorum = [&](int from, std::vector<std::optional<AuditResult>>& results) {
+        if (!quorum || results.empty()) return;
+        std::vector<BlockFields> audited(results.size());
+        for (size_t k = 0; k < results.size(); ++k) {
+            if (!results[k]) continue;
+            audited[k].hash = results[k]->hash_hex();
+            audited[k].reward = results[k]->real_reward;
+        }
+        int to = from + static_cast<int>(results.size()) - 1;
+        std::vector<std::string> disagree;
+        if (!check_node_quorum(from, to, audited, disagree)) {
+            log("[AVISO] Quórum incompleto nos blocos " + std::to_string(from) + ".." + std::to_string(to)
+                + ": menos de dois nós responderam");
+        }
+        for (size_t k = 0; k < results.size(); ++k) {
+            if (!results[k] || disagree[k].empty()) continue;
+            results[k]->add_issue(ISSUE_NODE_DIVERGENCE);
+            quorum_disagreements++;
+            log("[AVISO] Divergência entre nós no bloco " + std::to_string(from + static_cast<int>(k))
+                + " (hash " + results[k]->hash_hex() + ", reward " + std::to_string(results[k]->real_reward) + "): " + disagree[k]);
         }
-        lock.unlock();
-        csv_cv.notify_all();
     };
 
     if (single_block >= 0) {
@@ -227,50 +781,56 @@ int main(int argc, char* argv[]) {
         std::cout << "Auditoria de Bloco Único\n";
         std::cout << "------------------------\n";
         log("[INFO] Auditando bloco único: " + std::to_string(single_block));
-        auto res = audit_block(single_block);
+        std::optional<AuditResult> res;
+        with_retry("Bloco " + std::to_string(single_block), [&] {
+            res = audit_one(single_block);
+            return res.has_value();
+        });
+        if (res.has_value() && quorum) {
+            std::vector<std::optional<AuditResult>> one(1, res);
+            apply_quorum(single_block, one);
+            res = std::move(one[0]);
+        }
+        if (res.has_value() && fee_audit) check_emission(*res);
         if (res.has_value()) {
             auto result = res.value();
             std::cout << "Bloco " << result.height << ":\n";
-            std::cout << "  Hash: " << result.hash << "\n";
+            std::cout << "  Hash: " << result.hash_hex() << "\n";
             std::cout << "  Recompensa Real: " << result.real_reward << "\n";
             std::cout << "  Saídas Coinbase: " << result.coinbase_outputs << "\n";
             std::cout << "  Total Minerado: " << result.total_mined << "\n";
-            std::cout << "  Problemas: " << (result.issues.empty() ? "Nenhum" : result.issues_string()) << "\n";
-            std::cout << "  Status: " << result.status << "\n";
+            if (result.fees) std::cout << "  Taxas: " << *result.fees << "\n";
+            if (result.generated_after) std::cout << "  Moedas Geradas: " << *result.generated_after << "\n";
+            std::cout << "  Problemas: " << (result.issues ? result.issues_string() : "Nenhum") << "\n";
+            std::cout << "  Status: " << status_name(result.status()) << "\n";
 
-            std::ofstream csv(csv_path, std::ios::app);
-            if (!csv.is_open()) {
-                std::cerr << "[ERRO] Não foi possível abrir o arquivo CSV para escrita: " << csv_path << std::endl;
-                log("[ERRO] Não foi possível abrir o arquivo CSV para escrita: " + csv_path);
-                return 1;
-            }
-            csv << result.height << ',' << result.hash << ',' << result.real_reward << ','
-                << result.coinbase_outputs << ',' << result.total_mined << ','
-                << (result.issues.empty() ? "Nenhum" : result.issues_string()) << ',' << result.status << '\n';
-            csv.close();
-            log("[INFO] Bloco " + std::to_string(result.height) + " escrito no CSV: status=" + result.status);
+            csv_writer.push(result);
+            log("[INFO] Bloco " + std::to_string(result.height) + " escrito no CSV: status=" + status_name(result.status()));
             std::cout << "Bloco " << std::setw(6) << result.height << " escrito no CSV\n";
         } else {
             std::cerr << "[ERRO] Auditoria falhou para o bloco " << single_block << std::endl;
             log("[ERRO] Auditoria falhou para o bloco " + std::to_string(single_block), true);
             return 1;
         }
+    } else if (start_block > end_block) {
+        // Retomada sem blocos novos desde a última execução
+        std::cout << "Nada novo para auditar: o CSV já vai até o bloco " << end_block << ".\n";
+        log("[INFO] Nada novo para auditar; CSV até o bloco " + std::to_string(end_block));
     } else {
-        if (!args_specified) {
-            start_block = 0;
-            end_block = get_blockchain_height() - 1;
-            if (end_block < 0) {
-                std::cerr << "[ERRO] Não foi possível obter a altura da blockchain." << std::endl;
-                log("[ERRO] Falha ao obter altura da blockchain via RPC.");
-                return 1;
-            }
+        if (resume_from) {
+            std::cout << "Retomando após o bloco " << resume_from->height << " (estado em " << state.path() << ")\n";
+            log("[INFO] Retomando após o bloco " + std::to_string(resume_from->height)
+                + ". Auditando de " + std::to_string(start_block) + " a " + std::to_string(end_block));
+        } else if (!args_specified) {
             log("[INFO] Nenhum argumento fornecido. Auditando todos os blocos de 0 a " + std::to_string(end_block));
         }
 
         std::cout << "------------------------\n";
         std::cout << "Auditoria de Intervalo\n";
         std::cout << "------------------------\n";
-        std::cout << "Auditando blocos de " << start_block << " a " << end_block << "\n";
+        std::cout << "Auditando blocos de " << start_block << " a " << end_block;
+        if (sharded) std::cout << " (parte " << shard_index << " de " << shard_count << ")";
+        std::cout << "\n";
         log("[INFO] Iniciando auditoria de " + std::to_string(start_block) + " até " + std::to_string(end_block));
 
         int max_threads = std::thread::hardware_concurrency();
@@ -279,43 +839,510 @@ int main(int argc, char* argv[]) {
         }
 
         int thread_count = std::max(1, user_thread_count);
-        int total_blocks = end_block - start_block + 1;
-        next_block_to_write = start_block;
+        plan.reset(new ShardPlan(start_block, end_block, shard_index, shard_count));
+        int total_blocks = plan->size();
+        if (total_blocks == 0) {
+            std::cout << "Nenhum trecho desta parte no intervalo.\n";
+            log("[INFO] Parte " + std::to_string(shard_index) + "/" + std::to_string(shard_count) + " sem blocos no intervalo");
+        }
         blocks_written = 0; // Inicializa o contador
+        progress.reset(new ProgressReporter(total_blocks));
+
+        // Lotes pequenos entregues em ordem; a janela limita quantos blocos
+        // podem estar auditados e ainda não escritos (backpressure)
+        // No modo batch o lote é o intervalo de cada get_block_headers_range;
+        // na fonte binária ele também não pode passar desse limite
+        int batch = std::max(1, chunk_size);
+        // Com o cache, cada lote custa um get_block_headers_range para conferir os hashes
+        if (block_source == "batch" || offline || cache) batch = batch_size;
+        if (block_source == "bin") batch = std::min(batch, MAX_HEADER_RANGE);
+        int window = thread_count * batch * 4;
+        // O motor async só tem o caminho get_block; as fontes em lote já
+        // fazem poucas requisições e continuam com as threads
+        bool use_async = engine == "async" && block_source == "json" && !cache && !quorum && !fee_audit;
+        if (engine == "async" && !use_async) {
+            std::cerr << "[AVISO] --engine async só se aplica à fonte json, sem cache, quórum nem --fees. Usando threads.\n";
+            log("[AVISO] --engine async ignorado com a fonte " + block_source + (cache ? " e o cache" : "")
+                + (quorum ? " e o quórum" : "") + (fee_audit ? " e a auditoria de taxas" : ""));
+        }
+        if (use_async) window = std::max(window, async_options.inflight * 2);
+
+        // O limite adaptativo começa em 1/4 do máximo e sobe enquanto a
+        // latência se mantiver; sem ele a concorrência fica fixa no máximo
+        int max_concurrency = use_async ? std::max(1, async_options.inflight) : thread_count;
+        // Sem rede, não há latência a controlar: todas as threads leem o banco
+        controller.reset(new ConcurrencyController(std::max(1, offline ? max_concurrency : max_concurrency / 4), 1,
+                                                   max_concurrency, adaptive && !offline));
+        scheduler.reset(new BlockScheduler(0, total_blocks - 1, batch, window));
+        pending_results.reset(new ReorderWindow<AuditResult>(0, scheduler->capacity()));
+
+        auto worker = [&] {
+            BlockScheduler::Cursor cursor;
+            int from = 0, to = -1;
+            std::vector<BlockFields> fetched;
+            // Fontes em lote: cada reserva leva o lote inteiro
+            std::function<bool(int, int, std::vector<BlockFields>&)> fetch_range;
+            if (block_source == "bin") fetch_range = get_blocks_fields_bin;
+            if (block_source == "batch") fetch_range = get_blocks_fields_batch;
+            // Na json, as taxas pedem o lote inteiro para agrupar as txs
+            if (block_source == "json" && fee_audit) fetch_range = get_blocks_fields_json;
+            if (cache && !offline) {
+                // O cache fica na frente da fonte; na json, um get_block por altura ausente
+                BlockCache::RangeFetch source = fetch_range ? fetch_range : get_blocks_fields_json;
+                fetch_range = [&, source](int a, int b, std::vector<BlockFields>& out) {
+                    return cache->fetch(a, b, source, out);
+                };
+            }
+            if (offline) fetch_range = offline_fetch;
+            // Também na json sem lote: a ligação dentro de cada reserva é
+            // conferida ali mesmo e só as pontas passam pelo linker
+            int claim = batch;
+            std::vector<std::optional<AuditResult>> results;
+            int position = 0; // Posição da altura 'from'
+            // Busca e audita [from, to] em 'results'. Se a busca do lote falhar,
+            // ele é refeito bloco a bloco pelo get_block; false só quando a
+            // leitura offline falha e o lote inteiro fica como falha.
+            auto audit_run = [&] {
+                results.clear();
+                if (fetch_range) {
+                    std::string what = "Lote " + std::to_string(from) + ".." + std::to_string(to);
+                    if (with_retry(what, [&] { return fetch_range(from, to, fetched); })) {
+                        for (int h = from; h <= to; ++h) results.push_back(audit_fields(h, fetched[h - from]));
+                        return true;
+                    }
+                    if (offline) {
+                        // Sem nó para o fallback
+                        log("[ERRO] Falha na leitura offline (" + block_source + ") de " + std::to_string(from) + " a "
+                            + std::to_string(to), true);
+                        results.assign(static_cast<size_t>(to - from) + 1, std::nullopt);
+                        return false;
+                    }
+                    log("[AVISO] Falha na busca em lote de " + std::to_string(from) + " a " +
+                        std::to_string(to) + "; usando get_block");
+                }
+                // Como nas fontes em lote, os get_block do trecho vão a um só
+                // nó, para a ligação conferida dentro dele não misturar cadeias
+                std::optional<RpcNodePin> pin;
+                if (pinned_rpc_node() < 0 && rpc_node_count() > 1) pin.emplace(pick_rpc_node());
+                for (int h = from; h <= to; ++h) {
+                    LOG_DEBUG(log_path, "[DEBUG] Auditando bloco " + std::to_string(h));
+                    std::optional<AuditResult> res;
+                    with_retry("Bloco " + std::to_string(h), [&] {
+                        res = audit_block(h);
+                        return res.has_value();
+                    });
+                    if (!res.has_value()) {
+                        log("[ERRO] Falha na auditoria do bloco " + std::to_string(h), true);
+                    }
+                    results.push_back(std::move(res));
+                }
+                return true;
+            };
+            // Ligação dentro do lote. Com 'flag', marca as quebras; as contagens
+            // só vão aos totais quando o lote é entregue. As das pontas são
+            // conferidas na entrega (write_to_csv).
+            uint64_t lot_checked = 0, lot_breaks = 0;
+            auto links_ok = [&](bool flag) {
+                bool ok = true;
+                lot_checked = lot_breaks = 0;
+                for (size_t k = 1; k < results.size(); ++k) {
+                    if (!results[k] || !results[k - 1] || !results[k]->prev_hash) continue;
+                    lot_checked++;
+                    if (*results[k]->prev_hash == results[k - 1]->hash) continue;
+                    ok = false;
+                    if (!flag) break;
+                    results[k]->add_issue(ISSUE_CHAIN_LINK);
+                    lot_breaks++;
+                    log_link_break(from + static_cast<int>(k), *results[k]->prev_hash, results[k - 1]->hash);
+                }
+                return ok;
+            };
+            // Quebra numa ponta: o lado já entregue pode ser o que está na
+            // outra cadeia. O lote e as alturas vizinhas das pontas quebradas
+            // são buscados juntos num só nó; as vizinhas só servem para dizer
+            // no log se o lado entregue mudou, porque ele já saiu do worker.
+            auto refetch_ends = [&](int broken) {
+                int own_from = from, own_to = to;
+                bool ok;
+                {
+                    RpcNodePin pin(pick_rpc_node());
+                    if (broken & 1) from--;
+                    if (broken & 2) to++;
+                    ok = audit_run();
+                    from = own_from;
+                    to = own_to;
+                }
+                std::optional<AuditResult> before, after;
+                if (broken & 1) {
+                    before = std::move(results.front());
+                    results.erase(results.begin());
+                }
+                if (broken & 2) {
+                    after = std::move(results.back());
+                    results.pop_back();
+                }
+                if (before && !linker.head_links(from, before->hash)) {
+                    log("[AVISO] Bloco " + std::to_string(from - 1) + " já entregue tem outro hash no nó agora ("
+                        + to_hex(before->hash.data(), 32) + ")");
+                }
+                if (after && after->prev_hash && !linker.tail_links(to, *after->prev_hash)) {
+                    log("[AVISO] Bloco " + std::to_string(to + 1) + " já entregue tem outro prev_hash no nó agora ("
+                        + to_hex(after->prev_hash->data(), 32) + ")");
+                }
+                return ok;
+            };
+            int first = 0, last = -1;
+            while (true) {
+                // Cada reserva de posições vira intervalos de alturas contíguas
+                // (com --shard, uma reserva pode cruzar o fim de um trecho)
+                if (first > last && !scheduler->next(cursor, first, last, claim)) break;
+                position = first;
+                int run_end = plan->contiguous_until(first, last);
+                from = plan->height_of(first);
+                to = from + (run_end - first);
+                first = run_end + 1;
+                if (!audit_run()) {
+                    write_to_csv(position, results);
+                    continue;
+                }
+                // Uma quebra costuma ser o nó trocando de cadeia no meio do
+                // lote, ou outro nó do balanceamento numa cadeia diferente:
+                // o lote é buscado de novo uma vez e o que persistir é marcado
+                if (!links_ok(false)) {
+                    log("[AVISO] Ligação prev_hash quebrada em " + std::to_string(from) + ".." + std::to_string(to)
+                        + "; buscando o lote de novo");
+                    link_refetches++;
+                    if (!audit_run()) {
+                        write_to_csv(position, results);
+                        continue;
+                    }
+                }
+                links_ok(true);
+                // Entrega o lote ao CSV, depois do quórum quando ele está ligado
+                apply_quorum(from, results);
+                int broken = write_to_csv(position, results, true);
+                if (broken) {
+                    // Também uma vez por quebra; a que persistir é marcada na entrega
+                    log("[AVISO] Ligação prev_hash quebrada na ponta de " + std::to_string(from) + ".."
+                        + std::to_string(to) + "; buscando o lote e a vizinha de novo");
+                    link_refetches++;
+                    if (!refetch_ends(broken)) {
+                        write_to_csv(position, results);
+                        continue;
+                    }
+                    links_ok(true);
+                    apply_quorum(from, results);
+                    write_to_csv(position, results);
+                }
+                links_inside += lot_checked;
+                link_breaks_inside += lot_breaks;
+            }
+        };
+
+        if (use_async) {
+            // As threads configuradas viram o pool de parse e auditoria
+            async_options.cpu_threads = thread_count;
+            async_options.max_retries = max_retries;
+            async_options.controller = controller.get();
+            async_options.height_of = [&](int p) { return plan->height_of(p); };
+            AsyncEngineStats engine_stats = run_async_engine(*scheduler, async_options,
+                [&](int h, std::optional<AuditResult> res) {
+                    if (!res.has_value()) {
+                        log("[ERRO] Falha na auditoria do bloco " + std::to_string(h), true);
+                    }
+                    // Sem lote para buscar de novo: uma quebra só é marcada
+                    std::vector<std::optional<AuditResult>> one(1, std::move(res));
+                    write_to_csv(plan->position_of(h), one);
+                });
+            progress->finish(blocks_written);
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(1) << engine_stats.requests_per_second()
+               << " req/s, em voo: média " << engine_stats.mean_inflight << ", pico " << engine_stats.peak_inflight;
+            std::cout << "Motor assíncrono: " << ss.str() << "\n";
+            log("[INFO] Motor assíncrono: " + ss.str());
+            retries_done += engine_stats.retries;
+        } else {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < thread_count; ++i) {
+                threads.emplace_back(worker);
+            }
+
+            for (auto& t : threads) t.join();
+            progress->finish(blocks_written);
+        }
+    }
+
+    // Acompanhamento do topo: cada bloco novo é auditado sozinho, em ordem,
+    // e gravado na hora; o estado avança a cada linha. Se o nó trocar de
+    // cadeia, o CSV e o estado voltam ao último ponto comum e o trecho
+    // substituído é auditado de novo.
+    std::vector<double> follow_latencies;
+    uint64_t follow_reorgs = 0, follow_replaced = 0;
+    if (follow) {
+        TipWatcher watcher(zmq_endpoint, poll_ms);
+        std::string error;
+        if (!watcher.start(&error)) {
+            std::cerr << "[AVISO] ZMQ " << zmq_endpoint << " indisponível (" << error << "). Só consultas ao nó.\n";
+            log("[AVISO] ZMQ " + zmq_endpoint + " indisponível: " + error + "; acompanhamento por consulta ao nó");
+        }
+        std::signal(SIGINT, on_stop_signal);
+        std::signal(SIGTERM, on_stop_signal);
 
-        auto worker = [&](int tid, int from, int to) {
-            for (int h = from; h <= to; ++h) {
-                log("[DEBUG] Thread " + std::to_string(tid) + " auditando bloco " + std::to_string(h));
-                auto res = audit_block(h);
-                if (res.has_value()) {
-                    write_to_csv(res.value(), total_blocks);
-                } else {
-                    log("[ERRO] Falha na auditoria do bloco " + std::to_string(h), true);
+        // Volta o CSV e o estado para 'cp' (altura -1: do zero)
+        auto rewind_to = [&](const Checkpoint& cp) {
+            csv_writer.close();
+            std::string err;
+            bool opened;
+            if (cp.height < 0) {
+                state.reset();
+                opened = csv_writer.open(&err);
+            } else {
+                state.rewind(cp);
+                opened = csv_writer.open_append(cp.csv_bytes, &err);
+            }
+            if (!state.save(&err)) log("[ERRO] Falha ao salvar o estado " + state.path() + ": " + err);
+            if (fee_audit) {
+                std::optional<uint64_t> generated;
+                if (cp.height < 0) generated = 0;
+                else if (cp.fees) generated = cp.supply - *cp.fees;
+                emission.reset(cp.height + 1, generated);
+            }
+            return opened;
+        };
+        // Último ponto de retomada que o nó ainda tem, do mais novo para o mais antigo
+        auto common_checkpoint = [&](int node_height, Checkpoint& found) {
+            std::vector<Checkpoint> checkpoints = state.checkpoints();
+            for (auto it = checkpoints.rbegin(); it != checkpoints.rend(); ++it) {
+                if (it->height > node_height) continue;
+                std::string hash;
+                if (!block_hash_at(it->height, hash)) return false;
+                if (hash == it->hash) {
+                    found = *it;
+                    return true;
                 }
             }
+            found = Checkpoint();
+            return true;
         };
 
-        std::vector<std::thread> threads;
-        int chunk_size = total_blocks / thread_count;
-        int remainder = total_blocks % thread_count;
-        int current = start_block;
-        for (int i = 0; i < thread_count; ++i) {
-            int extra = (i < remainder) ? 1 : 0;
-            int range_size = chunk_size + extra;
-            int from = current;
-            int to = current + range_size - 1;
-            current = to + 1;
-            threads.emplace_back(worker, i, from, to);
+        // Linhas depois de um bloco que falhou na auditoria completa não
+        // seguem o estado: o CSV volta ao fim da sequência antes de continuar
+        bool ok = csv_writer.flush_now();
+        if (ok && state.tip().height != end_block) {
+            // Como na reorganização, as linhas descartadas saem da contagem:
+            // desta execução ficam só as de start_block até o topo
+            int dropped = blocks_written - (state.tip().height + 1 - start_block);
+            blocks_written -= dropped;
+            ok = rewind_to(state.tip());
+        }
+        if (!ok) {
+            std::cerr << "[ERRO] Falha ao gravar o CSV " << csv_path << "; acompanhamento cancelado." << std::endl;
+            log("[ERRO] Falha ao gravar o CSV " + csv_path + "; acompanhamento cancelado");
         }
+        std::cout << "------------------------\n";
+        std::cout << "Acompanhando o topo a partir do bloco " << state.tip().height + 1
+                  << (watcher.using_zmq() ? " (ZMQ)" : " (consulta ao nó)") << "; Ctrl+C encerra\n";
+        log("[INFO] Acompanhamento iniciado após o bloco " + std::to_string(state.tip().height)
+            + (watcher.using_zmq() ? " via ZMQ " + zmq_endpoint : " por consulta a cada " + std::to_string(poll_ms) + " ms"));
+
+        while (ok && !g_stop) {
+            std::optional<ChainTip> tip = watcher.next(g_stop);
+            if (!tip) continue;
+            Checkpoint ours = state.tip();
+            if (tip->height == ours.height && tip->hash == ours.hash) continue;
 
-        for (auto& t : threads) t.join();
-        std::cout << "\n"; // Nova linha após o progresso
+            // Topo do nó na mesma altura com outro hash: troca de cadeia. Abaixo
+            // do nosso, só se o nó não tiver mais o nosso último bloco (um nó
+            // atrasado de --servers não conta). Acima, ela aparece no prev_hash.
+            bool reorg = tip->height == ours.height;
+            if (tip->height < ours.height) {
+                std::string hash;
+                if (!block_hash_at(ours.height, hash) || hash == ours.hash) continue;
+                reorg = true;
+            }
+            for (int h = ours.height + 1; h <= tip->height && !reorg && !g_stop; ++h) {
+                std::optional<AuditResult> res;
+                with_retry("Bloco " + std::to_string(h), [&] {
+                    res = audit_one(h);
+                    return res.has_value();
+                });
+                if (!res) {
+                    log("[ERRO] Falha na auditoria do bloco " + std::to_string(h) + "; nova tentativa no próximo aviso", true);
+                    break;
+                }
+                if (state.tip().height >= 0 && res->prev_hash && to_hex(res->prev_hash->data(), 32) != state.tip().hash) {
+                    reorg = true;
+                    break;
+                }
+                if (quorum) {
+                    std::vector<std::optional<AuditResult>> one(1, res);
+                    apply_quorum(h, one);
+                    res = std::move(one[0]);
+                }
+                if (fee_audit) check_emission(*res);
+                csv_writer.push(*res);
+                if (!csv_writer.flush_now()) {
+                    ok = false;
+                    break;
+                }
+                blocks_written++;
+                // Do aviso do bloco novo até a linha no disco (e o estado salvo)
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tip->seen).count();
+                follow_latencies.push_back(ms);
+                std::stringstream ss;
+                ss << "Bloco " << h << " escrito no CSV: " << status_name(res->status()) << " (" << std::fixed
+                   << std::setprecision(1) << ms << " ms)";
+                std::cout << ss.str() << "\n";
+                log("[INFO] " + ss.str() + (res->issues ? ", problemas: " + res->issues_string() : ""));
+            }
+            if (!reorg || !ok) continue;
+
+            Checkpoint cp;
+            if (!common_checkpoint(tip->height, cp)) {
+                log("[AVISO] Falha ao procurar o ponto comum com o nó; nova tentativa no próximo aviso");
+                continue;
+            }
+            int replaced = state.tip().height - cp.height;
+            follow_reorgs++;
+            follow_replaced += static_cast<uint64_t>(replaced);
+            std::stringstream ss;
+            ss << "Reorganização: blocos " << cp.height + 1 << " a " << state.tip().height
+               << " substituídos; auditando de novo a partir do bloco " << cp.height + 1;
+            std::cout << "[AVISO] " << ss.str() << "\n";
+            log("[AVISO] " + ss.str());
+            blocks_written -= replaced;
+            ok = rewind_to(cp);
+            // O trecho novo é auditado já, sem esperar o próximo aviso
+            watcher.wake();
+        }
+        if (!ok) {
+            std::cerr << "[ERRO] Falha ao gravar o CSV " << csv_path << "; veja o log." << std::endl;
+            log("[ERRO] Falha ao gravar o CSV " + csv_path + " no acompanhamento");
+        }
+        log("[INFO] Acompanhamento encerrado no bloco " + std::to_string(state.tip().height));
+    }
+
+    if (!csv_writer.close()) {
+        std::cerr << "[ERRO] Falha ao gravar o CSV " << csv_path << "; veja o log." << std::endl;
+        log("[ERRO] Falha ao gravar o CSV " + csv_path);
+        return 1;
+    }
+    if (sharded) {
+        ShardManifest manifest;
+        manifest.index = shard_index;
+        manifest.count = shard_count;
+        manifest.start = start_block;
+        manifest.end = end_block;
+        manifest.csv = fs::path(csv_path).filename().string();
+        manifest.rows = static_cast<uint64_t>(blocks_written.load());
+        manifest.failed = failed_heights;
+        std::string err;
+        if (!save_shard_manifest(manifest_path, manifest, &err)) {
+            std::cerr << "[ERRO] Falha ao gravar o manifesto " << manifest_path << ": " << err << std::endl;
+            log("[ERRO] Falha ao gravar o manifesto " + manifest_path + ": " + err);
+            return 1;
+        }
+    }
+
+    if (columnar) {
+        // Refeito do CSV inteiro, que continua sendo a saída de referência
+        std::string err;
+        uint64_t rows = 0;
+        if (!csv_to_columnar(csv_path, columnar_path, &err, &rows)) {
+            std::cerr << "[ERRO] Falha ao gravar o arquivo colunar " << columnar_path << ": " << err << std::endl;
+            log("[ERRO] Falha ao gravar o arquivo colunar " + columnar_path + ": " + err);
+            return 1;
+        }
+        log("[INFO] Arquivo colunar " + columnar_path + " com " + std::to_string(rows) + " linhas");
     }
 
     std::cout << "------------------------\n";
     std::cout << "Auditoria Concluída\n";
     std::cout << "------------------------\n";
     std::cout << "Resultados salvos em: " << csv_path << "\n";
+    if (sharded) std::cout << "Manifesto da parte: " << manifest_path << "\n";
+    if (columnar) std::cout << "Arquivo colunar: " << columnar_path << "\n";
+    {
+        RpcStats stats = get_rpc_stats();
+        int audited = single_block >= 0 ? 1 : blocks_written.load();
+        double per_k = audited > 0 ? stats.connects * 1000.0 / audited : 0.0;
+        std::cout << "Requisições RPC: " << stats.requests << "\n";
+        std::cout << "Conexões TCP abertas: " << stats.connects
+                  << " (" << std::fixed << std::setprecision(2) << per_k << " por 1k blocos)\n";
+        log("[INFO] RPC: " + std::to_string(stats.requests) + " requisições, "
+            + std::to_string(stats.connects) + " conexões TCP abertas");
+        if (retries_done > 0) std::cout << "Novas tentativas: " << retries_done << "\n";
+        if (rpc_node_count() > 1) {
+            for (const auto& n : get_rpc_node_stats()) {
+                std::stringstream ss;
+                ss << n.url << ": " << n.requests << " requisições, " << n.failures << " falhas, média "
+                   << std::fixed << std::setprecision(1) << n.mean_ms << " ms, p95 " << n.p95_ms << " ms, "
+                   << n.hedges << " duplicados (" << n.hedges_won << " vencidos)";
+                std::cout << "Nó " << ss.str() << "\n";
+                log("[INFO] Nó " + ss.str());
+            }
+        }
+        if (fee_audit) {
+            std::stringstream ss;
+            ss << emission.checked() << " blocos conferidos, " << emission.mismatches() << " com Reward != Base+Fees, "
+               << emission.unverified() << " sem conferência";
+            if (emission.generated()) ss << "; moedas geradas " << *emission.generated();
+            std::cout << "Base + taxas: " << ss.str() << "\n";
+            log("[INFO] Base + taxas: " + ss.str());
+        }
+        if (single_block < 0 && linker.checked() + links_inside > 0) {
+            std::stringstream ss;
+            ss << links_inside + linker.checked() << " conferidas (" << linker.checked() << " entre lotes), "
+               << link_breaks_inside + linker.breaks() << " quebradas, " << link_refetches << " lotes buscados de novo";
+            std::cout << "Ligação prev_hash: " << ss.str() << "\n";
+            log("[INFO] Ligação prev_hash: " + ss.str());
+        }
+        if (quorum) {
+            std::cout << "Divergências entre nós: " << quorum_disagreements << "\n";
+            log("[INFO] Divergências entre nós: " + std::to_string(quorum_disagreements.load()));
+        }
+        if (cache) {
+            CacheStats cs = cache->stats();
+            std::stringstream ss;
+            ss << cs.hits << " acertos, " << cs.misses << " ausentes, " << cs.stale << " reorganizados";
+            std::cout << "Cache: " << ss.str() << "\n";
+            log("[INFO] Cache " + cache_path + ": " + ss.str());
+        }
+        if (controller && adaptive && !offline) {
+            std::cout << "Concorrência adaptativa: limite final " << controller->limit()
+                      << " (pico " << controller->peak_limit() << ", " << controller->decreases() << " reduções)\n";
+        }
+        if (!failed_heights.empty()) {
+            std::string list = format_height_ranges(failed_heights);
+            std::cout << "Blocos com falha definitiva (" << failed_heights.size() << "): " << list << "\n";
+            log("[ERRO] Blocos com falha definitiva (" + std::to_string(failed_heights.size()) + "): " + list);
+        }
+        if (track_state && state.tip().height >= 0) {
+            std::cout << "Auditado em sequência até o bloco " << state.tip().height
+                      << " (supply " << state.tip().supply;
+            if (state.tip().fees) std::cout << ", taxas " << *state.tip().fees;
+            std::cout << ")\n";
+        }
+        if (follow) {
+            std::stringstream ss;
+            ss << follow_latencies.size() << " blocos novos, " << follow_reorgs << " reorganizações ("
+               << follow_replaced << " blocos auditados de novo)";
+            if (!follow_latencies.empty()) {
+                std::vector<double> sorted = follow_latencies;
+                std::sort(sorted.begin(), sorted.end());
+                double sum = 0;
+                for (double ms : sorted) sum += ms;
+                ss << "; latência até o CSV: média " << std::fixed << std::setprecision(1) << sum / sorted.size()
+                   << " ms, p95 " << sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)] << " ms, máx "
+                   << sorted.back() << " ms";
+            }
+            std::cout << "Acompanhamento: " << ss.str() << "\n";
+            log("[INFO] Acompanhamento: " + ss.str());
+        }
+        if (log_dropped_count() > 0) {
+            std::cout << "Mensagens de log descartadas (buffer cheio): " << log_dropped_count() << "\n";
+        }
+    }
     std::cout << "------------------------\n";
     log("[INFO] Auditoria finalizada. Resultados salvos em: " + csv_path);
 
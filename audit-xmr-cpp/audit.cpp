@@ -1,81 +1,77 @@
 #include "audit.hpp"
 #include "rpc.hpp"
+#include "log.hpp"
 #include <sstream>
 #include <cmath> // Para std::abs
 
-using json = nlohmann::json;
-
 extern std::string g_log_path; // Definido em audit-xmr.cpp para acesso global
 
-std::optional<AuditResult> audit_block(int height) {
+AuditResult audit_fields(int height, const BlockFields& block) {
     AuditResult result;
     result.height = height;
-
-    std::stringstream ss;
-    ss << "[DEBUG] Auditoria iniciada para bloco " << height;
-    log_message(g_log_path, ss.str(), false);
-
-    auto block_info = get_block_info(height);
-    if (block_info.is_null()) {
-        ss.str("");
-        ss << "[ERRO] Falha ao obter bloco " << height;
-        log_message(g_log_path, ss.str(), false);
-        return std::nullopt;
+    if (!hash_from_hex(block.hash, result.hash)) {
+        result.hash = {};
+        result.add_issue(ISSUE_INVALID_HASH);
+        log_message(g_log_path, "[AVISO] Bloco " + std::to_string(height) + " com hash inválido: " + block.hash);
     }
+    LOG_DEBUG(g_log_path, "[DEBUG] Bloco " + std::to_string(height) + " obtido com hash " + block.hash);
 
-    result.hash = block_info["block_header"]["hash"];
-    ss.str("");
-    ss << "[DEBUG] Bloco " << height << " obtido com hash " << result.hash;
-    log_message(g_log_path, ss.str(), false);
-
-    // Processa o JSON do bloco para extrair os dados da transação coinbase
-    json block_json = json::parse(block_info["json"].get<std::string>());
-    json miner_tx = block_json["miner_tx"];
-
-    uint64_t coinbase_sum = 0;
-    for (const auto& vout : miner_tx["vout"]) {
-        coinbase_sum += vout["amount"].template get<uint64_t>(); // Uso de 'template' para evitar ambiguidades
-    }
-    ss.str("");
-    ss << "[DEBUG] Saídas CoinBase bloco " << height << ": " << coinbase_sum;
-    log_message(g_log_path, ss.str(), false);
+    uint64_t coinbase_sum = block.coinbase_sum;
+    LOG_DEBUG(g_log_path, "[DEBUG] Saídas CoinBase bloco " + std::to_string(height) + ": " + std::to_string(coinbase_sum));
 
     // Como o cálculo do supply se baseia apenas na coinbase,
     // quaisquer transações adicionais (tx_hashes) são ignoradas.
     uint64_t tx_outputs = 0;
-    ss.str("");
-    ss << "[DEBUG] Total saídas TX bloco " << height << ": " << tx_outputs;
-    log_message(g_log_path, ss.str(), false);
+    LOG_DEBUG(g_log_path, "[DEBUG] Total saídas TX bloco " + std::to_string(height) + ": " + std::to_string(tx_outputs));
 
-    uint64_t reward = block_info["block_header"]["reward"].get<uint64_t>();
+    uint64_t reward = block.reward;
     result.real_reward = reward;
     result.coinbase_outputs = coinbase_sum;
     result.total_mined = coinbase_sum + tx_outputs;
 
-    ss.str("");
-    ss << "[DEBUG] Recompensa real bloco " << height << ": " << reward
-       << ", Total minerado: " << result.total_mined;
-    log_message(g_log_path, ss.str(), false);
+    LOG_DEBUG(g_log_path, "[DEBUG] Recompensa real bloco " + std::to_string(height) + ": " + std::to_string(reward)
+              + ", Total minerado: " + std::to_string(result.total_mined));
 
     // Verificações simples para garantir a consistência dos dados
     const uint64_t TOLERANCE = 1e9;
     if (std::abs((int64_t)(reward - coinbase_sum)) > TOLERANCE) {
-        result.issues.push_back("Reward != CoinBase");
+        result.add_issue(ISSUE_REWARD_COINBASE);
     }
     if (std::abs((int64_t)(reward - result.total_mined)) > TOLERANCE) {
-        result.issues.push_back("Reward != TotalMined");
+        result.add_issue(ISSUE_REWARD_TOTAL);
     }
-    if (miner_tx["vin"].size() != 1 ||
-        miner_tx["vin"][0]["gen"]["height"].get<int>() != height) {
-        result.issues.push_back("CoinBase inválida");
+    if (block.vin_count != 1 || block.gen_height != height) {
+        result.add_issue(ISSUE_INVALID_COINBASE);
+    }
+    // O hash informado pelo nó tem que ser o id calculado do próprio blob
+    if (block.computed_id && *block.computed_id != result.hash) {
+        result.add_issue(ISSUE_BLOCK_ID);
+        log_message(g_log_path, "[AVISO] Bloco " + std::to_string(height) + ": hash " + block.hash
+                    + " difere do id calculado do blob " + to_hex(block.computed_id->data(), 32));
     }
 
-    result.status = result.issues.empty() ? "OK" : "Discrepância";
+    result.major_version = block.major_version;
+    result.weight = block.weight;
+    result.fees = block.fees;
+    result.generated = block.generated;
+    Hash32 prev;
+    if (!block.prev_hash.empty() && hash_from_hex(block.prev_hash, prev)) result.prev_hash = prev;
 
-    ss.str("");
-    ss << "[DEBUG] Resultado bloco " << height << ": status=" << result.status
-       << ", issues=" << result.issues_string();
-    log_message(g_log_path, ss.str(), true); // Adiciona separador ao final do processamento do bloco
+    LOG_DEBUG(g_log_path, "[DEBUG] Resultado bloco " + std::to_string(height) + ": status=" + status_name(result.status())
+              + ", issues=" + result.issues_string(), true); // Adiciona separador ao final do processamento do bloco
 
     return result;
 }
+
+std::optional<AuditResult> audit_block(int height) {
+    LOG_DEBUG(g_log_path, "[DEBUG] Auditoria iniciada para bloco " + std::to_string(height));
+
+    BlockFields block;
+    if (!get_block_fields(height, block)) {
+        std::stringstream ss;
+        ss << "[ERRO] Falha ao obter bloco " << height;
+        log_message(g_log_path, ss.str(), false);
+        return std::nullopt;
+    }
+    return audit_fields(height, block);
+}
@@ -0,0 +1,95 @@
+// audit_result.cpp
+#include "audit_result.hpp"
+
+const char* issue_name(AuditIssue issue) {
+    switch (issue) {
+    case ISSUE_REWARD_COINBASE: return "Reward != CoinBase";
+    case ISSUE_REWARD_TOTAL: return "Reward != TotalMined";
+    case ISSUE_INVALID_COINBASE: return "CoinBase inválida";
+    case ISSUE_NODE_DIVERGENCE: return "Divergência entre nós";
+    case ISSUE_BASE_FEES: return "Reward != Base+Fees";
+    case ISSUE_BLOCK_ID: return "Hash != Id do blob";
+    case ISSUE_CHAIN_LINK: return "PrevHash != Hash anterior";
+    case ISSUE_INVALID_HASH: return "Hash inválido";
+    }
+    return "?";
+}
+
+bool parse_issues(std::string_view text, uint32_t& issues) {
+    issues = 0;
+    if (text == "Nenhum") return true;
+    while (!text.empty()) {
+        size_t bar = text.find('|');
+        std::string_view name = text.substr(0, bar);
+        uint32_t found = 0;
+        for (int k = 0; k < 32 && !found; ++k) {
+            if (name == issue_name(static_cast<AuditIssue>(1u << k))) found = 1u << k;
+        }
+        if (!found || name == "?") return false;
+        issues |= found;
+        if (bar == std::string_view::npos) return true;
+        text.remove_prefix(bar + 1);
+    }
+    return false;
+}
+
+const char* status_name(AuditStatus status) {
+    return status == AuditStatus::Ok ? "OK" : "Discrepância";
+}
+
+std::string AuditResult::hash_hex() const {
+    return to_hex(hash.data(), hash.size());
+}
+
+std::string AuditResult::issues_string() const {
+    std::string s;
+    for (uint32_t bits = issues; bits; bits &= bits - 1) {
+        if (!s.empty()) s += '|';
+        s += issue_name(static_cast<AuditIssue>(bits & -bits));
+    }
+    return s;
+}
+
+void AuditBatch::push_back(const AuditResult& r) {
+    height.push_back(r.height);
+    hash.push_back(r.hash);
+    real_reward.push_back(r.real_reward);
+    coinbase_outputs.push_back(r.coinbase_outputs);
+    total_mined.push_back(r.total_mined);
+    issues.push_back(r.issues);
+    fees.push_back(r.fees.value_or(UNKNOWN));
+    generated_after.push_back(r.generated_after.value_or(UNKNOWN));
+}
+
+void AuditBatch::append(const AuditBatch& other) {
+    height.insert(height.end(), other.height.begin(), other.height.end());
+    hash.insert(hash.end(), other.hash.begin(), other.hash.end());
+    real_reward.insert(real_reward.end(), other.real_reward.begin(), other.real_reward.end());
+    coinbase_outputs.insert(coinbase_outputs.end(), other.coinbase_outputs.begin(), other.coinbase_outputs.end());
+    total_mined.insert(total_mined.end(), other.total_mined.begin(), other.total_mined.end());
+    issues.insert(issues.end(), other.issues.begin(), other.issues.end());
+    fees.insert(fees.end(), other.fees.begin(), other.fees.end());
+    generated_after.insert(generated_after.end(), other.generated_after.begin(), other.generated_after.end());
+}
+
+void AuditBatch::clear() {
+    height.clear();
+    hash.clear();
+    real_reward.clear();
+    coinbase_outputs.clear();
+    total_mined.clear();
+    issues.clear();
+    fees.clear();
+    generated_after.clear();
+}
+
+void AuditBatch::swap(AuditBatch& other) {
+    height.swap(other.height);
+    hash.swap(other.hash);
+    real_reward.swap(other.real_reward);
+    coinbase_outputs.swap(other.coinbase_outputs);
+    total_mined.swap(other.total_mined);
+    issues.swap(other.issues);
+    fees.swap(other.fees);
+    generated_after.swap(other.generated_after);
+}
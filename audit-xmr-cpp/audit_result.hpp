@@ -0,0 +1,80 @@
+// audit_result.hpp
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "block_binary.hpp"
+
+// Resultados da auditoria, sem nada de RPC: também servem às ferramentas
+// que só leem o CSV ou o arquivo colunar (audit-xmr-query)
+
+// Problemas de um bloco, como bits de AuditResult::issues. O texto só é
+// montado na saída, na ordem dos bits (a mesma em que são detectados).
+enum AuditIssue : uint32_t {
+    ISSUE_REWARD_COINBASE  = 1u << 0, // "Reward != CoinBase"
+    ISSUE_REWARD_TOTAL     = 1u << 1, // "Reward != TotalMined"
+    ISSUE_INVALID_COINBASE = 1u << 2, // "CoinBase inválida"
+    ISSUE_NODE_DIVERGENCE  = 1u << 3, // "Divergência entre nós" (--quorum)
+    ISSUE_BASE_FEES        = 1u << 4, // "Reward != Base+Fees" (--fees)
+    ISSUE_BLOCK_ID         = 1u << 5, // "Hash != Id do blob" (--verify-id)
+    ISSUE_CHAIN_LINK       = 1u << 6, // "PrevHash != Hash anterior"
+    ISSUE_INVALID_HASH     = 1u << 7, // "Hash inválido" (coluna Hash zerada)
+};
+const char* issue_name(AuditIssue issue);
+// Texto da coluna Problemas ("Nenhum" ou nomes separados por '|') de volta em bits
+bool parse_issues(std::string_view text, uint32_t& issues);
+
+enum class AuditStatus : uint8_t { Ok, Discrepancy };
+const char* status_name(AuditStatus status); // "OK" ou "Discrepância"
+
+// Resultado da auditoria de um bloco, sem alocações: hash em binário,
+// problemas em bits e o status derivado deles
+struct AuditResult {
+    int height = 0;
+    Hash32 hash{};
+    uint64_t real_reward = 0;
+    uint64_t coinbase_outputs = 0;
+    uint64_t total_mined = 0;
+    uint32_t issues = 0; // AuditIssue
+
+    // Para a conferência da emissão (emission.hpp), copiados de BlockFields
+    uint64_t major_version = 0;
+    uint64_t weight = 0;
+    std::optional<uint64_t> fees;
+    std::optional<uint64_t> generated;       // Antes do bloco, quando a fonte informa
+    std::optional<uint64_t> generated_after; // Até o bloco, inclusive, se exato (coluna MoedasGeradas)
+
+    // prev_hash do bloco, para a conferência da ligação com o anterior (linkage.hpp)
+    std::optional<Hash32> prev_hash;
+
+    void add_issue(AuditIssue issue) { issues |= issue; }
+    AuditStatus status() const { return issues ? AuditStatus::Discrepancy : AuditStatus::Ok; }
+
+    std::string hash_hex() const;
+    std::string issues_string() const; // Separados por '|'; vazio sem problemas
+};
+
+// Resultados em colunas (estrutura de arrays), do escoamento da janela de
+// reordenação até o escritor do CSV. clear() mantém a capacidade, então um
+// lote reaproveitado não aloca de novo.
+struct AuditBatch {
+    static constexpr uint64_t UNKNOWN = ~uint64_t(0); // Taxas ou moedas geradas desconhecidas
+
+    std::vector<int> height;
+    std::vector<Hash32> hash;
+    std::vector<uint64_t> real_reward;
+    std::vector<uint64_t> coinbase_outputs;
+    std::vector<uint64_t> total_mined;
+    std::vector<uint32_t> issues;
+    std::vector<uint64_t> fees;
+    std::vector<uint64_t> generated_after;
+
+    size_t size() const { return height.size(); }
+    bool empty() const { return height.empty(); }
+    void push_back(const AuditResult& r);
+    void append(const AuditBatch& other);
+    void clear();
+    void swap(AuditBatch& other);
+};
@@ -0,0 +1,429 @@
+// bench_e2e.cpp
+// Benchmark de ponta a ponta contra o mock-monerod embutido: mede o audit_block
+// no próprio processo e os executáveis audit-xmr (threads, async, batch, bin,
+// raw, este sobre um blockchain.raw gerado do mock, e nodes, com um segundo
+// mock em --servers) e audit-xmr-check como processos filhos. Cada caso imprime uma linha JSON com
+// blocos/s, requisições, latências p50/p99 e pico de memória (ru_maxrss).
+// Os casos follow e follow_fees rodam o --follow contra um mock que cresce e
+// se reorganiza e comparam o CSV com o de um --range da cadeia final;
+// chain_main mede o parse_chain_main das mensagens ZMQ.
+//   ./audit-xmr-bench --blocks 5000 --latency 5 --jitter 2 --error-rate 0.01
+//   ./audit-xmr-bench --cases threads,nodes --stall 0.02 200   # cauda lenta: efeito do duplicado
+#include "audit.hpp"
+#include "follow.hpp"
+#include "mock_server.hpp"
+#include "rpc.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+std::string g_log_path = "/dev/null";
+
+struct BenchConfig {
+    int blocks = 2000;
+    int start = 1000000;  // Perto do v2: cobre saídas decompostas e a mudança de alvo
+    double latency_ms = 2;
+    double jitter_ms = 1;
+    double error_rate = 0;
+    double stall_rate = 0;
+    double stall_ms = 0;
+    int threads = 8;
+    std::string bin_dir;  // Onde estão audit-xmr e audit-xmr-check
+    std::string work_dir;
+};
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void report(const std::string& name, int blocks, double seconds, uint64_t requests,
+                   const std::vector<double>& latencies, long peak_rss_kb, int exit_code,
+                   const json& extra = json::object()) {
+    json line = {
+        {"bench", "e2e"}, {"case", name}, {"blocks", blocks}, {"seconds", seconds},
+        {"blocks_per_sec", seconds > 0 ? blocks / seconds : 0}, {"rpc_requests", requests},
+        {"p50_ms", percentile(latencies, 0.50)}, {"p99_ms", percentile(latencies, 0.99)},
+        {"peak_rss_kb", peak_rss_kb}, {"exit_code", exit_code}
+    };
+    line.update(extra);
+    std::cout << line.dump() << std::endl;
+}
+
+// audit_block no próprio processo, com N threads puxando alturas de um contador.
+// As latências são as de cada chamada completa (RPC + parse + auditoria).
+static void bench_in_process(const BenchConfig& config, MockServer& server) {
+    set_rpc_url("http://127.0.0.1:" + std::to_string(server.port()) + "/json_rpc");
+    server.take_service_times();
+    uint64_t before = server.requests();
+
+    std::atomic<int> next(config.start);
+    std::atomic<int> failed(0);
+    int end = config.start + config.blocks;
+    std::vector<std::vector<double>> per_thread(config.threads);
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int h = next++; h < end; h = next++) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (!audit_block(h)) failed++;
+                per_thread[t].push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - t0).count());
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::vector<double> latencies;
+    for (auto& v : per_thread) latencies.insert(latencies.end(), v.begin(), v.end());
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    report("audit_block", config.blocks - failed, seconds, server.requests() - before,
+           latencies, usage.ru_maxrss, failed ? 1 : 0);
+}
+
+// Inicia um binário num diretório próprio, com stdout/stderr em run.log
+static pid_t spawn_child(const std::string& dir, const std::vector<std::string>& args) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(dir.c_str()) != 0) _exit(127);
+        int fd = open("run.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        int null_fd = open("/dev/null", O_RDONLY);
+        if (null_fd >= 0) dup2(null_fd, STDIN_FILENO);
+        std::vector<char*> argv;
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    return pid;
+}
+
+static int wait_child(pid_t pid, long& peak_rss_kb) {
+    int status = 0;
+    rusage usage{};
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0) return -1;
+    peak_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int run_child(const std::string& dir, const std::vector<std::string>& args, long& peak_rss_kb) {
+    return wait_child(spawn_child(dir, args), peak_rss_kb);
+}
+
+static void bench_child(const std::string& name, const BenchConfig& config, MockServer& server,
+                        const std::vector<std::string>& args, const std::string& dir) {
+    fs::create_directories(dir);
+    server.take_service_times();
+    uint64_t before = server.requests();
+    long peak_rss_kb = 0;
+    auto started = std::chrono::steady_clock::now();
+    int code = run_child(dir, args, peak_rss_kb);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    // Sem acesso às latências do cliente: usa o tempo de atendimento medido no mock
+    report(name, config.blocks, seconds, server.requests() - before, server.take_service_times(),
+           peak_rss_kb, code);
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Altura da última linha completa do CSV; -1 enquanto só há o cabeçalho
+static int last_csv_height(const std::string& csv) {
+    std::ifstream in(csv, std::ios::binary);
+    if (!in.is_open()) return -1;
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    std::streamoff window = std::min<std::streamoff>(size, 512);
+    if (window < 2) return -1;
+    std::string tail(static_cast<size_t>(window), '\0');
+    in.seekg(size - window);
+    if (!in.read(&tail[0], window) || tail.back() != '\n') return -1;
+    size_t start = tail.rfind('\n', tail.size() - 2);
+    start = start == std::string::npos ? 0 : start + 1;
+    if (tail[start] < '0' || tail[start] > '9') return -1;
+    return std::atoi(tail.c_str() + start);
+}
+
+// --follow contra um mock que revela um bloco a cada grow_ms e se reorganiza
+// perto do fim. Quando a linha do último bloco chega ao CSV, o audit-xmr
+// recebe SIGINT, e o CSV tem que ser igual ao de um --range da cadeia final.
+// A cadeia inicial é curta para o acompanhamento já estar no topo quando a
+// reorganização acontece.
+static void bench_follow(const std::string& name, const BenchConfig& config, const std::string& audit,
+                         const std::vector<std::string>& extra, const std::string& dir) {
+    const int grown = 200; // Blocos revelados durante o acompanhamento
+    const double grow_ms = 15;
+    MockOptions mock;
+    mock.port = 0;
+    mock.height = 2 * grown;
+    mock.latency_ms = config.latency_ms;
+    mock.jitter_ms = config.jitter_ms;
+    mock.grow_start = mock.height - grown;
+    mock.grow_ms = grow_ms;
+    mock.reorg_height = mock.height - 60;
+    mock.reorg_at = mock.height - 40;
+    // Sem erros injetados: um bloco com falha definitiva faria os CSVs diferirem
+    MockServer server(mock);
+    std::string error;
+    if (!server.start(&error)) {
+        std::cerr << "[ERRO] Falha ao iniciar o mock do " << name << ": " << error << "\n";
+        return;
+    }
+    fs::create_directories(dir);
+    std::string server_arg = "127.0.0.1:" + std::to_string(server.port());
+    std::string threads = std::to_string(config.threads);
+    std::vector<std::string> args = { audit, "--server", server_arg, "--follow", "--poll-ms", "20",
+                                      "--threads", threads, "--output-dir", "out" };
+    args.insert(args.end(), extra.begin(), extra.end());
+    std::string csv = (fs::path(dir) / "out" / "auditoria_monero.csv").string();
+
+    auto started = std::chrono::steady_clock::now();
+    pid_t pid = spawn_child(dir, args);
+    // O mock leva grown * grow_ms para chegar ao topo; a folga cobre a auditoria inicial
+    auto deadline = started + std::chrono::milliseconds(static_cast<int>(grown * grow_ms)) + std::chrono::seconds(120);
+    bool reached = false;
+    while (pid > 0 && !reached && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reached = last_csv_height(csv) == mock.height - 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (pid > 0) kill(pid, SIGINT);
+    long peak_rss_kb = 0;
+    int code = wait_child(pid, peak_rss_kb);
+    uint64_t requests = server.requests();
+    std::vector<double> latencies = server.take_service_times();
+
+    // Referência: a cadeia final inteira com --range, no mesmo mock
+    std::string range_dir = (fs::path(dir) / "range").string();
+    fs::create_directories(range_dir);
+    std::vector<std::string> range_args = { audit, "--server", server_arg, "--range", "0",
+                                            std::to_string(mock.height - 1), "--threads", threads,
+                                            "--output-dir", "out" };
+    range_args.insert(range_args.end(), extra.begin(), extra.end());
+    long ignored = 0;
+    run_child(range_dir, range_args, ignored);
+    std::string followed = read_file(csv);
+    bool matches = reached && !followed.empty() &&
+                   followed == read_file((fs::path(range_dir) / "out" / "auditoria_monero.csv").string());
+    bool reorg_seen = read_file((fs::path(dir) / "run.log").string()).find("Reorganização:") != std::string::npos;
+    server.stop();
+    report(name, mock.height, seconds, requests, latencies, peak_rss_kb, code,
+           { {"reached_tip", reached}, {"reorg_seen", reorg_seen}, {"matches_range", matches} });
+}
+
+// parse_chain_main sobre mensagens como as do publicador: uma por bloco novo
+// e, a cada 16, uma de reorganização com 20 ids desde o ponto de troca. As
+// malformadas no fim têm que ser recusadas sem exceção.
+static void bench_chain_main(const BenchConfig& config) {
+    std::vector<std::string> messages;
+    std::vector<int> tips;
+    for (int k = 0; k < 64; ++k) {
+        int first = config.start + k;
+        int count = k % 16 == 15 ? 20 : 1;
+        json ids = json::array();
+        for (int i = 0; i < count; ++i) ids.push_back(std::string(64, "0123456789abcdef"[(first + i) % 16]));
+        json body = { {"first_height", first}, {"first_prev_id", std::string(64, '0')}, {"ids", ids} };
+        messages.push_back("json-minimal-chain_main:" + body.dump());
+        tips.push_back(first + count - 1);
+    }
+    const std::string good_id(64, 'a');
+    const std::vector<std::string> malformed = {
+        R"(json-minimal-chain_main:{"first_height":"10","ids":[")" + good_id + R"("]})",
+        R"(json-minimal-chain_main:{"first_height":1.5,"ids":[")" + good_id + R"("]})",
+        R"(json-minimal-chain_main:{"first_height":-1,"ids":[")" + good_id + R"("]})",
+        R"(json-minimal-chain_main:{"first_height":10,"ids":["abc"]})",
+        R"(json-minimal-chain_main:{"first_height":10,"ids":[")" + std::string(64, 'z') + R"("]})",
+        R"(json-minimal-chain_main:[1,2,3])",
+    };
+    int accepted_bad = 0;
+    for (const auto& m : malformed) {
+        ChainTip tip;
+        if (parse_chain_main(m, tip)) accepted_bad++;
+    }
+    const int rounds = 2000;
+    int failed = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t k = 0; k < messages.size(); ++k) {
+            ChainTip tip;
+            if (!parse_chain_main(messages[k], tip) || tip.height != tips[k]) failed++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    // "blocks" aqui são mensagens
+    report("chain_main", rounds * static_cast<int>(messages.size()), seconds, 0, {}, usage.ru_maxrss,
+           failed || accepted_bad ? 1 : 0, { {"failed", failed}, {"accepted_bad", accepted_bad} });
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    config.bin_dir = fs::absolute(argv[0]).parent_path().string();
+    std::vector<std::string> cases = { "audit_block", "threads", "async", "batch", "bin", "raw", "nodes", "check",
+                                       "follow", "follow_fees", "chain_main" };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--blocks" && i + 1 < argc) {
+            config.blocks = std::stoi(argv[++i]);
+        } else if (arg == "--start" && i + 1 < argc) {
+            config.start = std::stoi(argv[++i]);
+        } else if (arg == "--latency" && i + 1 < argc) {
+            config.latency_ms = std::stod(argv[++i]);
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            config.jitter_ms = std::stod(argv[++i]);
+        } else if (arg == "--error-rate" && i + 1 < argc) {
+            config.error_rate = std::stod(argv[++i]);
+        } else if (arg == "--stall" && i + 2 < argc) {
+            config.stall_rate = std::stod(argv[++i]);
+            config.stall_ms = std::stod(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            config.threads = std::stoi(argv[++i]);
+        } else if (arg == "--bin-dir" && i + 1 < argc) {
+            config.bin_dir = argv[++i];
+        } else if (arg == "--cases" && i + 1 < argc) {
+            cases.clear();
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t comma = std::min(list.find(',', pos), list.size());
+                if (comma > pos) cases.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "\nUso: ./audit-xmr-bench [opções]\n"
+                      << "  --blocks <N>         Blocos por caso (padrão 2000)\n"
+                      << "  --start <altura>     Primeira altura (padrão 1000000)\n"
+                      << "  --latency <ms>       Latência do mock (padrão 2)\n"
+                      << "  --jitter <ms>        Jitter do mock (padrão 1)\n"
+                      << "  --error-rate <f>     Fração de respostas HTTP 500 (padrão 0)\n"
+                      << "  --stall <f> <ms>     Fração de respostas com atraso extra de ms no mock\n"
+                      << "  --threads <N>        Threads do audit_block e do audit-xmr (padrão 8)\n"
+                      << "  --bin-dir <dir>      Diretório de audit-xmr e audit-xmr-check\n"
+                      << "  --cases <lista>      audit_block,threads,async,batch,bin,raw,nodes,check,\n"
+                      << "                       follow,follow_fees,chain_main\n";
+            return 0;
+        }
+    }
+
+    char tmpl[] = "/tmp/audit-xmr-bench.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        std::cerr << "[ERRO] Não foi possível criar o diretório temporário.\n";
+        return 1;
+    }
+    config.work_dir = tmpl;
+
+    MockOptions mock;
+    mock.port = 0;
+    mock.height = config.start + config.blocks + 1;
+    mock.latency_ms = config.latency_ms;
+    mock.jitter_ms = config.jitter_ms;
+    mock.error_rate = config.error_rate;
+    mock.stall_rate = config.stall_rate;
+    mock.stall_ms = config.stall_ms;
+    MockServer server(mock);
+    std::string error;
+    if (!server.start(&error)) {
+        std::cerr << "[ERRO] Falha ao iniciar o mock: " << error << "\n";
+        return 1;
+    }
+    std::cerr << "[INFO] Mock em 127.0.0.1:" << server.port() << ", saída em " << config.work_dir << "\n";
+
+    std::string server_arg = "127.0.0.1:" + std::to_string(server.port());
+    std::string audit = (fs::path(config.bin_dir) / "audit-xmr").string();
+    std::string check = (fs::path(config.bin_dir) / "audit-xmr-check").string();
+    std::string first = std::to_string(config.start);
+    std::string last = std::to_string(config.start + config.blocks - 1);
+    std::string threads = std::to_string(config.threads);
+    auto audit_args = [&](std::vector<std::string> extra) {
+        std::vector<std::string> args = { audit, "--server", server_arg, "--range", first, last,
+                                          "--threads", threads, "--output-dir", "out" };
+        args.insert(args.end(), extra.begin(), extra.end());
+        return args;
+    };
+    auto dir_of = [&](const std::string& name) { return (fs::path(config.work_dir) / name).string(); };
+
+    for (const auto& name : cases) {
+        if (name == "audit_block") {
+            bench_in_process(config, server);
+        } else if (name == "threads") {
+            bench_child(name, config, server, audit_args({ "--engine", "threads" }), dir_of(name));
+        } else if (name == "async") {
+            bench_child(name, config, server, audit_args({ "--engine", "async" }), dir_of(name));
+        } else if (name == "batch") {
+            bench_child(name, config, server, audit_args({ "--source", "batch" }), dir_of(name));
+        } else if (name == "bin") {
+            bench_child(name, config, server, audit_args({ "--source", "bin" }), dir_of(name));
+        } else if (name == "raw") {
+            // Sem RPC: mede a leitura do arquivo mapeado, o parse e o Keccak dos ids
+            fs::create_directories(dir_of(name));
+            std::string raw = (fs::path(dir_of(name)) / "blockchain.raw").string();
+            if (!server.write_raw(raw, config.start, config.start + config.blocks - 1, &error)) {
+                std::cerr << "[ERRO] Falha ao gravar " << raw << ": " << error << "\n";
+                continue;
+            }
+            bench_child(name, config, server, audit_args({ "--input-raw", raw }), dir_of(name));
+        } else if (name == "nodes") {
+            // Um segundo mock igual ao primeiro: balanceamento e duplicado após o p95.
+            // As requisições contadas são só as do primeiro nó.
+            MockServer second(mock);
+            if (!second.start(&error)) {
+                std::cerr << "[ERRO] Falha ao iniciar o segundo mock: " << error << "\n";
+                continue;
+            }
+            std::string servers = server_arg + ",127.0.0.1:" + std::to_string(second.port());
+            bench_child(name, config, server, audit_args({ "--servers", servers }), dir_of(name));
+            second.stop();
+        } else if (name == "check") {
+            // Revalida o CSV do caso threads (ou gera um, se ele não rodou)
+            std::string csv = (fs::path(dir_of("threads")) / "out" / "auditoria_monero.csv").string();
+            if (!fs::exists(csv)) {
+                long ignored = 0;
+                fs::create_directories(dir_of("threads"));
+                run_child(dir_of("threads"), audit_args({ "--engine", "threads" }), ignored);
+            }
+            bench_child(name, config, server, { check, "--server", server_arg, "--threads", threads, csv }, dir_of(name));
+        } else if (name == "follow") {
+            bench_follow(name, config, audit, {}, dir_of(name));
+        } else if (name == "follow_fees") {
+            bench_follow(name, config, audit, { "--fees" }, dir_of(name));
+        } else if (name == "chain_main") {
+            bench_chain_main(config);
+        } else {
+            std::cerr << "[AVISO] Caso desconhecido: " << name << "\n";
+        }
+    }
+
+    server.stop();
+    return 0;
+}
@@ -0,0 +1,301 @@
+// bench_parse.cpp
+// Microbenchmark da extração de campos de get_block: scanner sob demanda contra o
+// caminho DOM original. Mede tempo e alocações por bloco em duas respostas no
+// formato do monerod: um bloco do início da cadeia (miner_tx v1 com saídas
+// decompostas) e um bloco recente (miner_tx v2 com tagged_key e muitas tx).
+// Mede também o Keccak-256 da verificação de id (--verify-id), uma mensagem
+// por vez contra keccak256_many, em hashes/s, e os ids de blocos inteiros
+// por block_id contra block_ids. Saída em JSON, uma linha por caso.
+#include "block_parse.hpp"
+#include "block_binary.hpp"
+#include "keccak.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static std::atomic<uint64_t> g_allocations(0);
+static std::atomic<uint64_t> g_allocated_bytes(0);
+
+// Fora de linha: inlinados no ponto de chamada, o GCC enxerga malloc() de um
+// lado e delete do outro e acusa -Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static std::string hex_of(uint64_t seed, size_t bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s(bytes * 2, '0');
+    uint64_t x = seed * 0x9e3779b97f4a7c15ULL + 1;
+    for (size_t i = 0; i < s.size(); ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        s[i] = digits[x & 15];
+    }
+    return s;
+}
+
+// Monta uma resposta de get_block com a mesma estrutura que o monerod envia
+static std::string make_response(int height, int major_version, int tx_version,
+                                 const std::vector<uint64_t>& amounts, int tx_count) {
+    json miner_tx;
+    miner_tx["version"] = tx_version;
+    miner_tx["unlock_time"] = height + 60;
+    miner_tx["vin"] = json::array({ { {"gen", { {"height", height} } } } });
+    miner_tx["vout"] = json::array();
+    uint64_t reward = 0;
+    for (size_t i = 0; i < amounts.size(); ++i) {
+        json target;
+        if (major_version >= 15) {
+            target["tagged_key"] = { {"key", hex_of(height * 31 + i, 32)}, {"view_tag", hex_of(i, 1)} };
+        } else {
+            target["key"] = hex_of(height * 31 + i, 32);
+        }
+        miner_tx["vout"].push_back({ {"amount", amounts[i]}, {"target", target} });
+        reward += amounts[i];
+    }
+    std::vector<int> extra;
+    for (int i = 0; i < 44; ++i) extra.push_back((i * 37 + height) & 0xff);
+    miner_tx["extra"] = extra;
+    if (tx_version >= 2) miner_tx["rct_signatures"] = { {"type", 0} };
+
+    std::vector<std::string> tx_hashes;
+    for (int i = 0; i < tx_count; ++i) tx_hashes.push_back(hex_of(height * 1000 + i, 32));
+
+    json block;
+    block["major_version"] = major_version;
+    block["minor_version"] = major_version;
+    block["timestamp"] = 1397818193 + height * 120;
+    block["prev_id"] = hex_of(height - 1, 32);
+    block["nonce"] = 1234567;
+    block["miner_tx"] = miner_tx;
+    block["tx_hashes"] = tx_hashes;
+
+    json header = {
+        {"block_size", 300 + tx_count * 1500}, {"block_weight", 300 + tx_count * 1500},
+        {"cumulative_difficulty", 123456789012ULL}, {"cumulative_difficulty_top64", 0},
+        {"depth", 10}, {"difficulty", 345678901234ULL}, {"difficulty_top64", 0},
+        {"hash", hex_of(height, 32)}, {"height", height}, {"long_term_weight", 300},
+        {"major_version", major_version}, {"miner_tx_hash", hex_of(height + 7, 32)},
+        {"minor_version", major_version}, {"nonce", 1234567}, {"num_txes", tx_count},
+        {"orphan_status", false}, {"pow_hash", ""}, {"prev_hash", hex_of(height - 1, 32)},
+        {"reward", reward}, {"timestamp", 1397818193 + height * 120},
+        {"wide_cumulative_difficulty", "0x1cbe991a14"}, {"wide_difficulty", "0x507c5d6f2"}
+    };
+
+    json result = {
+        {"blob", hex_of(height, 120 + tx_count * 32)},
+        {"block_header", header},
+        {"credits", 0},
+        {"json", block.dump(2)},
+        {"miner_tx_hash", hex_of(height + 7, 32)},
+        {"status", "OK"},
+        {"top_hash", ""},
+        {"tx_hashes", tx_hashes},
+        {"untrusted", false}
+    };
+    json response = { {"id", "0"}, {"jsonrpc", "2.0"}, {"result", result} };
+    return response.dump(2);
+}
+
+static std::string bytes_of(uint64_t seed, size_t size) {
+    std::string s(size, '\0');
+    uint64_t x = seed * 0x9e3779b97f4a7c15ULL + 1;
+    for (auto& c : s) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        c = static_cast<char>(x);
+    }
+    return s;
+}
+
+// Blob de um bloco recente: miner tx v2 com uma saída tagged_key e tx_count hashes
+static std::string make_blob(uint64_t height, int tx_count) {
+    std::string b;
+    put_varint(b, 16);
+    put_varint(b, 16);
+    put_varint(b, 1397818193 + height * 120);
+    b += bytes_of(height - 1, 32);
+    b += bytes_of(height, 4);
+    put_varint(b, 2);
+    put_varint(b, height + 60);
+    put_varint(b, 1);
+    b.push_back(static_cast<char>(0xff));
+    put_varint(b, height);
+    put_varint(b, 1);
+    put_varint(b, 600000000000ULL + height);
+    b.push_back(0x03);
+    b += bytes_of(height * 31, 33);
+    put_varint(b, 44);
+    b += bytes_of(height * 7, 44);
+    b.push_back(0x00);
+    put_varint(b, tx_count);
+    for (int i = 0; i < tx_count; ++i) b += bytes_of(height * 1000 + i, 32);
+    return b;
+}
+
+// Keccak-256 de 'count' mensagens de 'size' bytes, uma a uma e em lote
+static bool bench_keccak(size_t size, size_t count, int rounds) {
+    std::vector<std::string> messages;
+    std::vector<const uint8_t*> data;
+    std::vector<size_t> sizes(count, size);
+    std::vector<std::array<uint8_t, 32>> scalar(count), many(count);
+    std::vector<uint8_t*> out;
+    for (size_t i = 0; i < count; ++i) messages.push_back(bytes_of(i + size * 100000, size));
+    for (size_t i = 0; i < count; ++i) {
+        data.push_back(reinterpret_cast<const uint8_t*>(messages[i].data()));
+        out.push_back(many[i].data());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < count; ++i) keccak256(data[i], size, scalar[i].data());
+    }
+    double scalar_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) keccak256_many(count, data.data(), sizes.data(), out.data());
+    double many_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (scalar != many) {
+        std::cerr << "[ERRO] keccak256_many diverge de keccak256 com " << size << " bytes\n";
+        return false;
+    }
+
+    double hashes = double(count) * rounds;
+    std::printf("{\"bench\":\"keccak256\",\"input_bytes\":%zu,\"impl\":\"escalar\",\"hashes_per_sec\":%.0f}\n",
+                size, hashes / scalar_s);
+    std::printf("{\"bench\":\"keccak256\",\"input_bytes\":%zu,\"impl\":\"many_%s\",\"hashes_per_sec\":%.0f}\n",
+                size, keccak_many_impl(), hashes / many_s);
+    return true;
+}
+
+// Ids de 'count' blocos com tx_count txs: block_id por bloco contra block_ids
+static bool bench_block_ids(size_t count, int tx_count, int rounds) {
+    std::vector<std::string> blobs;
+    std::vector<ParsedBlock> parsed(count);
+    std::vector<BlockBlob> views;
+    for (size_t i = 0; i < count; ++i) blobs.push_back(make_blob(3200000 + i, tx_count));
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(blobs[i].data());
+        if (!parse_block_blob(data, blobs[i].size(), parsed[i])) {
+            std::cerr << "[ERRO] Blob sintético inválido\n";
+            return false;
+        }
+        views.push_back({ data, blobs[i].size(), &parsed[i] });
+    }
+
+    std::vector<Hash32> single(count), batch;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < count; ++i) single[i] = block_id(views[i].data, views[i].size, parsed[i]);
+    }
+    double single_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) block_ids(views, batch);
+    double batch_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (single != batch) {
+        std::cerr << "[ERRO] block_ids diverge de block_id\n";
+        return false;
+    }
+
+    // Por bloco: 3 hashes da miner tx v2, tx_count pares na árvore e o blob de hashing
+    double blocks = double(count) * rounds;
+    double hashes = blocks * (tx_count + 4);
+    const std::pair<const char*, double> rows[] = { {"block_id", single_s}, {"block_ids", batch_s} };
+    for (const auto& row : rows) {
+        std::printf("{\"bench\":\"block_id\",\"txs_per_block\":%d,\"impl\":\"%s\",\"blocks_per_sec\":%.0f,"
+                    "\"hashes_per_sec\":%.0f}\n", tx_count, row.first, blocks / row.second, hashes / row.second);
+    }
+    return true;
+}
+
+struct Measurement {
+    double ns_per_block = 0;
+    double allocs_per_block = 0;
+    double bytes_per_block = 0;
+};
+
+template <typename Fn>
+static Measurement measure(const std::string& response, int iterations, Fn&& parse) {
+    BlockFields fields;
+    parse(response, fields); // Aquecimento
+
+    uint64_t allocs_before = g_allocations.load();
+    uint64_t bytes_before = g_allocated_bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        if (!parse(response, fields)) {
+            std::cerr << "[ERRO] Parse falhou durante o benchmark\n";
+            std::exit(1);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    Measurement m;
+    m.ns_per_block = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    m.allocs_per_block = double(g_allocations.load() - allocs_before) / iterations;
+    m.bytes_per_block = double(g_allocated_bytes.load() - bytes_before) / iterations;
+    return m;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    struct Case {
+        const char* name;
+        std::string response;
+    };
+    std::vector<Case> cases = {
+        // Era inicial: recompensa decomposta em várias saídas, poucas transações
+        {"early_v1", make_response(1200, 1, 1,
+            {8000000000ULL, 70000000000ULL, 300000000000ULL, 5000000000000ULL, 10000000000000ULL, 900000ULL, 40000ULL}, 2)},
+        // Era recente: uma saída tagged_key e muitas transações
+        {"recent_v16", make_response(3200000, 16, 2, {600000000000ULL + 12345678ULL}, 120)},
+    };
+
+    for (const auto& c : cases) {
+        BlockFields fast, dom;
+        if (!parse_get_block_fast(c.response, fast) || !parse_get_block_dom(c.response, dom) || fast != dom) {
+            std::cerr << "[ERRO] Scanner e DOM divergem no caso " << c.name << "\n";
+            return 1;
+        }
+
+        Measurement m_fast = measure(c.response, iterations, [](const std::string& r, BlockFields& f) {
+            return parse_get_block_fast(r, f);
+        });
+        Measurement m_dom = measure(c.response, iterations, [](const std::string& r, BlockFields& f) {
+            return parse_get_block_dom(r, f);
+        });
+
+        const std::pair<const char*, Measurement> rows[] = { {"scanner", m_fast}, {"dom", m_dom} };
+        for (const auto& row : rows) {
+            std::printf("{\"bench\":\"parse_get_block\",\"case\":\"%s\",\"parser\":\"%s\",\"response_bytes\":%zu,"
+                        "\"ns_per_block\":%.0f,\"allocs_per_block\":%.1f,\"alloc_bytes_per_block\":%.0f}\n",
+                        c.name, row.first, c.response.size(),
+                        row.second.ns_per_block, row.second.allocs_per_block, row.second.bytes_per_block);
+        }
+    }
+
+    // Pares da árvore (64 bytes) e blobs de hashing (~80 bytes) cabem num
+    // bloco de absorção; as miner txs e blobs maiores ocupam dois ou mais
+    int rounds = std::max(1, iterations / 100);
+    for (size_t size : { size_t(64), size_t(200), size_t(1000) }) {
+        if (!bench_keccak(size, 4096, rounds)) return 1;
+    }
+    for (int txs : { 0, 8, 120 }) {
+        if (!bench_block_ids(1000, txs, rounds)) return 1;
+    }
+    return 0;
+}
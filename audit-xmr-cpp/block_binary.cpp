@@ -0,0 +1,457 @@
+// block_binary.cpp
+#include "block_binary.hpp"
+#include "keccak.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+// Tags das variantes de entrada e saída (cryptonote_basic.h)
+const uint8_t TXIN_GEN = 0xff;
+const uint8_t TXIN_TO_SCRIPT = 0x00;
+const uint8_t TXIN_TO_SCRIPTHASH = 0x01;
+const uint8_t TXIN_TO_KEY = 0x02;
+const uint8_t TXOUT_TO_SCRIPT = 0x00;
+const uint8_t TXOUT_TO_SCRIPTHASH = 0x01;
+const uint8_t TXOUT_TO_KEY = 0x02;
+const uint8_t TXOUT_TO_TAGGED_KEY = 0x03;
+const uint8_t RCT_TYPE_NULL = 0x00;
+
+bool fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+bool skip(const uint8_t*& p, const uint8_t* end, uint64_t n) {
+    if (static_cast<uint64_t>(end - p) < n) return false;
+    p += n;
+    return true;
+}
+
+// vector<uint8_t> ou vector<hash>: varint com a contagem + elementos fixos
+bool skip_vector(const uint8_t*& p, const uint8_t* end, uint64_t element_size) {
+    uint64_t count;
+    if (!read_varint(p, end, count)) return false;
+    if (element_size && count > static_cast<uint64_t>(end - p) / element_size) return false;
+    return skip(p, end, count * element_size);
+}
+
+bool parse_input(const uint8_t*& p, const uint8_t* end, ParsedTx& out, bool first) {
+    if (p >= end) return false;
+    uint8_t tag = *p++;
+    switch (tag) {
+        case TXIN_GEN: {
+            uint64_t height;
+            if (!read_varint(p, end, height)) return false;
+            if (first) out.gen_height = static_cast<int64_t>(height);
+            return true;
+        }
+        case TXIN_TO_KEY: {
+            uint64_t amount, count, offset;
+            if (!read_varint(p, end, amount) || !read_varint(p, end, count)) return false;
+            if (out.vin_sum + amount < amount) return false; // Soma acima de 2^64
+            out.vin_sum += amount;
+            if (count > static_cast<uint64_t>(end - p)) return false;
+            for (uint64_t k = 0; k < count; ++k) {
+                if (!read_varint(p, end, offset)) return false;
+            }
+            return skip(p, end, 32); // key image
+        }
+        case TXIN_TO_SCRIPT: {
+            uint64_t prevout;
+            return skip(p, end, 32) && read_varint(p, end, prevout) && skip_vector(p, end, 1);
+        }
+        case TXIN_TO_SCRIPTHASH: {
+            uint64_t prevout;
+            return skip(p, end, 32) && read_varint(p, end, prevout) &&
+                   skip_vector(p, end, 32) && skip_vector(p, end, 1) && skip_vector(p, end, 1);
+        }
+        default:
+            return false;
+    }
+}
+
+bool parse_output(const uint8_t*& p, const uint8_t* end, ParsedTx& out) {
+    uint64_t amount;
+    if (!read_varint(p, end, amount)) return false;
+    if (out.vout_sum + amount < amount) return false;
+    out.vout_sum += amount;
+    if (p >= end) return false;
+    uint8_t tag = *p++;
+    switch (tag) {
+        case TXOUT_TO_KEY: return skip(p, end, 32);
+        case TXOUT_TO_TAGGED_KEY: return skip(p, end, 33); // chave + view tag
+        case TXOUT_TO_SCRIPTHASH: return skip(p, end, 32);
+        case TXOUT_TO_SCRIPT: return skip_vector(p, end, 32) && skip_vector(p, end, 1);
+        default: return false;
+    }
+}
+
+// Prefixo (version..extra) de qualquer transação; only_gen diz se todas as
+// entradas são txin_gen
+bool parse_prefix(const uint8_t*& p, const uint8_t* end, ParsedTx& out, bool& only_gen, std::string* error) {
+    const uint8_t* start = p;
+    out = ParsedTx();
+    if (!read_varint(p, end, out.version) || !read_varint(p, end, out.unlock_time)) {
+        return fail(error, "cabeçalho da tx truncado");
+    }
+
+    uint64_t vin_count;
+    if (!read_varint(p, end, vin_count) || vin_count > static_cast<uint64_t>(end - p)) {
+        return fail(error, "contagem de entradas inválida");
+    }
+    out.vin_count = static_cast<size_t>(vin_count);
+    only_gen = true;
+    for (uint64_t k = 0; k < vin_count; ++k) {
+        if (p < end && *p != TXIN_GEN) only_gen = false;
+        if (!parse_input(p, end, out, k == 0)) return fail(error, "entrada da tx inválida");
+    }
+
+    uint64_t vout_count;
+    if (!read_varint(p, end, vout_count) || vout_count > static_cast<uint64_t>(end - p)) {
+        return fail(error, "contagem de saídas inválida");
+    }
+    out.vout_count = static_cast<size_t>(vout_count);
+    for (uint64_t k = 0; k < vout_count; ++k) {
+        if (!parse_output(p, end, out)) return fail(error, "saída da tx inválida");
+    }
+
+    if (!skip_vector(p, end, 1)) return fail(error, "extra da tx truncado");
+    out.prefix_size = static_cast<size_t>(p - start);
+    if (out.version != 1 && out.version != 2) return fail(error, "versão de transação desconhecida");
+    return true;
+}
+
+} // namespace
+
+bool read_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            // Rejeita codificações não canônicas (byte final zero após o primeiro)
+            return !(byte == 0 && shift != 0);
+        }
+    }
+    return false;
+}
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool parse_miner_tx(const uint8_t*& p, const uint8_t* end, ParsedTx& out, std::string* error) {
+    const uint8_t* start = p;
+    bool only_gen;
+    if (!parse_prefix(p, end, out, only_gen, error)) return false;
+
+    if (out.version == 1) {
+        // Entradas txin_gen não têm assinaturas
+        if (!only_gen) return fail(error, "tx v1 com assinaturas não é coinbase");
+    } else {
+        if (p >= end) return fail(error, "rct_signatures ausente");
+        if (*p++ != RCT_TYPE_NULL) return fail(error, "miner tx com rct_signatures não nulo");
+    }
+    out.size = static_cast<size_t>(p - start);
+    return true;
+}
+
+bool parse_tx_fee(const uint8_t* data, size_t size, uint64_t& fee, std::string* error) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    ParsedTx tx;
+    bool only_gen;
+    if (!parse_prefix(p, end, tx, only_gen, error)) return false;
+    if (only_gen) return fail(error, "coinbase no lugar de uma tx comum");
+
+    if (tx.version == 1) {
+        // Amounts em claro; as assinaturas (que a versão podada omite) ficam de fora
+        if (tx.vin_sum < tx.vout_sum) return fail(error, "saídas acima das entradas");
+        fee = tx.vin_sum - tx.vout_sum;
+        return true;
+    }
+    // rctSigBase: tipo e, fora do RCTTypeNull, o txnFee
+    if (p >= end) return fail(error, "rct_signatures ausente");
+    if (*p++ == RCT_TYPE_NULL) {
+        fee = 0;
+        return true;
+    }
+    if (!read_varint(p, end, fee)) return fail(error, "txnFee truncado");
+    return true;
+}
+
+bool parse_block_blob(const uint8_t* data, size_t size, ParsedBlock& out, std::string* error, size_t* block_size) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    out = ParsedBlock();
+
+    if (!read_varint(p, end, out.major_version) || !read_varint(p, end, out.minor_version) ||
+        !read_varint(p, end, out.timestamp)) {
+        return fail(error, "cabeçalho do bloco truncado");
+    }
+    if (end - p < 36) return fail(error, "cabeçalho do bloco truncado");
+    std::memcpy(out.prev_id.data(), p, 32);
+    p += 32;
+    out.nonce = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    p += 4;
+    out.header_size = static_cast<size_t>(p - data);
+
+    out.miner_tx_offset = out.header_size;
+    if (!parse_miner_tx(p, end, out.miner_tx, error)) return false;
+
+    uint64_t tx_count;
+    if (!read_varint(p, end, tx_count) || tx_count > static_cast<uint64_t>(end - p) / 32) {
+        return fail(error, "lista de tx_hashes inválida");
+    }
+    out.tx_hashes.resize(static_cast<size_t>(tx_count));
+    for (auto& h : out.tx_hashes) {
+        std::memcpy(h.data(), p, 32);
+        p += 32;
+    }
+    if (block_size) {
+        *block_size = static_cast<size_t>(p - data);
+    } else if (p != end) {
+        return fail(error, "bytes excedentes no fim do bloco");
+    }
+    return true;
+}
+
+void to_hex(const uint8_t* data, size_t size, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t k = 0; k < size; ++k) {
+        out[2 * k] = digits[data[k] >> 4];
+        out[2 * k + 1] = digits[data[k] & 15];
+    }
+}
+
+std::string to_hex(const uint8_t* data, size_t size) {
+    std::string out(size * 2, '0');
+    to_hex(data, size, &out[0]);
+    return out;
+}
+
+bool hash_from_hex(const std::string& hex, Hash32& out) {
+    if (hex.size() != 2 * out.size()) return false;
+    for (size_t k = 0; k < hex.size(); ++k) {
+        char c = hex[k];
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        out[k / 2] = static_cast<uint8_t>(k % 2 ? (out[k / 2] << 4) | v : v);
+    }
+    return true;
+}
+
+bool from_hex(const std::string& hex, std::string& out) {
+    if (hex.size() % 2) return false;
+    out.resize(hex.size() / 2);
+    for (size_t k = 0; k < out.size(); ++k) {
+        int v = 0;
+        for (int n = 0; n < 2; ++n) {
+            char c = hex[2 * k + n];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= c - '0';
+            else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+            else return false;
+        }
+        out[k] = static_cast<char>(v);
+    }
+    return true;
+}
+
+namespace {
+
+Hash32 hash_of(const uint8_t* data, size_t size) {
+    Hash32 out;
+    keccak256(data, size, out.data());
+    return out;
+}
+
+Hash32 hash_pair(const Hash32& a, const Hash32& b) {
+    uint8_t buf[64];
+    std::memcpy(buf, a.data(), 32);
+    std::memcpy(buf + 32, b.data(), 32);
+    return hash_of(buf, sizeof(buf));
+}
+
+// Bloco 202612 foi aceito com um id calculado por um tree_hash antigo e
+// errado; o monerod reconhece o blob pelo hash e devolve o id histórico
+const char BLOB_HASH_202612[] = "3a8a2b3a29b50fc86ff73dd087ea43c6f0d6b8f936c849194d5c84c737903966";
+const char BLOCK_ID_202612[] = "bbd604d2ba11ba27935e006ed39c9bfdd99b76bf4a50654bc1e1e61217962698";
+
+} // namespace
+
+// crypto/tree-hash.c: as folhas que sobram acima da maior potência de 2
+// são combinadas em pares primeiro, depois a árvore é reduzida ao meio
+Hash32 tree_hash(const std::vector<Hash32>& hashes) {
+    size_t count = hashes.size();
+    if (count == 0) return Hash32{};
+    if (count == 1) return hashes[0];
+    if (count == 2) return hash_pair(hashes[0], hashes[1]);
+
+    size_t cnt = 1;
+    while (cnt * 2 < count) cnt *= 2;
+    std::vector<Hash32> ints(hashes.begin(), hashes.begin() + (2 * cnt - count));
+    ints.resize(cnt);
+    for (size_t i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
+        ints[j] = hash_pair(hashes[i], hashes[i + 1]);
+    }
+    while (cnt > 2) {
+        cnt /= 2;
+        for (size_t i = 0, j = 0; j < cnt; i += 2, ++j) ints[j] = hash_pair(ints[i], ints[i + 1]);
+    }
+    return hash_pair(ints[0], ints[1]);
+}
+
+Hash32 miner_tx_hash(const uint8_t* data, const ParsedBlock& block) {
+    const uint8_t* tx = data + block.miner_tx_offset;
+    const ParsedTx& parsed = block.miner_tx;
+    if (parsed.version == 1) return hash_of(tx, parsed.size);
+    // v2: H(H(prefixo) || H(base RCT) || H(prunable)); em RCTTypeNull a
+    // base é só o byte do tipo e a parte prunable vale o hash nulo
+    uint8_t parts[96] = {};
+    keccak256(tx, parsed.prefix_size, parts);
+    keccak256(tx + parsed.prefix_size, parsed.size - parsed.prefix_size, parts + 32);
+    return hash_of(parts, sizeof(parts));
+}
+
+Hash32 block_id(const uint8_t* data, size_t size, const ParsedBlock& block) {
+    if (block.miner_tx.gen_height == 202612 && to_hex(hash_of(data, size).data(), 32) == BLOB_HASH_202612) {
+        std::string id;
+        from_hex(BLOCK_ID_202612, id);
+        Hash32 out;
+        std::memcpy(out.data(), id.data(), 32);
+        return out;
+    }
+
+    std::vector<Hash32> leaves;
+    leaves.reserve(block.tx_hashes.size() + 1);
+    leaves.push_back(miner_tx_hash(data, block));
+    leaves.insert(leaves.end(), block.tx_hashes.begin(), block.tx_hashes.end());
+    Hash32 root = tree_hash(leaves);
+
+    std::string hashing_blob(reinterpret_cast<const char*>(data), block.header_size);
+    hashing_blob.append(reinterpret_cast<const char*>(root.data()), root.size());
+    put_varint(hashing_blob, leaves.size());
+    std::string prefixed;
+    put_varint(prefixed, hashing_blob.size());
+    prefixed += hashing_blob;
+    return hash_of(reinterpret_cast<const uint8_t*>(prefixed.data()), prefixed.size());
+}
+
+void block_ids(const std::vector<BlockBlob>& blocks, std::vector<Hash32>& out) {
+    out.assign(blocks.size(), Hash32{});
+    std::vector<const uint8_t*> data;
+    std::vector<size_t> sizes;
+    std::vector<uint8_t*> dest;
+    auto run = [&] {
+        keccak256_many(data.size(), data.data(), sizes.data(), dest.data());
+        data.clear();
+        sizes.clear();
+        dest.clear();
+    };
+    auto add = [&](const uint8_t* d, size_t s, uint8_t* o) {
+        data.push_back(d);
+        sizes.push_back(s);
+        dest.push_back(o);
+    };
+
+    // Folhas de cada bloco: a miner tx e os hashes das txs. Nas miner txs
+    // v2, H(prefixo) e H(base RCT) vão numa etapa e o hash final na seguinte.
+    std::vector<std::vector<Hash32>> levels(blocks.size());
+    std::vector<std::array<uint8_t, 96>> parts(blocks.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const ParsedBlock& block = *blocks[b].block;
+        const uint8_t* tx = blocks[b].data + block.miner_tx_offset;
+        const ParsedTx& parsed = block.miner_tx;
+        std::vector<Hash32>& leaves = levels[b];
+        leaves.reserve(block.tx_hashes.size() + 1);
+        leaves.emplace_back();
+        leaves.insert(leaves.end(), block.tx_hashes.begin(), block.tx_hashes.end());
+        if (parsed.version == 1) {
+            add(tx, parsed.size, leaves[0].data());
+        } else {
+            parts[b].fill(0);
+            add(tx, parsed.prefix_size, parts[b].data());
+            add(tx + parsed.prefix_size, parsed.size - parsed.prefix_size, parts[b].data() + 32);
+        }
+    }
+    run();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b].block->miner_tx.version != 1) add(parts[b].data(), parts[b].size(), levels[b][0].data());
+    }
+    run();
+
+    // Árvores, um nível de todos os blocos por vez: um nível de n > 1
+    // hashes vira a maior potência de 2 menor que n, com os primeiros
+    // 2 * alvo - n copiados e os demais combinados em pares (tree_hash)
+    std::vector<std::array<uint8_t, 64>> pairs;
+    for (;;) {
+        pairs.clear();
+        for (const auto& level : levels) {
+            size_t n = level.size();
+            if (n < 2) continue;
+            size_t target = 1;
+            while (target * 2 < n) target *= 2;
+            for (size_t i = 2 * target - n; i < n; i += 2) {
+                pairs.emplace_back();
+                std::memcpy(pairs.back().data(), level[i].data(), 32);
+                std::memcpy(pairs.back().data() + 32, level[i + 1].data(), 32);
+            }
+        }
+        if (pairs.empty()) break;
+        size_t p = 0;
+        for (auto& level : levels) {
+            size_t n = level.size();
+            if (n < 2) continue;
+            size_t target = 1;
+            while (target * 2 < n) target *= 2;
+            for (size_t j = 2 * target - n; j < target; ++j) add(pairs[p++].data(), 64, level[j].data());
+            level.resize(target);
+        }
+        run();
+    }
+
+    // Blob de hashing: varint(tamanho) || cabeçalho || raiz || varint(folhas)
+    std::vector<std::string> hashing(blocks.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const ParsedBlock& block = *blocks[b].block;
+        std::string blob(reinterpret_cast<const char*>(blocks[b].data), block.header_size);
+        blob.append(reinterpret_cast<const char*>(levels[b][0].data()), 32);
+        put_varint(blob, block.tx_hashes.size() + 1);
+        put_varint(hashing[b], blob.size());
+        hashing[b] += blob;
+        add(reinterpret_cast<const uint8_t*>(hashing[b].data()), hashing[b].size(), out[b].data());
+    }
+    run();
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const BlockBlob& blob = blocks[b];
+        if (blob.block->miner_tx.gen_height == 202612) out[b] = block_id(blob.data, blob.size, *blob.block);
+    }
+}
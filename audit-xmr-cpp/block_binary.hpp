@@ -0,0 +1,83 @@
+// block_binary.hpp
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using Hash32 = std::array<uint8_t, 32>;
+
+// Campos de uma transação lidos da serialização binária do Monero
+struct ParsedTx {
+    uint64_t version = 0;
+    uint64_t unlock_time = 0;
+    size_t vin_count = 0;
+    int64_t gen_height = -1;  // Altura do txin_gen, se a primeira entrada for uma
+    uint64_t vin_sum = 0;     // Soma dos amounts das entradas txin_to_key (em claro só nas v1)
+    size_t vout_count = 0;
+    uint64_t vout_sum = 0;    // Soma dos amounts das saídas (em claro na coinbase)
+    size_t prefix_size = 0;   // Bytes do prefixo (version..extra)
+    size_t size = 0;          // Bytes da transação inteira (só coinbase/sem assinaturas)
+};
+
+// Campos de um bloco lidos do blob binário
+struct ParsedBlock {
+    uint64_t major_version = 0;
+    uint64_t minor_version = 0;
+    uint64_t timestamp = 0;
+    Hash32 prev_id{};
+    uint32_t nonce = 0;
+    size_t header_size = 0;       // Bytes do cabeçalho no início do blob
+    size_t miner_tx_offset = 0;   // Posição da miner tx dentro do blob
+    ParsedTx miner_tx;
+    std::vector<Hash32> tx_hashes;
+};
+
+// Lê um varint do Monero (7 bits por byte, bit alto = continuação)
+bool read_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value);
+// Acrescenta 'v' a 'out' no mesmo formato
+void put_varint(std::string& out, uint64_t v);
+
+// write(2) até o fim, repetindo nas gravações parciais e em EINTR; false
+// com o errno da falha
+bool write_all(int fd, const void* data, size_t size);
+
+// Lê uma transação coinbase (ou qualquer tx cujo corpo após o prefixo seja
+// vazio em v1 / só o tipo RCTTypeNull em v2). Avança 'p' até o fim da tx.
+bool parse_miner_tx(const uint8_t*& p, const uint8_t* end, ParsedTx& out, std::string* error = nullptr);
+
+// Taxa de uma transação comum, inteira ou podada (pruned_as_hex): nas v1 é
+// entradas - saídas do prefixo; nas v2, o txnFee logo depois do tipo RCT
+bool parse_tx_fee(const uint8_t* data, size_t size, uint64_t& fee, std::string* error = nullptr);
+
+// Lê um blob de bloco completo (cabeçalho, miner tx e hashes das transações).
+// Com block_size, aceita bytes depois do bloco e devolve quantos ele ocupa.
+bool parse_block_blob(const uint8_t* data, size_t size, ParsedBlock& out, std::string* error = nullptr,
+                      size_t* block_size = nullptr);
+
+// Ids calculados como no monerod (cn_fast_hash = Keccak-256)
+Hash32 tree_hash(const std::vector<Hash32>& hashes); // Raiz da árvore de hashes de um bloco
+Hash32 miner_tx_hash(const uint8_t* data, const ParsedBlock& block); // data: início do blob do bloco
+// Keccak de varint(n) || cabeçalho || raiz (miner tx e tx_hashes) || varint(txs + 1),
+// com a exceção histórica do bloco 202612. 'size' são só os bytes do bloco.
+Hash32 block_id(const uint8_t* data, size_t size, const ParsedBlock& block);
+
+// Blob de um bloco já lido por parse_block_blob
+struct BlockBlob {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const ParsedBlock* block = nullptr;
+};
+// Os mesmos ids de block_id para vários blocos. Cada etapa (miner txs, cada
+// nível das árvores, blobs de hashing) junta os Keccak de todos os blocos
+// numa chamada a keccak256_many.
+void block_ids(const std::vector<BlockBlob>& blocks, std::vector<Hash32>& out);
+
+// Conversões hexadecimais usadas pelas fontes binárias
+std::string to_hex(const uint8_t* data, size_t size);
+bool from_hex(const std::string& hex, std::string& out);
+// Sem alocar: to_hex escreve 2 * size caracteres em 'out', e hash_from_hex
+// falha se 'hex' não tiver 64 dígitos válidos
+void to_hex(const uint8_t* data, size_t size, char* out);
+bool hash_from_hex(const std::string& hex, Hash32& out);
@@ -0,0 +1,219 @@
+// block_cache.cpp
+#include "block_cache.hpp"
+#include "block_binary.hpp"
+#include "rpc.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Registro em disco (little-endian, 64 bytes). O cabeçalho do arquivo tem o
+// mesmo tamanho, para os registros ficarem alinhados no mapeamento.
+struct BlockCache::Record {
+    uint32_t height;
+    uint32_t vin_count;
+    uint8_t hash[32];
+    uint64_t reward;
+    uint64_t coinbase_sum;
+    int64_t gen_height;
+};
+static_assert(sizeof(BlockCache::Record) == 64, "registro do cache com 64 bytes");
+
+namespace {
+
+const char CACHE_MAGIC[8] = { 'A', 'X', 'M', 'R', 'B', 'C', '0', '1' };
+const size_t HEADER_SIZE = sizeof(BlockCache::Record);
+
+} // namespace
+
+BlockCache::BlockCache(const std::string& path, bool cache_only) : path_(path), cache_only_(cache_only) {}
+
+BlockCache::~BlockCache() {
+    if (mapped_) munmap(const_cast<Record*>(mapped_), map_bytes_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool BlockCache::open(std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) return fail(std::strerror(errno));
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return fail(std::strerror(errno));
+    size_t size = static_cast<size_t>(st.st_size);
+
+    if (size == 0) {
+        char header[HEADER_SIZE] = {};
+        std::memcpy(header, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        if (!write_all(fd_, header, sizeof(header))) return fail(std::strerror(errno));
+        return true;
+    }
+    char magic[sizeof(CACHE_MAGIC)];
+    if (size < HEADER_SIZE || pread(fd_, magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic)) ||
+        std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0) {
+        return fail("não é um cache do audit-xmr");
+    }
+    // Um registro pela metade no fim é de uma gravação interrompida
+    size_t records = (size - HEADER_SIZE) / sizeof(Record);
+    size_t used = HEADER_SIZE + records * sizeof(Record);
+    if (used != size) {
+        log_message(g_log_path, "[AVISO] Registro incompleto no fim de " + path_ + " descartado");
+        if (ftruncate(fd_, static_cast<off_t>(used)) != 0) return fail(std::strerror(errno));
+    }
+    if (records == 0) return true;
+
+    void* p = mmap(nullptr, used, PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) return fail(std::strerror(errno));
+    madvise(p, used, MADV_WILLNEED);
+    map_bytes_ = used;
+    mapped_ = reinterpret_cast<const Record*>(static_cast<const char*>(p) + HEADER_SIZE);
+    mapped_count_ = records;
+    for (size_t n = 0; n < records; ++n) {
+        uint32_t h = mapped_[n].height;
+        if (h >= index_.size()) index_.resize(static_cast<size_t>(h) + 1, 0);
+        index_[h] = static_cast<uint32_t>(n + 1);
+    }
+    return true;
+}
+
+bool BlockCache::lookup(int height, BlockFields& out) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (height < 0 || static_cast<size_t>(height) >= index_.size() || index_[height] == 0) return false;
+    size_t n = index_[height] - 1;
+    const Record& r = n < mapped_count_ ? mapped_[n] : added_[n - mapped_count_];
+    out.hash = to_hex(r.hash, sizeof(r.hash));
+    out.reward = r.reward;
+    out.coinbase_sum = r.coinbase_sum;
+    out.vin_count = r.vin_count;
+    out.gen_height = r.gen_height;
+    return true;
+}
+
+bool BlockCache::store(int from, const std::vector<BlockFields>& fields) {
+    std::vector<Record> records;
+    records.reserve(fields.size());
+    std::string raw;
+    for (size_t k = 0; k < fields.size(); ++k) {
+        const BlockFields& f = fields[k];
+        if (f.hash.size() != 64 || !from_hex(f.hash, raw)) continue; // Sem hash válido não há como conferir depois
+        Record r{};
+        r.height = static_cast<uint32_t>(from + static_cast<int>(k));
+        r.vin_count = static_cast<uint32_t>(f.vin_count);
+        std::memcpy(r.hash, raw.data(), sizeof(r.hash));
+        r.reward = f.reward;
+        r.coinbase_sum = f.coinbase_sum;
+        r.gen_height = f.gen_height;
+        records.push_back(r);
+    }
+    if (records.empty()) return true;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!write_all(fd_, records.data(), records.size() * sizeof(Record))) {
+        log_message(g_log_path, "[ERRO] Falha ao gravar no cache " + path_ + ": " + std::strerror(errno));
+        return false;
+    }
+    for (const Record& r : records) {
+        if (r.height >= index_.size()) index_.resize(static_cast<size_t>(r.height) + 1, 0);
+        added_.push_back(r);
+        index_[r.height] = static_cast<uint32_t>(mapped_count_ + added_.size());
+    }
+    return true;
+}
+
+bool BlockCache::fetch(int from, int to, const RangeFetch& fetch, std::vector<BlockFields>& out) {
+    out.assign(static_cast<size_t>(to - from) + 1, BlockFields());
+    std::vector<bool> have(out.size(), false);
+    uint64_t hits = 0, stale = 0;
+    for (int h = from; h <= to; ++h) have[h - from] = lookup(h, out[h - from]);
+
+    if (cache_only_) {
+        for (int h = from; h <= to; ++h) {
+            if (!have[h - from]) {
+                log_message(g_log_path, "[ERRO] Bloco " + std::to_string(h) + " ausente do cache (--cache-only)");
+                return false;
+            }
+        }
+        hits_ += out.size();
+        return true;
+    }
+
+    // Cabeçalhos e trechos ausentes saem do mesmo nó: o hash que valida uma
+    // entrada e o prev_hash que a liga à vizinha buscada precisam ser da mesma
+    // cadeia. Numa falha o lote recomeça do que veio do cache.
+    const std::vector<BlockFields> looked_up = out;
+    const std::vector<bool> cached = have;
+    auto attempt = [&]() {
+        out = looked_up;
+        have = cached;
+        hits = stale = 0;
+
+        // O hash atual do nó decide se a entrada ainda vale
+        std::vector<BlockHeader> headers;
+        for (int first = from; first <= to; first += MAX_HEADER_RANGE) {
+            int last = std::min(to, first + MAX_HEADER_RANGE - 1);
+            std::vector<BlockHeader> part;
+            if (!get_block_headers_range(first, last, part)) return false;
+            headers.insert(headers.end(), part.begin(), part.end());
+        }
+        for (size_t k = 0; k < out.size(); ++k) {
+            if (!have[k]) continue;
+            if (out[k].hash == headers[k].hash) {
+                out[k].prev_hash = headers[k].prev_hash; // O registro não guarda; vem do cabeçalho já buscado
+                hits++;
+            } else {
+                have[k] = false;
+                stale++;
+            }
+        }
+
+        // Trechos contíguos de ausentes vão ao nó pela fonte configurada
+        std::vector<BlockFields> fetched;
+        for (size_t k = 0; k < out.size(); ) {
+            if (have[k]) {
+                ++k;
+                continue;
+            }
+            size_t end = k;
+            while (end + 1 < out.size() && !have[end + 1]) ++end;
+            int a = from + static_cast<int>(k), b = from + static_cast<int>(end);
+            if (!fetch || !fetch(a, b, fetched) || fetched.size() != end - k + 1) return false;
+            store(a, fetched);
+            for (size_t j = k; j <= end; ++j) out[j] = std::move(fetched[j - k]);
+            k = end + 1;
+        }
+        return true;
+    };
+    if (!fetch_on_one_node(attempt)) return false;
+    hits_ += hits;
+    stale_ += stale;
+    misses_ += out.size() - hits - stale;
+    if (stale > 0) {
+        std::stringstream ss;
+        ss << "[AVISO] " << stale << " bloco(s) do cache em " << from << ".." << to
+           << " com hash diferente do nó (reorganização); buscados de novo";
+        log_message(g_log_path, ss.str());
+    }
+    return true;
+}
+
+int BlockCache::contiguous_height() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    size_t n = 0;
+    while (n < index_.size() && index_[n] != 0) ++n;
+    return static_cast<int>(n);
+}
+
+CacheStats BlockCache::stats() const {
+    CacheStats s;
+    s.hits = hits_.load();
+    s.misses = misses_.load();
+    s.stale = stale_.load();
+    return s;
+}
@@ -0,0 +1,63 @@
+// block_cache.hpp
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "block_parse.hpp"
+
+// Contadores do cache, para o resumo final
+struct CacheStats {
+    uint64_t hits = 0;    // Alturas servidas pelo cache
+    uint64_t misses = 0;  // Ausentes, buscadas no nó
+    uint64_t stale = 0;   // Presentes com outro hash (reorganização), buscadas de novo
+};
+
+// Cache local de blocos, compartilhado pelo audit-xmr e pelo audit-xmr-check.
+// Guarda só os campos que a auditoria usa, em registros de 64 bytes
+// acrescentados ao fim do arquivo; o arquivo existente é mapeado em memória
+// e indexado por altura na abertura (o registro mais novo de cada altura
+// vale). Fora do modo cache_only, cada consulta confere os hashes do
+// intervalo com um get_block_headers_range, e só as alturas ausentes ou
+// reorganizadas vão ao nó.
+class BlockCache {
+public:
+    using RangeFetch = std::function<bool(int, int, std::vector<BlockFields>&)>;
+
+    BlockCache(const std::string& path, bool cache_only);
+    ~BlockCache();
+
+    bool open(std::string* error = nullptr); // Cria o arquivo se não existir
+
+    // Campos de [from, to]. As alturas que faltam são buscadas com 'fetch',
+    // em trechos contíguos, e gravadas. false se alguma não pôde ser obtida
+    // (no modo cache_only, qualquer ausente).
+    bool fetch(int from, int to, const RangeFetch& fetch, std::vector<BlockFields>& out);
+
+    int contiguous_height() const; // n tal que 0..n-1 estão todas no cache
+    CacheStats stats() const;
+    const std::string& path() const { return path_; }
+    bool cache_only() const { return cache_only_; }
+
+    struct Record;
+
+private:
+    bool lookup(int height, BlockFields& out) const;
+    bool store(int from, const std::vector<BlockFields>& fields);
+
+    std::string path_;
+    bool cache_only_;
+    int fd_ = -1;
+    const Record* mapped_ = nullptr;  // Registros que já estavam no arquivo
+    size_t mapped_count_ = 0;
+    size_t map_bytes_ = 0;
+    std::vector<Record> added_;       // Gravados nesta execução
+    std::vector<uint32_t> index_;     // Altura -> número do registro + 1 (0 = ausente)
+    mutable std::shared_mutex mutex_; // Protege added_ e index_
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_{0};
+};
@@ -0,0 +1,381 @@
+// block_parse.cpp
+#include "block_parse.hpp"
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Scanner JSON sob demanda: percorre o texto sem montar DOM nem copiar
+// valores, materializando apenas o que o chamador pede. Valores não
+// interessantes são pulados (strings via memchr). Qualquer construção
+// inesperada faz o scan falhar e o chamador recorre ao caminho DOM.
+class Scanner {
+public:
+    Scanner(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    // Percorre um objeto chamando fn(key) para cada membro; fn deve consumir
+    // o valor (lendo ou chamando skip_value)
+    template <typename Fn>
+    bool object(Fn&& fn) {
+        ws();
+        if (!consume('{')) return false;
+        ws();
+        if (consume('}')) return true;
+        for (;;) {
+            ws();
+            const char* key_begin;
+            const char* key_end;
+            if (!raw_string(key_begin, key_end)) return false;
+            ws();
+            if (!consume(':')) return false;
+            ws();
+            if (!fn(Key{key_begin, key_end})) return false;
+            ws();
+            if (consume(',')) continue;
+            return consume('}');
+        }
+    }
+
+    // Percorre um array chamando fn(index) para cada elemento
+    template <typename Fn>
+    bool array(Fn&& fn, size_t* count = nullptr) {
+        ws();
+        if (!consume('[')) return false;
+        ws();
+        size_t index = 0;
+        if (!consume(']')) {
+            for (;; ++index) {
+                ws();
+                if (!fn(index)) return false;
+                ws();
+                if (consume(',')) continue;
+                if (!consume(']')) return false;
+                ++index;
+                break;
+            }
+        }
+        if (count) *count = index;
+        return true;
+    }
+
+    bool read_uint(uint64_t& value) {
+        ws();
+        const char* start = p_;
+        value = 0;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            uint64_t digit = static_cast<uint64_t>(*p_ - '0');
+            if (value > (UINT64_MAX - digit) / 10) return false; // Overflow
+            value = value * 10 + digit;
+            ++p_;
+        }
+        // Sinal, fração ou expoente não são esperados nestes campos
+        if (p_ == start || (p_ < end_ && (*p_ == '.' || *p_ == 'e' || *p_ == 'E'))) return false;
+        return true;
+    }
+
+    // Lê uma string decodificando os escapes para 'out' (reaproveita a capacidade)
+    bool read_string(std::string& out) {
+        const char* b;
+        const char* e;
+        if (!raw_string(b, e)) return false;
+        out.clear();
+        out.reserve(static_cast<size_t>(e - b));
+        for (const char* c = b; c < e; ++c) {
+            if (*c != '\\') {
+                out.push_back(*c);
+                continue;
+            }
+            if (++c >= e) return false;
+            switch (*c) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!hex4(c + 1, e, cp)) return false;
+                    c += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) { // Par substituto
+                        uint32_t low;
+                        if (c + 2 >= e || c[1] != '\\' || c[2] != 'u' || !hex4(c + 3, e, low)) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        c += 6;
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return true;
+    }
+
+    bool skip_value() {
+        ws();
+        if (p_ >= end_) return false;
+        char c = *p_;
+        if (c == '"') {
+            const char* b;
+            const char* e;
+            return raw_string(b, e);
+        }
+        if (c == '{' || c == '[') return skip_container();
+        // Número, true, false ou null
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !is_ws(*p_)) ++p_;
+        return true;
+    }
+
+    struct Key {
+        const char* begin;
+        const char* end;
+        bool operator==(const char* s) const {
+            size_t n = std::strlen(s);
+            return static_cast<size_t>(end - begin) == n && std::memcmp(begin, s, n) == 0;
+        }
+    };
+
+private:
+    static bool is_ws(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void ws() {
+        while (p_ < end_ && is_ws(*p_)) ++p_;
+    }
+
+    bool consume(char c) {
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    // Delimita uma string sem decodificar: [begin, end) fica entre as aspas
+    bool raw_string(const char*& begin, const char*& end) {
+        if (!consume('"')) return false;
+        begin = p_;
+        for (;;) {
+            const char* q = static_cast<const char*>(std::memchr(p_, '"', static_cast<size_t>(end_ - p_)));
+            if (!q) return false;
+            // A aspa está escapada se for precedida por um número ímpar de '\'
+            size_t slashes = 0;
+            for (const char* b = q; b > begin && b[-1] == '\\'; --b) ++slashes;
+            p_ = q + 1;
+            if (slashes % 2 == 0) {
+                end = q;
+                return true;
+            }
+        }
+    }
+
+    bool skip_container() {
+        int depth = 0;
+        while (p_ < end_) {
+            char c = *p_;
+            if (c == '"') {
+                const char* b;
+                const char* e;
+                if (!raw_string(b, e)) return false;
+                continue;
+            }
+            ++p_;
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return true;
+            }
+        }
+        return false;
+    }
+
+    static bool hex4(const char* c, const char* end, uint32_t& value) {
+        if (end - c < 4) return false;
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = c[i];
+            value <<= 4;
+            if (h >= '0' && h <= '9') value |= static_cast<uint32_t>(h - '0');
+            else if (h >= 'a' && h <= 'f') value |= static_cast<uint32_t>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') value |= static_cast<uint32_t>(h - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+// JSON interno do bloco: só miner_tx.vin e miner_tx.vout interessam
+bool scan_miner_tx(Scanner& sc, BlockFields& out) {
+    return sc.object([&](const Scanner::Key& key) {
+        if (key == "vout") {
+            return sc.array([&](size_t) {
+                return sc.object([&](const Scanner::Key& field) {
+                    if (!(field == "amount")) return sc.skip_value();
+                    uint64_t amount;
+                    if (!sc.read_uint(amount)) return false;
+                    out.coinbase_sum += amount;
+                    return true;
+                });
+            });
+        }
+        if (key == "vin") {
+            return sc.array([&](size_t index) {
+                if (index != 0) return sc.skip_value();
+                return sc.object([&](const Scanner::Key& type) {
+                    if (!(type == "gen")) return sc.skip_value();
+                    return sc.object([&](const Scanner::Key& field) {
+                        if (!(field == "height")) return sc.skip_value();
+                        uint64_t height;
+                        if (!sc.read_uint(height)) return false;
+                        out.gen_height = static_cast<int64_t>(height);
+                        return true;
+                    });
+                });
+            }, &out.vin_count);
+        }
+        return sc.skip_value();
+    });
+}
+
+void set_error(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+} // namespace
+
+bool parse_get_block_fast(const std::string& response, BlockFields& out, std::string* error, std::string* blob) {
+    out = BlockFields();
+    if (blob) blob->clear();
+
+    // Buffer do JSON interno desescapado, reaproveitado entre chamadas da thread
+    thread_local std::string inner_json;
+    bool has_hash = false, has_reward = false, has_json = false, has_error = false;
+
+    Scanner outer(response.data(), response.data() + response.size());
+    bool ok = outer.object([&](const Scanner::Key& key) {
+        if (key == "error") {
+            has_error = true;
+            return outer.skip_value();
+        }
+        if (!(key == "result")) return outer.skip_value();
+        return outer.object([&](const Scanner::Key& field) {
+            if (field == "json") {
+                has_json = true;
+                return outer.read_string(inner_json);
+            }
+            if (blob && field == "blob") return outer.read_string(*blob);
+            if (field == "tx_hashes") {
+                return outer.array([&](size_t) {
+                    out.tx_hashes.emplace_back();
+                    return outer.read_string(out.tx_hashes.back());
+                });
+            }
+            if (!(field == "block_header")) return outer.skip_value();
+            return outer.object([&](const Scanner::Key& header) {
+                if (header == "hash") {
+                    has_hash = true;
+                    return outer.read_string(out.hash);
+                }
+                if (header == "reward") {
+                    has_reward = true;
+                    return outer.read_uint(out.reward);
+                }
+                if (header == "major_version") return outer.read_uint(out.major_version);
+                if (header == "block_weight") return outer.read_uint(out.weight);
+                if (header == "prev_hash") return outer.read_string(out.prev_hash);
+                return outer.skip_value();
+            });
+        });
+    });
+    if (!ok) {
+        set_error(error, "Resposta de get_block com estrutura inesperada");
+        return false;
+    }
+    if (has_error) {
+        set_error(error, "RPC get_block retornou erro");
+        return false;
+    }
+    if (!has_hash || !has_reward || !has_json) {
+        set_error(error, "Resposta de get_block sem block_header.hash, reward ou json");
+        return false;
+    }
+
+    Scanner inner(inner_json.data(), inner_json.data() + inner_json.size());
+    ok = inner.object([&](const Scanner::Key& key) {
+        if (key == "miner_tx") return scan_miner_tx(inner, out);
+        return inner.skip_value();
+    });
+    if (!ok) {
+        set_error(error, "JSON interno do bloco com estrutura inesperada");
+        return false;
+    }
+    return true;
+}
+
+bool parse_get_block_dom(const std::string& response, BlockFields& out, std::string* error, std::string* blob) {
+    out = BlockFields();
+    if (blob) blob->clear();
+    try {
+        json parsed = json::parse(response);
+        if (parsed.contains("error")) {
+            set_error(error, "RPC get_block retornou erro: " + parsed["error"].dump());
+            return false;
+        }
+        const json& result = parsed.at("result");
+        out.hash = result.at("block_header").at("hash").get<std::string>();
+        out.reward = result.at("block_header").at("reward").get<uint64_t>();
+        out.major_version = result["block_header"].value("major_version", uint64_t(0));
+        out.weight = result["block_header"].value("block_weight", uint64_t(0));
+        out.prev_hash = result["block_header"].value("prev_hash", std::string());
+        if (result.contains("tx_hashes")) out.tx_hashes = result["tx_hashes"].get<std::vector<std::string>>();
+        if (blob) *blob = result.value("blob", std::string());
+
+        json block_json = json::parse(result.at("json").get<std::string>());
+        const json& miner_tx = block_json.at("miner_tx");
+        for (const auto& vout : miner_tx.at("vout")) {
+            out.coinbase_sum += vout.at("amount").get<uint64_t>();
+        }
+        const json& vin = miner_tx.at("vin");
+        out.vin_count = vin.size();
+        if (!vin.empty() && vin[0].contains("gen") && vin[0]["gen"].contains("height")) {
+            out.gen_height = vin[0]["gen"]["height"].get<int64_t>();
+        }
+        return true;
+    } catch (const std::exception& ex) {
+        set_error(error, ex.what());
+        return false;
+    }
+}
+
+bool operator==(const BlockFields& a, const BlockFields& b) {
+    return a.hash == b.hash && a.reward == b.reward && a.coinbase_sum == b.coinbase_sum &&
+           a.vin_count == b.vin_count && a.gen_height == b.gen_height &&
+           a.major_version == b.major_version && a.weight == b.weight && a.tx_hashes == b.tx_hashes &&
+           a.prev_hash == b.prev_hash;
+}
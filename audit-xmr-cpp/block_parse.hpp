@@ -0,0 +1,45 @@
+// block_parse.hpp
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "block_binary.hpp"
+
+// Campos de um bloco usados pela auditoria
+struct BlockFields {
+    std::string hash;         // block_header.hash
+    std::string prev_hash;    // block_header.prev_hash (vazio se a fonte não informa)
+    uint64_t reward = 0;      // block_header.reward
+    uint64_t coinbase_sum = 0; // Soma de miner_tx.vout[].amount
+    size_t vin_count = 0;     // Tamanho de miner_tx.vin
+    int64_t gen_height = -1;  // miner_tx.vin[0].gen.height (-1 se ausente)
+
+    // Usados pela auditoria de taxas (emission.hpp); nem toda fonte os tem
+    uint64_t major_version = 0;          // block_header.major_version (0 se desconhecida)
+    uint64_t weight = 0;                 // block_header.block_weight (0 se desconhecido)
+    std::vector<std::string> tx_hashes;  // result.tx_hashes, para buscar as taxas depois
+    std::optional<uint64_t> fees;        // Soma das taxas das txs do bloco
+    std::optional<uint64_t> generated;   // Moedas geradas antes do bloco (fontes lmdb e raw)
+
+    // Id recalculado do blob do bloco (verificação de id); comparado com 'hash'
+    std::optional<Hash32> computed_id;
+};
+
+// Extrai os campos da resposta JSON-RPC de get_block em uma passada, com um
+// scanner sob demanda que não monta DOM e pula os valores que não interessam.
+// O JSON interno (result.json) é desescapado num buffer reaproveitado pela
+// thread e percorrido pelo mesmo scanner. Em caso de falha preenche 'error'
+// e retorna false. Com 'blob', copia também result.blob (hex, vazio se
+// ausente) para a verificação do id.
+bool parse_get_block_fast(const std::string& response, BlockFields& out, std::string* error = nullptr,
+                          std::string* blob = nullptr);
+
+// Mesmo resultado via DOM do nlohmann::json (caminho original, mais lento),
+// mantido como fallback e para validação do caminho rápido
+bool parse_get_block_dom(const std::string& response, BlockFields& out, std::string* error = nullptr,
+                         std::string* blob = nullptr);
+
+bool operator==(const BlockFields& a, const BlockFields& b);
+inline bool operator!=(const BlockFields& a, const BlockFields& b) { return !(a == b); }
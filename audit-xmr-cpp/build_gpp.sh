@@ -2,10 +2,17 @@
 # build_gpp.sh
 # Compila os binários diretamente com g++
 
-# Compila o binário principal
-g++ audit-xmr.cpp audit.cpp rpc.cpp -o audit-xmr -std=c++17 -lcurl -lpthread
+# Compila o binário principal (para a fonte lmdb, acrescente -DAUDIT_XMR_HAVE_LMDB -llmdb;
+# para o ZMQ no --follow, -DAUDIT_XMR_HAVE_ZMQ -lzmq)
+g++ audit-xmr.cpp audit.cpp audit_result.cpp emission.cpp rpc.cpp nodes.cpp log.cpp scheduler.cpp engine.cpp controller.cpp csv_writer.cpp progress.cpp state.cpp shard.cpp columnar.cpp lmdb_source.cpp raw_source.cpp block_cache.cpp block_parse.cpp portable_storage.cpp block_binary.cpp keccak.cpp linkage.cpp follow.cpp -o audit-xmr -std=c++17 -O2 -DNDEBUG -lcurl -lpthread
 
 # Compila o binário de validação
-g++ audit-xmr-check.cpp audit.cpp rpc.cpp -o audit-xmr-check -std=c++17 -lcurl -lpthread
+g++ audit-xmr-check.cpp audit.cpp audit_result.cpp emission.cpp rpc.cpp nodes.cpp log.cpp scheduler.cpp engine.cpp controller.cpp block_cache.cpp block_parse.cpp portable_storage.cpp block_binary.cpp keccak.cpp -o audit-xmr-check -std=c++17 -O2 -DNDEBUG -lcurl -lpthread
 
-echo "Build concluído. Os binários 'audit-xmr' e 'audit-xmr-check' foram gerados no diretório atual."
+# Compila as consultas ao arquivo colunar
+g++ audit-xmr-query.cpp columnar.cpp csv_writer.cpp audit_result.cpp log.cpp block_binary.cpp keccak.cpp -o audit-xmr-query -std=c++17 -O2 -DNDEBUG -lpthread
+
+# Compila a junção das partes de uma auditoria dividida
+g++ audit-xmr-merge.cpp shard.cpp state.cpp block_binary.cpp keccak.cpp -o audit-xmr-merge -std=c++17 -O2 -DNDEBUG
+
+echo "Build concluído. Os binários 'audit-xmr', 'audit-xmr-check', 'audit-xmr-query' e 'audit-xmr-merge' foram gerados no diretório atual."
@@ -0,0 +1,549 @@
+// columnar.cpp
+#include "columnar.hpp"
+#include "csv_writer.hpp"
+#include "block_binary.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Entrada do índice esparso (little-endian, 64 bytes). Há uma entrada a
+// mais no fim, sem bloco, com as somas do arquivo inteiro.
+struct ColumnarWriter::IndexEntry {
+    int32_t first_height;
+    int32_t last_height;
+    uint64_t offset;        // Início do bloco no arquivo
+    uint32_t rows;
+    uint32_t issues;        // OU dos problemas das linhas do bloco
+    // Somas acumuladas antes do bloco
+    uint64_t supply;
+    uint64_t fees;
+    uint64_t fees_unknown;
+    uint64_t discrepancies;
+    uint64_t reserved;
+};
+static_assert(sizeof(ColumnarWriter::IndexEntry) == 64, "entrada do índice colunar com 64 bytes");
+
+namespace {
+
+const char COLUMNAR_MAGIC[8] = { 'A', 'X', 'M', 'R', 'C', 'L', '0', '1' };
+
+// Cabeçalho do arquivo (64 bytes); o índice começa em index_offset
+struct Header {
+    char magic[8];
+    uint32_t flags;
+    uint32_t block_rows;
+    uint64_t rows;
+    uint64_t block_count;
+    uint64_t index_offset;
+    int32_t first_height;
+    int32_t last_height;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(Header) == 64, "cabeçalho colunar com 64 bytes");
+
+// Colunas de cada bloco, na ordem em que são gravadas. O bloco começa com o
+// fim de cada uma (uint32, a partir do fim dessa tabela).
+enum Column { COL_HEIGHT, COL_REWARD, COL_COINBASE, COL_TOTAL, COL_ISSUES, COL_FEES, COL_GENERATED, COL_HASH,
+              COLUMN_COUNT };
+const size_t BLOCK_TABLE = COLUMN_COUNT * sizeof(uint32_t);
+
+// Moedas geradas: 0 = desconhecidas, 1 = as da linha anterior + coinbase -
+// taxas, 2 seguido do valor = qualquer outro
+enum GeneratedTag : uint64_t { GENERATED_UNKNOWN = 0, GENERATED_PREDICTED = 1, GENERATED_VALUE = 2 };
+
+// Diferença com sinal (módulo 2^64) em zigue-zague: pequena em módulo, varint curto
+uint64_t zigzag(uint64_t value, uint64_t reference) {
+    int64_t d = static_cast<int64_t>(value - reference);
+    return (static_cast<uint64_t>(d) << 1) ^ static_cast<uint64_t>(d >> 63);
+}
+
+uint64_t unzigzag(uint64_t z, uint64_t reference) {
+    return reference + ((z >> 1) ^ (~(z & 1) + 1));
+}
+
+template <typename T>
+bool parse_number(std::string_view field, T& value) {
+    auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+    return !field.empty() && res.ec == std::errc() && res.ptr == field.data() + field.size();
+}
+
+} // namespace
+
+ColumnarWriter::ColumnarWriter(const std::string& path, uint32_t flags) : path_(path), flags_(flags) {}
+
+ColumnarWriter::~ColumnarWriter() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        std::remove((path_ + ".tmp").c_str()); // Sem close() bem-sucedido, nada fica no caminho final
+    }
+}
+
+bool ColumnarWriter::open(std::string* error) {
+    fd_ = ::open((path_ + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    Header header{};
+    if (fd_ < 0 || !write_all(fd_, &header, sizeof(header))) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    offset_ = sizeof(header);
+    return true;
+}
+
+bool ColumnarWriter::append(const AuditBatch& rows, std::string* error) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows.height[i] <= last_height_) {
+            if (error) *error = "altura " + std::to_string(rows.height[i]) + " fora de ordem (depois de "
+                                + std::to_string(last_height_) + ")";
+            return false;
+        }
+        last_height_ = rows.height[i];
+        pending_.height.push_back(rows.height[i]);
+        pending_.hash.push_back(rows.hash[i]);
+        pending_.real_reward.push_back(rows.real_reward[i]);
+        pending_.coinbase_outputs.push_back(rows.coinbase_outputs[i]);
+        pending_.total_mined.push_back(rows.total_mined[i]);
+        pending_.issues.push_back(rows.issues[i]);
+        pending_.fees.push_back(rows.fees[i]);
+        pending_.generated_after.push_back(rows.generated_after[i]);
+        if (pending_.size() == COLUMNAR_BLOCK_ROWS && !write_block(error)) return false;
+    }
+    return true;
+}
+
+bool ColumnarWriter::write_block(std::string* error) {
+    const AuditBatch& b = pending_;
+    size_t n = b.size();
+    IndexEntry e{};
+    e.first_height = b.height.front();
+    e.last_height = b.height.back();
+    e.offset = offset_;
+    e.rows = static_cast<uint32_t>(n);
+    e.supply = supply_;
+    e.fees = fees_;
+    e.fees_unknown = fees_unknown_;
+    e.discrepancies = discrepancies_;
+
+    uint32_t ends[COLUMN_COUNT];
+    encoded_.assign(BLOCK_TABLE, '\0');
+    auto end_column = [&](Column c) { ends[c] = static_cast<uint32_t>(encoded_.size() - BLOCK_TABLE); };
+    for (size_t i = 0; i < n; ++i) put_varint(encoded_, i ? b.height[i] - b.height[i - 1] - 1 : b.height[i]);
+    end_column(COL_HEIGHT);
+    for (size_t i = 0; i < n; ++i) put_varint(encoded_, zigzag(b.real_reward[i], i ? b.real_reward[i - 1] : 0));
+    end_column(COL_REWARD);
+    for (size_t i = 0; i < n; ++i) put_varint(encoded_, zigzag(b.coinbase_outputs[i], b.real_reward[i]));
+    end_column(COL_COINBASE);
+    for (size_t i = 0; i < n; ++i) put_varint(encoded_, zigzag(b.total_mined[i], b.coinbase_outputs[i]));
+    end_column(COL_TOTAL);
+    for (size_t i = 0; i < n; ++i) {
+        put_varint(encoded_, b.issues[i]);
+        e.issues |= b.issues[i];
+        if (b.issues[i]) discrepancies_++;
+    }
+    end_column(COL_ISSUES);
+    for (size_t i = 0; i < n; ++i) {
+        bool known = b.fees[i] != AuditBatch::UNKNOWN;
+        put_varint(encoded_, known ? b.fees[i] + 1 : 0);
+        if (known) fees_ += b.fees[i];
+        else fees_unknown_++;
+        supply_ += b.coinbase_outputs[i];
+    }
+    end_column(COL_FEES);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t g = b.generated_after[i];
+        bool predictable = i > 0 && b.generated_after[i - 1] != AuditBatch::UNKNOWN && b.fees[i] != AuditBatch::UNKNOWN;
+        if (g == AuditBatch::UNKNOWN) {
+            put_varint(encoded_, GENERATED_UNKNOWN);
+        } else if (predictable && g == b.generated_after[i - 1] + b.coinbase_outputs[i] - b.fees[i]) {
+            put_varint(encoded_, GENERATED_PREDICTED);
+        } else {
+            put_varint(encoded_, GENERATED_VALUE);
+            put_varint(encoded_, g);
+        }
+    }
+    end_column(COL_GENERATED);
+    for (size_t i = 0; i < n; ++i) encoded_.append(reinterpret_cast<const char*>(b.hash[i].data()), b.hash[i].size());
+    end_column(COL_HASH);
+    std::memcpy(&encoded_[0], ends, sizeof(ends));
+
+    if (!write_all(fd_, encoded_.data(), encoded_.size())) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    offset_ += encoded_.size();
+    rows_ += n;
+    index_.push_back(e);
+    pending_.clear();
+    return true;
+}
+
+bool ColumnarWriter::close(std::string* error) {
+    if (fd_ < 0) return false;
+    if (!pending_.empty() && !write_block(error)) return false;
+    // O índice fica alinhado para ser lido direto do mapeamento
+    char padding[alignof(IndexEntry)] = {};
+    size_t pad = (alignof(IndexEntry) - offset_ % alignof(IndexEntry)) % alignof(IndexEntry);
+    if (!write_all(fd_, padding, pad)) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    offset_ += pad;
+    Header header{};
+    std::memcpy(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    header.flags = flags_;
+    header.block_rows = COLUMNAR_BLOCK_ROWS;
+    header.rows = rows_;
+    header.block_count = index_.size();
+    header.index_offset = offset_;
+    header.first_height = index_.empty() ? -1 : index_.front().first_height;
+    header.last_height = index_.empty() ? -1 : index_.back().last_height;
+
+    IndexEntry totals{};
+    totals.first_height = totals.last_height = -1;
+    totals.offset = offset_;
+    totals.supply = supply_;
+    totals.fees = fees_;
+    totals.fees_unknown = fees_unknown_;
+    totals.discrepancies = discrepancies_;
+    index_.push_back(totals);
+    std::string tmp = path_ + ".tmp";
+    bool ok = write_all(fd_, index_.data(), index_.size() * sizeof(IndexEntry)) &&
+              ::pwrite(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    if (!ok && error) *error = std::strerror(errno);
+    ::close(fd_);
+    fd_ = -1;
+    if (ok && std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        if (error) *error = std::strerror(errno);
+        ok = false;
+    }
+    if (!ok) std::remove(tmp.c_str());
+    return ok;
+}
+
+bool ColumnarFile::open(const std::string& path, std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    if (!file_.open(path, MADV_RANDOM)) return fail(std::strerror(errno));
+    std::string_view view = file_.view();
+    data_ = reinterpret_cast<const uint8_t*>(view.data());
+    size_ = view.size();
+    Header header;
+    if (size_ < sizeof(header)) return fail("não é um arquivo colunar do audit-xmr");
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) != 0) {
+        return fail("não é um arquivo colunar do audit-xmr");
+    }
+    if (header.index_offset < sizeof(header) || header.index_offset > size_ ||
+        (size_ - header.index_offset) / sizeof(ColumnarWriter::IndexEntry) != header.block_count + 1 ||
+        header.index_offset % alignof(ColumnarWriter::IndexEntry) != 0) {
+        return fail("índice inválido (arquivo truncado?)");
+    }
+    index_ = reinterpret_cast<const ColumnarWriter::IndexEntry*>(data_ + header.index_offset);
+    block_count_ = static_cast<size_t>(header.block_count);
+    for (size_t b = 0; b < block_count_; ++b) {
+        if (index_[b].offset + BLOCK_TABLE > index_[b + 1].offset || index_[b + 1].offset > header.index_offset) {
+            return fail("bloco " + std::to_string(b) + " fora do arquivo");
+        }
+    }
+    return true;
+}
+
+uint64_t ColumnarFile::rows() const {
+    return reinterpret_cast<const Header*>(data_)->rows;
+}
+
+uint32_t ColumnarFile::flags() const {
+    return reinterpret_cast<const Header*>(data_)->flags;
+}
+
+int ColumnarFile::first_height() const {
+    return reinterpret_cast<const Header*>(data_)->first_height;
+}
+
+int ColumnarFile::last_height() const {
+    return reinterpret_cast<const Header*>(data_)->last_height;
+}
+
+const ColumnarWriter::IndexEntry& ColumnarFile::entry(size_t b) const {
+    return index_[b];
+}
+
+bool ColumnarFile::read_block(size_t b, AuditBatch& out) const {
+    out.clear();
+    if (b >= block_count_) return false;
+    const ColumnarWriter::IndexEntry& e = entry(b);
+    const uint8_t* base = data_ + e.offset;
+    const uint8_t* payload = base + BLOCK_TABLE;
+    size_t available = static_cast<size_t>(entry(b + 1).offset - e.offset - BLOCK_TABLE);
+    uint32_t ends[COLUMN_COUNT];
+    std::memcpy(ends, base, sizeof(ends));
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        if (ends[c] > available || (c > 0 && ends[c] < ends[c - 1])) return false;
+    }
+    size_t n = e.rows;
+    if (ends[COL_HASH] - ends[COL_GENERATED] != n * sizeof(Hash32)) return false;
+    auto column = [&](Column c, const uint8_t*& p, const uint8_t*& end) {
+        p = payload + (c ? ends[c - 1] : 0);
+        end = payload + ends[c];
+    };
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t v;
+
+    out.height.resize(n);
+    out.real_reward.resize(n);
+    out.coinbase_outputs.resize(n);
+    out.total_mined.resize(n);
+    out.issues.resize(n);
+    out.fees.resize(n);
+    out.generated_after.resize(n);
+    out.hash.resize(n);
+    column(COL_HEIGHT, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.height[i] = static_cast<int>(i ? out.height[i - 1] + 1 + v : v);
+    }
+    column(COL_REWARD, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.real_reward[i] = unzigzag(v, i ? out.real_reward[i - 1] : 0);
+    }
+    column(COL_COINBASE, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.coinbase_outputs[i] = unzigzag(v, out.real_reward[i]);
+    }
+    column(COL_TOTAL, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.total_mined[i] = unzigzag(v, out.coinbase_outputs[i]);
+    }
+    column(COL_ISSUES, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.issues[i] = static_cast<uint32_t>(v);
+    }
+    column(COL_FEES, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        out.fees[i] = v ? v - 1 : AuditBatch::UNKNOWN;
+    }
+    column(COL_GENERATED, p, end);
+    for (size_t i = 0; i < n; ++i) {
+        if (!read_varint(p, end, v)) return false;
+        if (v == GENERATED_UNKNOWN) {
+            out.generated_after[i] = AuditBatch::UNKNOWN;
+        } else if (v == GENERATED_PREDICTED && i > 0) {
+            out.generated_after[i] = out.generated_after[i - 1] + out.coinbase_outputs[i] - out.fees[i];
+        } else if (v == GENERATED_VALUE && read_varint(p, end, v)) {
+            out.generated_after[i] = v;
+        } else {
+            return false;
+        }
+    }
+    column(COL_HASH, p, end);
+    std::memcpy(out.hash.data(), p, n * sizeof(Hash32));
+    return true;
+}
+
+size_t ColumnarFile::block_for(int height) const {
+    size_t lo = 0, hi = block_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).last_height < height) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+ColumnarSums ColumnarFile::prefix(int height) const {
+    size_t b = block_for(height);
+    const ColumnarWriter::IndexEntry& e = entry(b);
+    ColumnarSums s;
+    s.supply = e.supply;
+    s.fees = e.fees;
+    s.fees_unknown = e.fees_unknown;
+    s.discrepancies = e.discrepancies;
+    s.rows = b < block_count_ ? static_cast<uint64_t>(b) * COLUMNAR_BLOCK_ROWS : rows();
+    if (b == block_count_ || e.first_height >= height) return s;
+    // Só o bloco em que a altura cai é decodificado
+    AuditBatch rows;
+    if (!read_block(b, rows)) return s;
+    for (size_t i = 0; i < rows.size() && rows.height[i] < height; ++i) {
+        s.rows++;
+        s.supply += rows.coinbase_outputs[i];
+        if (rows.fees[i] != AuditBatch::UNKNOWN) s.fees += rows.fees[i];
+        else s.fees_unknown++;
+        if (rows.issues[i]) s.discrepancies++;
+    }
+    return s;
+}
+
+ColumnarSums ColumnarFile::sums(int from, int to) const {
+    if (to < from) return ColumnarSums();
+    ColumnarSums a = prefix(from);
+    ColumnarSums b = prefix(std::min(to, last_height()) + 1);
+    ColumnarSums s;
+    s.rows = b.rows - a.rows;
+    s.supply = b.supply - a.supply;
+    s.fees = b.fees - a.fees;
+    s.fees_unknown = b.fees_unknown - a.fees_unknown;
+    s.discrepancies = b.discrepancies - a.discrepancies;
+    return s;
+}
+
+bool ColumnarFile::find(int height, AuditResult& out) const {
+    size_t b = block_for(height);
+    if (b == block_count_ || entry(b).first_height > height) return false;
+    AuditBatch rows;
+    if (!read_block(b, rows)) return false;
+    auto it = std::lower_bound(rows.height.begin(), rows.height.end(), height);
+    if (it == rows.height.end() || *it != height) return false;
+    size_t i = static_cast<size_t>(it - rows.height.begin());
+    out = AuditResult();
+    out.height = height;
+    out.hash = rows.hash[i];
+    out.real_reward = rows.real_reward[i];
+    out.coinbase_outputs = rows.coinbase_outputs[i];
+    out.total_mined = rows.total_mined[i];
+    out.issues = rows.issues[i];
+    if (rows.fees[i] != AuditBatch::UNKNOWN) out.fees = rows.fees[i];
+    if (rows.generated_after[i] != AuditBatch::UNKNOWN) out.generated_after = rows.generated_after[i];
+    return true;
+}
+
+bool ColumnarFile::discrepancies(int from, int to, AuditBatch& out) const {
+    out.clear();
+    AuditBatch rows;
+    for (size_t b = block_for(from); b < block_count_ && entry(b).first_height <= to; ++b) {
+        if (!entry(b).issues) continue;
+        if (!read_block(b, rows)) return false;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (!rows.issues[i] || rows.height[i] < from || rows.height[i] > to) continue;
+            out.height.push_back(rows.height[i]);
+            out.hash.push_back(rows.hash[i]);
+            out.real_reward.push_back(rows.real_reward[i]);
+            out.coinbase_outputs.push_back(rows.coinbase_outputs[i]);
+            out.total_mined.push_back(rows.total_mined[i]);
+            out.issues.push_back(rows.issues[i]);
+            out.fees.push_back(rows.fees[i]);
+            out.generated_after.push_back(rows.generated_after[i]);
+        }
+    }
+    return true;
+}
+
+bool csv_to_columnar(const std::string& csv_path, const std::string& out_path, std::string* error, uint64_t* rows) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    MappedFile csv;
+    if (!csv.open(csv_path)) return fail("não foi possível abrir " + csv_path);
+    std::string_view data = csv.view();
+    size_t pos = data.find('\n');
+    if (pos == std::string_view::npos) return fail("CSV sem cabeçalho");
+    std::string_view header = data.substr(0, pos + 1);
+    uint32_t flags = 0;
+    if (header == CSV_BASE_HEADER) flags |= COLUMNAR_BASE_COLUMNS;
+    else if (header != CSV_HEADER) return fail("cabeçalho do CSV desconhecido");
+    bool base_columns = flags & COLUMNAR_BASE_COLUMNS;
+    int field_count = base_columns ? 7 : 9;
+    pos++;
+
+    ColumnarWriter writer(out_path, flags);
+    if (!writer.open(error)) return false;
+    AuditBatch batch;
+    AuditResult r;
+    std::string hex, check;
+    uint64_t line_number = 1;
+    while (pos < data.size()) {
+        line_number++;
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) return fail("linha " + std::to_string(line_number) + " sem fim de linha");
+        std::string_view line = data.substr(pos, end - pos);
+        std::string_view fields[9];
+        int count = 0;
+        for (size_t start = 0; count < 9; ) {
+            size_t comma = line.find(',', start);
+            fields[count++] = line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start);
+            if (comma == std::string_view::npos) break;
+            start = comma + 1;
+        }
+        r = AuditResult();
+        hex.assign(fields[1].data(), fields[1].size());
+        bool ok = count == field_count && parse_number(fields[0], r.height) && hash_from_hex(hex, r.hash) &&
+                  parse_number(fields[2], r.real_reward) && parse_number(fields[3], r.coinbase_outputs) &&
+                  parse_number(fields[4], r.total_mined) && parse_issues(fields[5], r.issues);
+        uint64_t value;
+        if (ok && !base_columns && !fields[7].empty()) {
+            ok = parse_number(fields[7], value);
+            r.fees = value;
+        }
+        if (ok && !base_columns && !fields[8].empty()) {
+            ok = parse_number(fields[8], value);
+            r.generated_after = value;
+        }
+        // A linha refeita a partir das colunas tem de ser a mesma do arquivo
+        batch.push_back(r);
+        check.clear();
+        if (ok) append_csv_row(check, batch, batch.size() - 1, base_columns);
+        if (!ok || std::string_view(check) != data.substr(pos, end + 1 - pos)) {
+            return fail("linha " + std::to_string(line_number) + " não é reproduzível: " + std::string(line));
+        }
+        pos = end + 1;
+        if (batch.size() >= 16 * COLUMNAR_BLOCK_ROWS) {
+            if (!writer.append(batch, error)) return false;
+            batch.clear();
+        }
+    }
+    if (!writer.append(batch, error) || !writer.close(error)) return false;
+    if (rows) *rows = writer.rows();
+    return true;
+}
+
+bool columnar_to_csv(const std::string& in_path, const std::string& csv_path, std::string* error, uint64_t* rows) {
+    ColumnarFile file;
+    if (!file.open(in_path, error)) return false;
+    std::string tmp = csv_path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    bool base_columns = file.flags() & COLUMNAR_BASE_COLUMNS;
+    std::string buffer = base_columns ? CSV_BASE_HEADER : CSV_HEADER;
+    AuditBatch batch;
+    bool ok = true;
+    for (size_t b = 0; ok && b < file.block_count(); ++b) {
+        if (!file.read_block(b, batch)) {
+            if (error) *error = "bloco " + std::to_string(b) + " corrompido";
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < batch.size(); ++i) append_csv_row(buffer, batch, i, base_columns);
+        if (buffer.size() >= (1 << 20)) {
+            ok = write_all(fd, buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    if (ok && !write_all(fd, buffer.data(), buffer.size())) ok = false;
+    if (!ok && error && errno) *error = std::strerror(errno);
+    ::close(fd);
+    if (ok && std::rename(tmp.c_str(), csv_path.c_str()) != 0) {
+        if (error) *error = std::strerror(errno);
+        ok = false;
+    }
+    if (!ok) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    if (rows) *rows = file.rows();
+    return true;
+}
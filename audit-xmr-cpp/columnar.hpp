@@ -0,0 +1,107 @@
+// columnar.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "audit_result.hpp"
+#include "mapped_file.hpp"
+
+// Resultados da auditoria em colunas binárias (auditoria_monero.xmrc), para
+// consultas sem varrer o CSV. As linhas são agrupadas em blocos de
+// COLUMNAR_BLOCK_ROWS alturas crescentes; em cada bloco cada coluna é
+// gravada separada, em varints com deltas (altura, recompensa, coinbase e
+// total em relação à coluna anterior, taxas, moedas geradas em relação à
+// previsão pela linha anterior) e os hashes em binário no fim. Um índice
+// esparso no fim do arquivo guarda, por bloco, as alturas, a posição, o OU
+// dos problemas e as somas acumuladas antes dele (supply, taxas,
+// discrepâncias), então uma soma num intervalo decodifica no máximo dois
+// blocos. A conversão para o CSV reproduz o arquivo original byte a byte.
+const uint32_t COLUMNAR_BLOCK_ROWS = 1024;
+
+// Arquivo convertido de um CSV antigo, sem as colunas Taxas e MoedasGeradas
+const uint32_t COLUMNAR_BASE_COLUMNS = 1u << 0;
+
+class ColumnarWriter {
+public:
+    explicit ColumnarWriter(const std::string& path, uint32_t flags = 0);
+    ~ColumnarWriter();
+
+    bool open(std::string* error = nullptr);
+    // As alturas precisam crescer estritamente entre todas as chamadas
+    bool append(const AuditBatch& rows, std::string* error = nullptr);
+    // Grava o último bloco e o índice; o arquivo só aparece no caminho final aqui
+    bool close(std::string* error = nullptr);
+
+    uint64_t rows() const { return rows_; }
+
+    struct IndexEntry;
+
+private:
+    bool write_block(std::string* error);
+
+    std::string path_;
+    uint32_t flags_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    uint64_t rows_ = 0;
+    int last_height_ = -1;
+    AuditBatch pending_;
+    std::string encoded_;
+    std::vector<IndexEntry> index_;
+    // Somas acumuladas até o fim do último bloco gravado
+    uint64_t supply_ = 0;
+    uint64_t fees_ = 0;
+    uint64_t fees_unknown_ = 0;
+    uint64_t discrepancies_ = 0;
+};
+
+// Somas de um intervalo de alturas
+struct ColumnarSums {
+    uint64_t rows = 0;          // Alturas presentes no arquivo
+    uint64_t supply = 0;        // Soma de CoinbaseOutputs
+    uint64_t fees = 0;          // Soma das taxas conhecidas
+    uint64_t fees_unknown = 0;  // Linhas sem taxa
+    uint64_t discrepancies = 0; // Linhas com algum problema
+};
+
+// Leitura do arquivo mapeado em memória; as consultas são const e podem
+// ser feitas de várias threads
+class ColumnarFile {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+
+    uint64_t rows() const;
+    uint32_t flags() const;
+    int first_height() const;
+    int last_height() const;
+    size_t block_count() const { return block_count_; }
+
+    // Decodifica o bloco b inteiro em 'out' (substitui o conteúdo)
+    bool read_block(size_t b, AuditBatch& out) const;
+
+    // Linha da altura, se presente
+    bool find(int height, AuditResult& out) const;
+    // Somas das linhas com altura em [from, to]
+    ColumnarSums sums(int from, int to) const;
+    // Linhas com problema em [from, to], em ordem; os blocos sem nenhum são pulados
+    bool discrepancies(int from, int to, AuditBatch& out) const;
+
+private:
+    const ColumnarWriter::IndexEntry& entry(size_t b) const;
+    size_t block_for(int height) const; // Primeiro bloco com last_height >= height
+    ColumnarSums prefix(int height) const; // Somas das alturas < height
+
+    MappedFile file_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const ColumnarWriter::IndexEntry* index_ = nullptr;
+    size_t block_count_ = 0;
+};
+
+// Conversões entre o CSV do audit-xmr e o arquivo colunar. csv_to_columnar
+// confere que cada linha é reproduzida exatamente; uma linha que não seria
+// (editada à mão, fora de ordem) é um erro.
+bool csv_to_columnar(const std::string& csv_path, const std::string& out_path, std::string* error = nullptr,
+                     uint64_t* rows = nullptr);
+bool columnar_to_csv(const std::string& in_path, const std::string& csv_path, std::string* error = nullptr,
+                     uint64_t* rows = nullptr);
@@ -0,0 +1,104 @@
+// controller.cpp
+#include "controller.hpp"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+const double DECREASE_FACTOR = 0.7;
+const double LATENCY_FACTOR = 1.5;    // Média curta acima de longa x fator conta como congestionamento
+const double LATENCY_SLACK_MS = 2.0;  // Folga para latências de poucos ms na rede local
+const double SHORT_SMOOTHING = 0.1;   // Peso de cada amostra na média curta: o jitter de uma resposta não conta
+const double LONG_SMOOTHING = 0.01;   // Peso na média longa, a referência do "normal"
+
+} // namespace
+
+ConcurrencyController::ConcurrencyController(int initial, int min_limit, int max_limit, bool adaptive)
+    : adaptive_(adaptive),
+      min_limit_(std::max(1, min_limit)),
+      max_limit_(std::max(std::max(1, min_limit), max_limit)) {
+    limit_ = adaptive_ ? std::min(std::max(initial, min_limit_), max_limit_) : max_limit_;
+    peak_limit_ = static_cast<int>(limit_);
+}
+
+bool ConcurrencyController::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ >= static_cast<int>(limit_)) return false;
+    ++active_;
+    return true;
+}
+
+void ConcurrencyController::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return active_ < static_cast<int>(limit_); });
+    ++active_;
+}
+
+void ConcurrencyController::abandon() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_;
+    }
+    cv_.notify_one();
+}
+
+void ConcurrencyController::release(bool ok, double latency_ms) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_;
+        if (adaptive_) {
+            auto now = std::chrono::steady_clock::now();
+            if (ok) {
+                if (smoothed_latency_ms_ == 0) {
+                    smoothed_latency_ms_ = base_latency_ms_ = latency_ms;
+                } else {
+                    smoothed_latency_ms_ += (latency_ms - smoothed_latency_ms_) * SHORT_SMOOTHING;
+                    base_latency_ms_ += (latency_ms - base_latency_ms_) * LONG_SMOOTHING;
+                }
+            }
+            if (!ok || smoothed_latency_ms_ > base_latency_ms_ * LATENCY_FACTOR + LATENCY_SLACK_MS) {
+                decrease(now);
+            } else {
+                limit_ = std::min(static_cast<double>(max_limit_), limit_ + 1.0 / limit_);
+                peak_limit_ = std::max(peak_limit_, static_cast<int>(limit_));
+            }
+        }
+    }
+    cv_.notify_all();
+}
+
+void ConcurrencyController::decrease(std::chrono::steady_clock::time_point now) {
+    // No máximo uma queda por ~2 latências: as respostas já em voo refletem o limite antigo
+    double cooldown_ms = std::max(100.0, smoothed_latency_ms_ * 2);
+    if (decreases_ > 0 &&
+        std::chrono::duration<double, std::milli>(now - last_decrease_).count() < cooldown_ms) {
+        return;
+    }
+    limit_ = std::max(static_cast<double>(min_limit_), limit_ * DECREASE_FACTOR);
+    last_decrease_ = now;
+    ++decreases_;
+}
+
+int ConcurrencyController::limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(limit_);
+}
+
+int ConcurrencyController::peak_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_limit_;
+}
+
+int ConcurrencyController::decreases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decreases_;
+}
+
+std::chrono::milliseconds backoff_delay(int attempt, int base_ms, int max_ms) {
+    thread_local std::mt19937 rng(std::random_device{}());
+    long long ceiling = base_ms;
+    for (int i = 1; i < attempt && ceiling < max_ms; ++i) ceiling *= 2;
+    ceiling = std::min<long long>(ceiling, max_ms);
+    std::uniform_int_distribution<long long> dist(0, ceiling);
+    return std::chrono::milliseconds(dist(rng));
+}
@@ -0,0 +1,48 @@
+// controller.hpp
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Controle adaptativo de concorrência (AIMD): o limite de requisições em voo
+// cresce 1 a cada "rodada" de respostas e cai 30% quando há erro ou quando
+// a latência média recente sobe bem acima da média de longo prazo (a fila no
+// nó está crescendo). As quedas respeitam um intervalo mínimo para que uma
+// rajada de respostas lentas da mesma rodada conte uma vez só.
+class ConcurrencyController {
+public:
+    ConcurrencyController(int initial, int min_limit, int max_limit, bool adaptive = true);
+
+    // Reserva uma vaga; acquire() bloqueia até haver vaga
+    bool try_acquire();
+    void acquire();
+
+    // Devolve a vaga informando o resultado e a latência da requisição
+    void release(bool ok, double latency_ms);
+    // Devolve a vaga sem amostra (nada foi enviado)
+    void abandon();
+
+    int limit() const;
+    int peak_limit() const;
+    int decreases() const;
+
+private:
+    void decrease(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool adaptive_;
+    double limit_;
+    int min_limit_;
+    int max_limit_;
+    int active_ = 0;
+    int peak_limit_ = 0;
+    int decreases_ = 0;
+    double base_latency_ms_ = 0;     // Média móvel longa da latência
+    double smoothed_latency_ms_ = 0; // Média móvel curta da latência
+    std::chrono::steady_clock::time_point last_decrease_;
+};
+
+// Espera antes da tentativa 'attempt' (1, 2, ...): exponencial a partir de
+// base_ms, limitada a max_ms, com jitter completo
+std::chrono::milliseconds backoff_delay(int attempt, int base_ms = 200, int max_ms = 10000);
@@ -0,0 +1,244 @@
+// csv_writer.cpp
+#include "csv_writer.hpp"
+#include "log.hpp"
+#include "block_binary.hpp"
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern std::string g_log_path;
+
+namespace {
+
+const size_t FLUSH_BYTES = 1 << 20; // Grava quando o buffer passa de 1 MiB
+const auto FLUSH_INTERVAL = std::chrono::milliseconds(500); // ... ou a cada 0,5 s com dados pendentes
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr);
+}
+
+} // namespace
+
+const char CSV_HEADER[] = "Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status,Taxas,MoedasGeradas\n";
+const char CSV_BASE_HEADER[] = "Altura,Hash,RecompensaReal,CoinbaseOutputs,TotalMinerado,Problemas,Status\n";
+
+void append_csv_row(std::string& out, const AuditBatch& rows, size_t i, bool base_columns) {
+    append_number(out, rows.height[i]);
+    out += ',';
+    size_t at = out.size();
+    out.resize(at + 2 * rows.hash[i].size());
+    to_hex(rows.hash[i].data(), rows.hash[i].size(), &out[at]);
+    out += ',';
+    append_number(out, rows.real_reward[i]);
+    out += ',';
+    append_number(out, rows.coinbase_outputs[i]);
+    out += ',';
+    append_number(out, rows.total_mined[i]);
+    out += ',';
+    uint32_t issues = rows.issues[i];
+    if (!issues) out += "Nenhum";
+    for (uint32_t bits = issues; bits; bits &= bits - 1) {
+        if (bits != issues) out += '|';
+        out += issue_name(static_cast<AuditIssue>(bits & -bits));
+    }
+    out += ',';
+    out += status_name(issues ? AuditStatus::Discrepancy : AuditStatus::Ok);
+    if (!base_columns) {
+        out += ',';
+        if (rows.fees[i] != AuditBatch::UNKNOWN) append_number(out, rows.fees[i]);
+        out += ',';
+        if (rows.generated_after[i] != AuditBatch::UNKNOWN) append_number(out, rows.generated_after[i]);
+    }
+    out += '\n';
+}
+
+bool parse_sync_policy(const std::string& name, SyncPolicy& policy) {
+    if (name == "none") policy = SyncPolicy::None;
+    else if (name == "close") policy = SyncPolicy::Close;
+    else if (name == "flush") policy = SyncPolicy::Flush;
+    else return false;
+    return true;
+}
+
+CsvWriter::CsvWriter(const std::string& path, SyncPolicy policy)
+    : path_(path), policy_(policy) {}
+
+CsvWriter::~CsvWriter() {
+    close();
+}
+
+void CsvWriter::set_on_flush(std::function<void(const std::vector<WrittenRow>&)> callback) {
+    on_flush_ = std::move(callback);
+}
+
+bool CsvWriter::open(std::string* error) {
+    return start(0, error);
+}
+
+bool CsvWriter::open_append(uint64_t keep_bytes, std::string* error) {
+    return start(keep_bytes, error);
+}
+
+bool CsvWriter::start(uint64_t keep_bytes, std::string* error) {
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (keep_bytes == 0 ? O_TRUNC : 0);
+    fd_ = ::open(path_.c_str(), flags, 0644);
+    if (fd_ < 0 || (keep_bytes > 0 && (::ftruncate(fd_, static_cast<off_t>(keep_bytes)) != 0 ||
+                                       ::lseek(fd_, 0, SEEK_END) < 0))) {
+        if (error) *error = std::strerror(errno);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    // Um CSV antigo, sem as colunas de taxas, continua com as 7 colunas:
+    // linhas mais largas que o cabeçalho não seriam lidas pelas ferramentas
+    base_columns_ = false;
+    const size_t base_header_size = sizeof(CSV_BASE_HEADER) - 1;
+    if (keep_bytes >= base_header_size) {
+        std::string header(base_header_size, '\0');
+        if (::pread(fd_, &header[0], header.size(), 0) == static_cast<ssize_t>(header.size()) &&
+            header == CSV_BASE_HEADER) {
+            base_columns_ = true;
+            log_message(g_log_path, "[AVISO] " + path_ + " não tem as colunas Taxas e MoedasGeradas; "
+                                    "as linhas acrescentadas também não terão");
+        }
+    }
+    offset_ = keep_bytes;
+    stop_ = false;
+    buffer_.reserve(FLUSH_BYTES + 4096);
+    if (keep_bytes == 0) buffer_ = CSV_HEADER;
+    if (!flush(false)) {
+        if (error) *error = std::strerror(errno);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void CsvWriter::push(AuditBatch& rows) {
+    if (rows.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            queue_.swap(rows); // 'rows' fica com as colunas vazias (e a capacidade) da fila
+        } else {
+            queue_.append(rows);
+        }
+    }
+    rows.clear();
+    cv_.notify_one();
+}
+
+void CsvWriter::push(const AuditResult& row) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(row);
+    }
+    cv_.notify_one();
+}
+
+bool CsvWriter::flush_now() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ < 0) return !failed_;
+    uint64_t request = ++flush_requests_;
+    cv_.notify_one();
+    flushed_cv_.wait(lock, [&] { return flushes_done_ >= request; });
+    return !failed_;
+}
+
+bool CsvWriter::close() {
+    if (fd_ < 0) return !failed_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+    if (policy_ != SyncPolicy::None && !failed_ && ::fsync(fd_) != 0) {
+        log_message(g_log_path, "[ERRO] fsync do CSV falhou: " + std::string(std::strerror(errno)));
+        failed_ = true;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    return !failed_;
+}
+
+uint64_t CsvWriter::rows_written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rows_;
+}
+
+bool CsvWriter::flush(bool sync) {
+    if (failed_) return false;
+    if (!buffer_.empty() && !write_all(fd_, buffer_.data(), buffer_.size())) {
+        log_message(g_log_path, "[ERRO] Falha ao gravar o CSV " + path_ + ": " + std::strerror(errno));
+        failed_ = true;
+        return false;
+    }
+    offset_ += buffer_.size();
+    buffer_.clear();
+    if (sync && ::fsync(fd_) != 0) {
+        log_message(g_log_path, "[ERRO] fsync do CSV falhou: " + std::string(std::strerror(errno)));
+        failed_ = true;
+        return false;
+    }
+    if (!flushed_.empty()) {
+        on_flush_(flushed_);
+        flushed_.clear();
+    }
+    return true;
+}
+
+void CsvWriter::run() {
+    AuditBatch batch;
+    auto last_flush = std::chrono::steady_clock::now();
+    for (;;) {
+        bool stopping;
+        uint64_t requested;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, FLUSH_INTERVAL, [&] {
+                return stop_ || !queue_.empty() || flush_requests_ > flushes_done_;
+            });
+            batch.swap(queue_);
+            stopping = stop_;
+            requested = flush_requests_;
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            append_csv_row(buffer_, batch, i, base_columns_);
+            if (!on_flush_) continue;
+            std::optional<uint64_t> fees;
+            if (batch.fees[i] != AuditBatch::UNKNOWN) fees = batch.fees[i];
+            flushed_.push_back({ batch.height[i], batch.hash[i], batch.coinbase_outputs[i], offset_ + buffer_.size(), fees });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rows_ += batch.size();
+        }
+        batch.clear();
+
+        auto now = std::chrono::steady_clock::now();
+        bool wanted = requested > flushes_done_; // Só esta thread altera flushes_done_
+        if (buffer_.size() >= FLUSH_BYTES || (!buffer_.empty() && now - last_flush >= FLUSH_INTERVAL) || stopping ||
+            wanted) {
+            flush(policy_ == SyncPolicy::Flush);
+            last_flush = now;
+        }
+        if (wanted) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                flushes_done_ = requested;
+            }
+            flushed_cv_.notify_all();
+        }
+        if (stopping) break;
+    }
+}
@@ -0,0 +1,96 @@
+// csv_writer.hpp
+#pragma once
+#include "audit_result.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Quando chamar fsync no CSV (chave csv_sync do cfg)
+enum class SyncPolicy {
+    None,  // Nunca; fica a cargo do sistema
+    Close, // Uma vez, ao fechar (padrão)
+    Flush  // A cada escrita em disco: perde no máximo um buffer numa queda
+};
+bool parse_sync_policy(const std::string& name, SyncPolicy& policy); // none|close|flush
+
+// Cabeçalho do CSV e, sem a auditoria de taxas dos CSVs antigos, só com as
+// 7 primeiras colunas
+extern const char CSV_HEADER[];
+extern const char CSV_BASE_HEADER[];
+
+// Acrescenta a linha i de 'rows' a 'out', com o '\n'
+void append_csv_row(std::string& out, const AuditBatch& rows, size_t i, bool base_columns = false);
+
+// Linha já gravada, com o tamanho do arquivo logo depois dela
+struct WrittenRow {
+    int height = 0;
+    Hash32 hash{};
+    uint64_t coinbase_outputs = 0;
+    uint64_t end_offset = 0;
+    std::optional<uint64_t> fees; // Com a auditoria de taxas
+};
+
+// Estágio de escrita do CSV: uma thread dona do arquivo recebe as linhas já
+// em ordem, em colunas (AuditBatch), formata com std::to_chars num buffer
+// reaproveitado e grava em blocos grandes com write(2). Os produtores só
+// copiam os resultados para a fila; o texto só existe aqui.
+class CsvWriter {
+public:
+    CsvWriter(const std::string& path, SyncPolicy policy);
+    ~CsvWriter();
+
+    // Chamado na thread de escrita depois de cada gravação (e do fsync, se
+    // houver) com as linhas que chegaram ao arquivo. Defina antes de abrir.
+    void set_on_flush(std::function<void(const std::vector<WrittenRow>&)> callback);
+
+    // Cria o arquivo com o cabeçalho e inicia a thread de escrita
+    bool open(std::string* error = nullptr);
+    // Mantém os primeiros keep_bytes de um CSV existente e continua depois
+    // deles, na largura do cabeçalho que ele já tem
+    bool open_append(uint64_t keep_bytes, std::string* error = nullptr);
+
+    // Enfileira as linhas, esvaziando 'rows' (que mantém a capacidade)
+    void push(AuditBatch& rows);
+    void push(const AuditResult& row);
+
+    // Grava já o que está na fila, sem esperar o buffer encher ou o
+    // intervalo, e só retorna depois da gravação (e do on_flush); false se
+    // alguma escrita falhou. Para o --follow, que escreve bloco a bloco.
+    bool flush_now();
+
+    // Grava o que falta, aplica a política de fsync e fecha; false se alguma
+    // escrita falhou. Depois de fechado, pode ser aberto de novo.
+    bool close();
+
+    uint64_t rows_written() const;
+
+private:
+    bool start(uint64_t keep_bytes, std::string* error);
+    void run();
+    bool flush(bool sync);
+
+    std::string path_;
+    SyncPolicy policy_;
+    int fd_ = -1;
+    bool failed_ = false;          // Só a thread de escrita altera antes do join
+    bool base_columns_ = false;    // CSV existente com CSV_BASE_HEADER
+    std::string buffer_;           // Só a thread de escrita acessa
+    uint64_t offset_ = 0;          // Bytes já gravados no arquivo
+    std::function<void(const std::vector<WrittenRow>&)> on_flush_;
+    std::vector<WrittenRow> flushed_; // Linhas no buffer, para on_flush_
+    uint64_t rows_ = 0;            // Protegido por mutex_
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable flushed_cv_;
+    AuditBatch queue_;
+    bool stop_ = false;
+    uint64_t flush_requests_ = 0; // Pedidos de flush_now(), protegidos por mutex_
+    uint64_t flushes_done_ = 0;
+};
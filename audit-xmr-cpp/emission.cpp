@@ -0,0 +1,133 @@
+// emission.cpp
+#include "emission.hpp"
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+uint64_t add_capped(uint64_t a, uint64_t b) {
+    return a > MONEY_SUPPLY - b ? MONEY_SUPPLY : a + b;
+}
+
+// Acima da zona sem penalidade a base pode ter sido reduzida pelo peso
+// (a mediana não é calculada aqui): só o teto vale. Peso 0 = desconhecido.
+bool may_have_penalty(uint64_t weight, uint64_t major_version) {
+    return weight == 0 || weight > full_reward_zone(major_version);
+}
+
+// Emissão fora de [least, most]: acima do teto, ou abaixo do piso quando a
+// versão exige o valor exato e não há penalidade possível
+bool emission_mismatch(uint64_t emission, uint64_t least, uint64_t most, uint64_t major_version, uint64_t weight) {
+    return emission > most ||
+           (!may_have_penalty(weight, major_version) && hard_fork_rules(major_version).exact_coinbase && emission < least);
+}
+
+} // namespace
+
+void EmissionTracker::reset(int next_height, std::optional<uint64_t> generated) {
+    next_ = next_height;
+    known_ = generated.has_value();
+    lo_ = hi_ = generated.value_or(0);
+}
+
+bool EmissionTracker::check(AuditResult& r, std::string* detail) {
+    if (r.height != next_) known_ = false;
+    next_ = r.height + 1;
+    if (r.generated) {
+        // A fonte sabe as moedas geradas (lmdb, raw): valor exato
+        known_ = true;
+        lo_ = hi_ = *r.generated;
+    }
+    if (!r.fees || r.major_version == 0 || *r.fees > r.coinbase_outputs) {
+        known_ = false;
+        ++unverified_;
+        if (detail) *detail = !r.fees ? "taxas desconhecidas" : r.major_version == 0 ? "versão desconhecida"
+                                                                                   : "taxas acima da coinbase";
+        return false;
+    }
+    if (!known_) {
+        known_ = true;
+        lo_ = 0;
+        hi_ = MONEY_SUPPLY;
+    }
+
+    uint64_t version = r.major_version;
+    uint64_t emission = r.coinbase_outputs - *r.fees;
+    uint64_t most = base_block_reward(lo_, version);
+    uint64_t least = base_block_reward(hi_, version);
+    bool penalty = may_have_penalty(r.weight, version);
+    ++checked_;
+
+    if (emission_mismatch(emission, least, most, version, r.weight)) {
+        ++mismatches_;
+        r.add_issue(ISSUE_BASE_FEES);
+        if (detail) {
+            std::stringstream ss;
+            ss << "emissão " << emission << " (coinbase " << r.coinbase_outputs << " - taxas " << *r.fees
+               << ") diferente da base " << least;
+            if (most != least) ss << ".." << most;
+            *detail = ss.str();
+        }
+    } else if (!penalty && emission >= least) {
+        // base = (MONEY_SUPPLY - G) >> shift: a emissão cobrada estreita a
+        // faixa de G. Na tail emission só o limite de baixo é conhecido.
+        int shift = emission_shift(version);
+        uint64_t tail = tail_emission(version);
+        if (emission > tail) {
+            uint64_t top = MONEY_SUPPLY - (emission << shift);
+            lo_ = std::max(lo_, top - ((uint64_t(1) << shift) - 1));
+            hi_ = std::min(hi_, top);
+        } else {
+            lo_ = std::max(lo_, MONEY_SUPPLY - ((tail + 1) << shift) + 1);
+        }
+        if (detail) detail->clear();
+    } else if (detail) {
+        detail->clear();
+    }
+    lo_ = add_capped(lo_, emission);
+    hi_ = add_capped(hi_, emission);
+    return true;
+}
+
+std::optional<uint64_t> EmissionTracker::generated() const {
+    if (known_ && lo_ == hi_) return lo_;
+    return std::nullopt;
+}
+
+uint64_t verify_emission(std::vector<EmissionBlock>& blocks, uint64_t generated_before, unsigned threads) {
+    size_t n = blocks.size();
+    size_t parts = std::max<size_t>(1, std::min<size_t>(threads, n / 4096 + 1)); // Partes pequenas não compensam a thread
+    size_t step = (n + parts - 1) / parts;
+    auto run = [&](auto&& body) {
+        std::vector<std::thread> pool;
+        for (size_t p = 1; p < parts; ++p) pool.emplace_back(body, p);
+        body(0);
+        for (auto& t : pool) t.join();
+    };
+    auto emission_of = [](const EmissionBlock& b) { return b.fees > b.coinbase ? 0 : b.coinbase - b.fees; };
+
+    // 1) Emissão de cada parte
+    std::vector<uint64_t> start(parts + 1, 0);
+    run([&](size_t p) {
+        uint64_t sum = 0;
+        for (size_t i = p * step; i < std::min(n, (p + 1) * step); ++i) sum = add_capped(sum, emission_of(blocks[i]));
+        start[p + 1] = sum;
+    });
+    // 2) Soma de prefixo: moedas geradas antes de cada parte
+    start[0] = generated_before;
+    for (size_t p = 1; p <= parts; ++p) start[p] = add_capped(start[p - 1], start[p]);
+    // 3) Base de cada bloco a partir do início da sua parte
+    run([&](size_t p) {
+        uint64_t generated = start[p];
+        for (size_t i = p * step; i < std::min(n, (p + 1) * step); ++i) {
+            EmissionBlock& b = blocks[i];
+            b.base = base_block_reward(generated, b.major_version);
+            b.mismatch = b.fees > b.coinbase ||
+                         emission_mismatch(emission_of(b), b.base, b.base, b.major_version, b.weight);
+            generated = add_capped(generated, emission_of(b));
+            b.generated = generated;
+        }
+    });
+    return start[parts];
+}
@@ -0,0 +1,124 @@
+// emission.hpp
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "audit.hpp"
+
+// Constantes da emissão (cryptonote_config.h)
+constexpr uint64_t MONEY_SUPPLY = ~uint64_t(0);
+constexpr int EMISSION_SPEED_FACTOR_PER_MINUTE = 20;
+constexpr uint64_t FINAL_SUBSIDY_PER_MINUTE = 300000000000ULL; // 0,3 XMR por minuto de alvo
+
+// Regras de cada versão maior e altura de ativação na mainnet (hardforks.cpp)
+struct HardFork {
+    uint64_t version;
+    uint64_t height;
+    int target_minutes;        // Alvo de 60 s na v1 e de 120 s a partir da v2
+    uint64_t full_reward_zone; // Peso até o qual o bloco não sofre penalidade
+    bool exact_coinbase;       // Da v2 à v12 o minerador podia cobrar menos (evitava poeira)
+};
+
+inline constexpr HardFork HARD_FORKS[] = {
+    {  1,       0, 1,  20000, true  }, {  2, 1009827, 2,  60000, false },
+    {  3, 1141317, 2,  60000, false }, {  4, 1220516, 2,  60000, false },
+    {  5, 1288616, 2, 300000, false }, {  6, 1400000, 2, 300000, false },
+    {  7, 1546000, 2, 300000, false }, {  8, 1685555, 2, 300000, false },
+    {  9, 1686275, 2, 300000, false }, { 10, 1788000, 2, 300000, false },
+    { 11, 1788720, 2, 300000, false }, { 12, 1978433, 2, 300000, false },
+    { 13, 2210000, 2, 300000, true  }, { 14, 2210720, 2, 300000, true  },
+    { 15, 2688888, 2, 300000, true  }, { 16, 2689608, 2, 300000, true  },
+};
+constexpr size_t HARD_FORK_COUNT = sizeof(HARD_FORKS) / sizeof(HARD_FORKS[0]);
+
+// Regras da versão; versões futuras seguem as da última conhecida
+constexpr const HardFork& hard_fork_rules(uint64_t major_version) {
+    return HARD_FORKS[major_version < 1 ? 0 : major_version > HARD_FORK_COUNT ? HARD_FORK_COUNT - 1 : major_version - 1];
+}
+
+// Versão maior de um bloco da mainnet pela altura
+constexpr uint64_t mainnet_version(uint64_t height) {
+    uint64_t version = 1;
+    for (const auto& fork : HARD_FORKS) {
+        if (height >= fork.height) version = fork.version;
+    }
+    return version;
+}
+
+constexpr uint64_t full_reward_zone(uint64_t major_version) {
+    return hard_fork_rules(major_version).full_reward_zone;
+}
+
+// Recompensa base do Monero (get_block_reward do monerod, sem a penalidade
+// de peso): (MONEY_SUPPLY - geradas) >> 20 até a v1 e >> 19 a partir da v2,
+// nunca abaixo da tail emission
+constexpr int emission_shift(uint64_t major_version) {
+    return EMISSION_SPEED_FACTOR_PER_MINUTE - (hard_fork_rules(major_version).target_minutes - 1);
+}
+constexpr uint64_t tail_emission(uint64_t major_version) {
+    return FINAL_SUBSIDY_PER_MINUTE * static_cast<uint64_t>(hard_fork_rules(major_version).target_minutes);
+}
+constexpr uint64_t base_block_reward(uint64_t already_generated, uint64_t major_version) {
+    uint64_t base = (MONEY_SUPPLY - already_generated) >> emission_shift(major_version);
+    return base < tail_emission(major_version) ? tail_emission(major_version) : base;
+}
+
+static_assert(base_block_reward(0, 1) == 17592186044415ULL, "recompensa do bloco gênese da mainnet");
+static_assert(base_block_reward(MONEY_SUPPLY - 1, 16) == 600000000000ULL, "tail emission de 0,6 XMR");
+static_assert(mainnet_version(1009826) == 1 && mainnet_version(1009827) == 2 && mainnet_version(3000000) == 16,
+              "tabela de hard forks fora de ordem");
+
+// Confere, em ordem de altura, reward == recompensa base + taxas. A base
+// depende das moedas geradas antes do bloco, acompanhadas aqui somando a
+// emissão de cada bloco (coinbase - taxas), como o monerod faz. Sem o valor
+// inicial (auditoria que não começa na altura 0), o acompanhamento parte de
+// uma faixa que o primeiro bloco sem penalidade estreita, supondo que ele
+// cobrou a recompensa inteira.
+class EmissionTracker {
+public:
+    // Próxima altura esperada e, se conhecidas, as moedas geradas antes dela
+    void reset(int next_height, std::optional<uint64_t> generated);
+
+    // Confere o bloco seguinte e acrescenta o problema "Reward != Base+Fees"
+    // quando a emissão passa da base (ou, nas versões que exigem o valor
+    // exato, fica abaixo dela sem penalidade possível). Um salto de altura
+    // ou taxas desconhecidas reiniciam o acompanhamento. Retorna false se o
+    // bloco não pôde ser conferido; 'detail' explica a discrepância.
+    bool check(AuditResult& r, std::string* detail = nullptr);
+
+    // Moedas geradas até o último bloco conferido, se conhecidas com exatidão
+    std::optional<uint64_t> generated() const;
+
+    uint64_t checked() const { return checked_; }
+    uint64_t mismatches() const { return mismatches_; }
+    uint64_t unverified() const { return unverified_; }
+
+private:
+    int next_ = 0;
+    bool known_ = false; // Faixa [lo_, hi_] das moedas geradas antes de next_
+    uint64_t lo_ = 0;
+    uint64_t hi_ = 0;
+    uint64_t checked_ = 0;
+    uint64_t mismatches_ = 0;
+    uint64_t unverified_ = 0;
+};
+
+// Bloco para a conferência em paralelo de um trecho contínuo de alturas
+struct EmissionBlock {
+    uint64_t coinbase = 0;
+    uint64_t fees = 0;
+    uint64_t major_version = 0;
+    uint64_t weight = 0;    // 0 = desconhecido (penalidade possível)
+    uint64_t base = 0;      // Saída: recompensa base do bloco
+    uint64_t generated = 0; // Saída: moedas geradas até o bloco, inclusive
+    bool mismatch = false;  // Saída: Reward != Base+Fees
+};
+
+// Mesma conferência do EmissionTracker sobre um trecho já inteiro na
+// memória, a partir das moedas geradas antes do primeiro bloco. A emissão
+// de cada bloco não depende da base, então cada thread soma a da sua parte,
+// uma soma de prefixo sobre as partes dá as moedas geradas no início de
+// cada uma, e as threads conferem as suas em paralelo. Retorna as moedas
+// geradas no fim do trecho.
+uint64_t verify_emission(std::vector<EmissionBlock>& blocks, uint64_t generated_before, unsigned threads);
@@ -0,0 +1,321 @@
+// engine.cpp
+#include "engine.hpp"
+#include "rpc.hpp"
+#include "log.hpp"
+#include "nodes.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+extern std::string g_log_path; // Definido em audit-xmr.cpp
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Uma requisição get_block; o handle e os buffers são reaproveitados
+struct Transfer {
+    CURL* curl = nullptr;
+    int height = 0;
+    int attempt = 0;
+    int node = -1; // Nó escolhido pelo balanceamento
+    Clock::time_point started;
+    std::string body;
+    std::string response;
+};
+
+// Resposta recebida pela thread de I/O, ainda não parseada
+struct Job {
+    int height = 0;
+    int attempt = 0;
+    bool ok = false;
+    std::string response;
+};
+
+// Alturas aguardando nova tentativa, liberadas quando o backoff vence
+class RetryQueue {
+public:
+    void push(int height, int attempt, Clock::time_point due) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back({height, attempt, due});
+    }
+
+    bool pop_due(Clock::time_point now, int& height, int& attempt) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->due <= now) {
+                height = it->height;
+                attempt = it->attempt;
+                entries_.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Entry {
+        int height;
+        int attempt;
+        Clock::time_point due;
+    };
+    std::mutex mutex_;
+    std::deque<Entry> entries_;
+};
+
+// Estado compartilhado pelas threads de I/O e pelo pool de CPU
+struct Shared {
+    RetryQueue retries;
+    std::atomic<int> outstanding{0}; // Alturas reservadas ainda sem resultado final
+    int max_retries = 0;
+    ConcurrencyController* controller = nullptr;
+    std::function<int(int)> height_of;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> retried{0};
+    std::atomic<int> inflight{0};
+    std::atomic<int> peak_inflight{0};
+    std::atomic<uint64_t> inflight_us{0}; // Integral de (em voo x tempo) em microssegundos
+
+    // Agenda nova tentativa; false quando as tentativas acabaram
+    bool schedule_retry(int height, int attempt) {
+        if (attempt >= max_retries) return false;
+        retried++;
+        retries.push(height, attempt + 1, Clock::now() + backoff_delay(attempt + 1));
+        return true;
+    }
+};
+
+class CpuPool {
+public:
+    CpuPool(int threads, const ResultSink& sink, Shared& shared) : sink_(sink), shared_(shared) {
+        for (int i = 0; i < std::max(1, threads); ++i) {
+            threads_.emplace_back([this] { run(); });
+        }
+    }
+
+    void submit(Job&& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    // Processa o que restou na fila e encerra as threads
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+private:
+    void run() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return closing_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+
+            BlockFields fields;
+            if (!job.ok || !parse_block_response(job.height, job.response, fields)) {
+                // Resposta de erro do nó (ocupado, limite...) também vale nova tentativa
+                if (job.ok && shared_.schedule_retry(job.height, job.attempt)) continue;
+                log_message(g_log_path, "[ERRO] Falha ao obter bloco " + std::to_string(job.height), false);
+                sink_(job.height, std::nullopt);
+            } else {
+                sink_(job.height, audit_fields(job.height, fields));
+            }
+            shared_.outstanding--;
+        }
+    }
+
+    const ResultSink& sink_;
+    Shared& shared_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    bool closing_ = false;
+    std::vector<std::thread> threads_;
+};
+
+void io_loop(BlockScheduler& scheduler, int inflight, CpuPool& pool, Shared& shared) {
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        log_message(g_log_path, "[ERRO] Falha ao criar o handle curl_multi", false);
+        return;
+    }
+    curl_slist* headers = curl_slist_append(nullptr, "Content-Type: application/json");
+
+    std::vector<Transfer> transfers(inflight);
+    std::vector<Transfer*> idle;
+    for (auto& t : transfers) {
+        t.curl = rpc_new_handle();
+        if (!t.curl) continue;
+        curl_easy_setopt(t.curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(t.curl, CURLOPT_PRIVATE, &t);
+        idle.push_back(&t);
+    }
+
+    BlockScheduler::Cursor cursor;
+    bool exhausted = idle.empty();
+    int active = 0;
+    auto last_sample = Clock::now();
+
+    // Termina quando o escalonador acabou e nenhuma altura espera resultado
+    // (uma falha de parse no pool de CPU ainda pode gerar nova tentativa)
+    while (!exhausted || active > 0 || shared.outstanding.load() > 0) {
+        // Completa a fila de requisições em voo: primeiro as novas tentativas
+        // vencidas, depois alturas novas do escalonador
+        while (!idle.empty()) {
+            if (shared.controller && !shared.controller->try_acquire()) break;
+            int height = 0, attempt = 0;
+            if (!shared.retries.pop_due(Clock::now(), height, attempt)) {
+                int from = 0, to = -1;
+                BlockScheduler::Claim claim = exhausted ? BlockScheduler::Claim::Done
+                                                        : scheduler.try_next(cursor, from, to);
+                if (claim == BlockScheduler::Claim::Done) exhausted = true;
+                if (claim != BlockScheduler::Claim::Ok) {
+                    if (shared.controller) shared.controller->abandon();
+                    break;
+                }
+                height = shared.height_of ? shared.height_of(from) : from;
+                shared.outstanding++;
+            }
+
+            Transfer* t = idle.back();
+            idle.pop_back();
+            t->height = height;
+            t->attempt = attempt;
+            t->started = Clock::now();
+            t->body = rpc_json_body("get_block", "{\"height\":" + std::to_string(height) + "}");
+            // Com vários nós cada transferência vai ao de menor latência
+            // estimada; aqui não há pedido duplicado
+            t->node = pick_rpc_node();
+            rpc_prepare_post(t->curl, t->node >= 0 ? rpc_node_url(t->node) : RPC_URL, t->body, &t->response);
+            rpc_node_started(t->node);
+            curl_multi_add_handle(multi, t->curl);
+            ++active;
+
+            int depth = ++shared.inflight;
+            int peak = shared.peak_inflight.load();
+            while (depth > peak && !shared.peak_inflight.compare_exchange_weak(peak, depth)) {}
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg;
+        int pending = 0;
+        while ((msg = curl_multi_info_read(multi, &pending))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            CURL* easy = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            Transfer* t = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, reinterpret_cast<char**>(&t));
+            curl_multi_remove_handle(multi, easy);
+
+            bool ok = rpc_finish_transfer(easy, result, "get_block");
+            double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - t->started).count();
+            if (shared.controller) shared.controller->release(ok, latency_ms);
+            rpc_node_finished(t->node, ok, latency_ms);
+            shared.requests++;
+            if (!ok) shared.failures++;
+
+            if (ok || !shared.schedule_retry(t->height, t->attempt)) {
+                pool.submit(Job{t->height, t->attempt, ok, std::move(t->response)});
+            }
+            t->response = std::string();
+            idle.push_back(t);
+            --active;
+            --shared.inflight;
+        }
+
+        // Amostra a profundidade da fila para a média ponderada
+        auto now = Clock::now();
+        auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample).count();
+        last_sample = now;
+        shared.inflight_us += static_cast<uint64_t>(active) * static_cast<uint64_t>(elapsed_us);
+
+        // Sem nada em voo só esperamos a janela, o controle ou um backoff liberar
+        curl_multi_poll(multi, nullptr, 0, active > 0 ? 50 : 5, nullptr);
+    }
+
+    for (auto& t : transfers) {
+        if (t.curl) curl_easy_cleanup(t.curl);
+    }
+    curl_slist_free_all(headers);
+    curl_multi_cleanup(multi);
+}
+
+} // namespace
+
+AsyncEngineStats run_async_engine(BlockScheduler& scheduler, const AsyncEngineOptions& options,
+                                  const ResultSink& sink) {
+    int io_threads = std::max(1, options.io_threads);
+    int inflight = std::max(io_threads, options.inflight);
+
+    Shared shared;
+    shared.max_retries = std::max(0, options.max_retries);
+    shared.controller = options.controller;
+    shared.height_of = options.height_of;
+    CpuPool pool(options.cpu_threads, sink, shared);
+    auto start = Clock::now();
+
+    std::atomic<int> running(io_threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < io_threads; ++i) {
+        // Divide as requisições em voo entre as threads de I/O
+        int share = inflight / io_threads + (i < inflight % io_threads ? 1 : 0);
+        threads.emplace_back([&, share] {
+            io_loop(scheduler, share, pool, shared);
+            running--;
+        });
+    }
+
+    // Relatório periódico da profundidade e da vazão
+    uint64_t last_requests = 0;
+    auto last_report = start;
+    while (running.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = Clock::now();
+        double interval = std::chrono::duration<double>(now - last_report).count();
+        if (interval < 5.0) continue;
+        uint64_t requests = shared.requests.load();
+        std::stringstream ss;
+        ss << "[INFO] Motor assíncrono: " << shared.inflight.load() << " requisições em voo, "
+           << static_cast<uint64_t>((requests - last_requests) / interval) << " req/s";
+        if (shared.controller) ss << ", limite " << shared.controller->limit();
+        log_message(g_log_path, ss.str(), false);
+        last_requests = requests;
+        last_report = now;
+    }
+    for (auto& t : threads) t.join();
+    pool.finish();
+
+    AsyncEngineStats stats;
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stats.requests = shared.requests.load();
+    stats.failures = shared.failures.load();
+    stats.retries = shared.retried.load();
+    stats.peak_inflight = shared.peak_inflight.load();
+    stats.mean_inflight = stats.seconds > 0 ? shared.inflight_us.load() / (stats.seconds * 1e6) : 0;
+    return stats;
+}
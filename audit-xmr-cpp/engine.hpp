@@ -0,0 +1,41 @@
+// engine.hpp
+#pragma once
+#include "audit.hpp"
+#include "controller.hpp"
+#include "scheduler.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+// Motor assíncrono: poucas threads de I/O mantêm muitas requisições get_block
+// em voo com curl_multi, e um pool pequeno de threads faz o parse e a
+// auditoria. As alturas vêm do mesmo BlockScheduler do modo com threads.
+struct AsyncEngineOptions {
+    int inflight = 128;   // Requisições simultâneas, somando todas as threads de I/O
+    int io_threads = 1;
+    int cpu_threads = 2;
+    int max_retries = 0;  // Novas tentativas por altura, com backoff exponencial
+    ConcurrencyController* controller = nullptr; // Limite dinâmico dentro de 'inflight' (opcional)
+    // Altura do bloco na posição reservada do escalonador (padrão: a própria
+    // posição). Permite percorrer uma lista de alturas fora de sequência.
+    std::function<int(int)> height_of;
+};
+
+struct AsyncEngineStats {
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t retries = 0;
+    int peak_inflight = 0;
+    double mean_inflight = 0; // Média ponderada pelo tempo
+    double seconds = 0;
+
+    double requests_per_second() const { return seconds > 0 ? requests / seconds : 0; }
+};
+
+// Recebe cada resultado, fora de ordem, numa thread do pool de CPU. Um
+// std::nullopt indica que o bloco falhou.
+using ResultSink = std::function<void(int height, std::optional<AuditResult> result)>;
+
+// Audita todas as alturas do escalonador e retorna quando a última foi entregue ao sink
+AsyncEngineStats run_async_engine(BlockScheduler& scheduler, const AsyncEngineOptions& options,
+                                  const ResultSink& sink);
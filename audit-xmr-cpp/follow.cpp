@@ -0,0 +1,126 @@
+// follow.cpp
+#include "follow.hpp"
+#include "rpc.hpp"
+#include "log.hpp"
+#include "block_binary.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#ifdef AUDIT_XMR_HAVE_ZMQ
+#include <zmq.h>
+#endif
+
+extern std::string g_log_path;
+
+namespace {
+
+const char CHAIN_MAIN_TOPIC[] = "json-minimal-chain_main";
+const auto WAIT_SLICE = std::chrono::milliseconds(50); // Para notar 'stop' durante a espera
+
+} // namespace
+
+bool zmq_supported() {
+#ifdef AUDIT_XMR_HAVE_ZMQ
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool parse_chain_main(const std::string& message, ChainTip& tip) {
+    size_t colon = message.find(':');
+    if (colon == std::string::npos || message.compare(0, colon, CHAIN_MAIN_TOPIC) != 0) return false;
+    nlohmann::json body = nlohmann::json::parse(message.begin() + static_cast<std::ptrdiff_t>(colon) + 1, message.end(),
+                                                nullptr, false);
+    if (body.is_discarded() || !body.is_object() || !body.contains("first_height") || !body.contains("ids")) {
+        return false;
+    }
+    // Os get<> abaixo lançariam com outro tipo; a mensagem só é ignorada
+    const nlohmann::json& first = body["first_height"];
+    const nlohmann::json& ids = body["ids"];
+    if (!first.is_number_integer() || !ids.is_array() || ids.empty() || !ids.back().is_string()) return false;
+    int64_t height = first.get<int64_t>() + static_cast<int64_t>(ids.size()) - 1;
+    if (first.get<int64_t>() < 0 || height > std::numeric_limits<int>::max()) return false;
+    std::string hash = ids.back().get<std::string>();
+    Hash32 parsed;
+    if (!hash_from_hex(hash, parsed)) return false; // 64 dígitos hexadecimais
+    tip.height = static_cast<int>(height);
+    tip.hash = hash;
+    return true;
+}
+
+TipWatcher::TipWatcher(const std::string& zmq_endpoint, int poll_ms)
+    : endpoint_(zmq_endpoint), poll_interval_(std::max(1, poll_ms)) {}
+
+TipWatcher::~TipWatcher() {
+#ifdef AUDIT_XMR_HAVE_ZMQ
+    if (socket_) zmq_close(socket_);
+    if (context_) zmq_ctx_term(context_);
+#endif
+}
+
+bool TipWatcher::start(std::string* error) {
+    if (endpoint_.empty()) return true;
+#ifdef AUDIT_XMR_HAVE_ZMQ
+    context_ = zmq_ctx_new();
+    socket_ = context_ ? zmq_socket(context_, ZMQ_SUB) : nullptr;
+    if (!socket_ || zmq_setsockopt(socket_, ZMQ_SUBSCRIBE, CHAIN_MAIN_TOPIC, sizeof(CHAIN_MAIN_TOPIC) - 1) != 0 ||
+        zmq_connect(socket_, endpoint_.c_str()) != 0) {
+        if (error) *error = zmq_strerror(zmq_errno());
+        if (socket_) zmq_close(socket_);
+        socket_ = nullptr;
+        return false;
+    }
+    return true;
+#else
+    if (error) *error = "audit-xmr compilado sem libzmq";
+    return false;
+#endif
+}
+
+std::optional<ChainTip> TipWatcher::poll_node() {
+    last_poll_ = std::chrono::steady_clock::now();
+    BlockHeader header;
+    if (!get_last_block_header(header)) return std::nullopt;
+    ChainTip tip;
+    tip.height = header.height;
+    tip.hash = header.hash;
+    tip.seen = std::chrono::steady_clock::now();
+    return tip;
+}
+
+std::optional<ChainTip> TipWatcher::next(const std::atomic<bool>& stop) {
+    while (!stop) {
+        auto now = std::chrono::steady_clock::now();
+        auto due = last_poll_ + poll_interval_;
+        if (now >= due) return poll_node();
+        auto wait = std::min<std::chrono::steady_clock::duration>(due - now, WAIT_SLICE);
+#ifdef AUDIT_XMR_HAVE_ZMQ
+        if (socket_) {
+            zmq_pollitem_t item = { socket_, 0, ZMQ_POLLIN, 0 };
+            long ms = std::max<long>(1, static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(wait).count()));
+            if (zmq_poll(&item, 1, ms) <= 0 || !(item.revents & ZMQ_POLLIN)) continue;
+            // Várias mensagens na fila: só a última importa
+            std::optional<ChainTip> latest;
+            zmq_msg_t msg;
+            zmq_msg_init(&msg);
+            while (zmq_msg_recv(&msg, socket_, ZMQ_DONTWAIT) >= 0) {
+                std::string text(static_cast<const char*>(zmq_msg_data(&msg)), zmq_msg_size(&msg));
+                ChainTip tip;
+                if (parse_chain_main(text, tip)) {
+                    tip.seen = std::chrono::steady_clock::now();
+                    latest = tip;
+                } else {
+                    log_message(g_log_path, "[AVISO] Mensagem ZMQ ignorada: " + text.substr(0, 120));
+                }
+            }
+            zmq_msg_close(&msg);
+            if (latest) return latest;
+            continue;
+        }
+#endif
+        std::this_thread::sleep_for(wait);
+    }
+    return std::nullopt;
+}
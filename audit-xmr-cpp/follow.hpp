@@ -0,0 +1,50 @@
+// follow.hpp
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+
+// Topo da cadeia do nó e o instante em que o audit-xmr ficou sabendo dele
+struct ChainTip {
+    int height = -1;
+    std::string hash;
+    std::chrono::steady_clock::time_point seen;
+};
+
+bool zmq_supported();
+
+// Aviso de blocos novos para o --follow. Com um endereço ZMQ (e o
+// audit-xmr compilado com libzmq, AUDIT_XMR_HAVE_ZMQ), assina o tópico
+// json-minimal-chain_main do monerod (--zmq-pub) e o topo vem da própria
+// mensagem; o get_last_block_header a cada poll_ms continua como rede de
+// segurança para mensagens perdidas. Sem ZMQ, só a consulta periódica.
+class TipWatcher {
+public:
+    TipWatcher(const std::string& zmq_endpoint, int poll_ms);
+    ~TipWatcher();
+
+    // Conecta ao publicador; sem endereço não há o que fazer
+    bool start(std::string* error = nullptr);
+    bool using_zmq() const { return socket_ != nullptr; }
+
+    // Espera o próximo aviso ou o fim do intervalo e devolve o topo atual.
+    // A primeira chamada consulta o nó na hora. nullopt se 'stop' foi
+    // ligado ou se a consulta falhou.
+    std::optional<ChainTip> next(const std::atomic<bool>& stop);
+    // Faz a próxima chamada consultar o nó na hora
+    void wake() { last_poll_ = {}; }
+
+private:
+    std::optional<ChainTip> poll_node();
+
+    std::string endpoint_;
+    std::chrono::milliseconds poll_interval_;
+    std::chrono::steady_clock::time_point last_poll_{};
+    void* context_ = nullptr;
+    void* socket_ = nullptr;
+};
+
+// Mensagem "json-minimal-chain_main:{...}" do monerod: o topo é o último
+// de 'ids', na altura first_height + ids.size() - 1
+bool parse_chain_main(const std::string& message, ChainTip& tip);
@@ -0,0 +1,217 @@
+// keccak.cpp
+#include "keccak.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KECCAK_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint64_t ROUND_CONSTANTS[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+// Rotações e ordem de visita do passo rho-pi (índices em x + 5y)
+const int ROTATIONS[24] = { 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+                            27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44 };
+const int PI_LANES[24] = { 10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+                           15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1 };
+
+const size_t RATE = 136; // 1088 bits para saída de 256 bits
+
+inline uint64_t rotl(uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+void keccak_f1600(uint64_t st[25]) {
+    uint64_t bc[5];
+    for (int round = 0; round < 24; ++round) {
+        // theta
+        for (int i = 0; i < 5; ++i) bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        for (int i = 0; i < 5; ++i) {
+            uint64_t t = bc[(i + 4) % 5] ^ rotl(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) st[j + i] ^= t;
+        }
+        // rho e pi
+        uint64_t t = st[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = PI_LANES[i];
+            uint64_t next = st[j];
+            st[j] = rotl(t, ROTATIONS[i]);
+            t = next;
+        }
+        // chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) bc[i] = st[j + i];
+            for (int i = 0; i < 5; ++i) st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+        // iota
+        st[0] ^= ROUND_CONSTANTS[round];
+    }
+}
+
+// Lanes em little-endian, como na especificação (e no x86)
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+void absorb_block(uint64_t st[25], const uint8_t* block) {
+    for (size_t i = 0; i < RATE / 8; ++i) st[i] ^= load64(block + 8 * i);
+    keccak_f1600(st);
+}
+
+// Último bloco com o padding, a partir dos 'size' < RATE bytes restantes
+void pad_block(const uint8_t* data, size_t size, uint8_t last[RATE]) {
+    std::memset(last, 0, RATE);
+    if (size) std::memcpy(last, data, size);
+    last[size] |= 0x01;
+    last[RATE - 1] |= 0x80;
+}
+
+void squeeze(const uint64_t st[25], uint8_t out[32]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 8; ++b) out[8 * i + b] = static_cast<uint8_t>(st[i] >> (8 * b));
+    }
+}
+
+#ifdef KECCAK_HAVE_AVX2
+
+// Mesma permutação de keccak_f1600 sobre quatro estados: a faixa k de cada
+// registrador é a lane da mensagem k
+__attribute__((target("avx2")))
+inline __m256i rotl4(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_sll_epi64(x, _mm_cvtsi32_si128(n)), _mm256_srl_epi64(x, _mm_cvtsi32_si128(64 - n)));
+}
+
+__attribute__((target("avx2")))
+void keccak_f1600_x4(__m256i st[25]) {
+    __m256i bc[5];
+    for (int round = 0; round < 24; ++round) {
+        for (int i = 0; i < 5; ++i) {
+            bc[i] = _mm256_xor_si256(_mm256_xor_si256(st[i], st[i + 5]),
+                                     _mm256_xor_si256(_mm256_xor_si256(st[i + 10], st[i + 15]), st[i + 20]));
+        }
+        for (int i = 0; i < 5; ++i) {
+            __m256i t = _mm256_xor_si256(bc[(i + 4) % 5], rotl4(bc[(i + 1) % 5], 1));
+            for (int j = 0; j < 25; j += 5) st[j + i] = _mm256_xor_si256(st[j + i], t);
+        }
+        __m256i t = st[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = PI_LANES[i];
+            __m256i next = st[j];
+            st[j] = rotl4(t, ROTATIONS[i]);
+            t = next;
+        }
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) bc[i] = st[j + i];
+            for (int i = 0; i < 5; ++i) {
+                st[j + i] = _mm256_xor_si256(st[j + i], _mm256_andnot_si256(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+            }
+        }
+        st[0] = _mm256_xor_si256(st[0], _mm256_set1_epi64x(static_cast<long long>(ROUND_CONSTANTS[round])));
+    }
+}
+
+// Quatro mensagens com 'blocks' blocos cada (contando o do padding)
+__attribute__((target("avx2")))
+void keccak256_x4(const uint8_t* const data[4], const size_t sizes[4], size_t blocks, uint8_t* const out[4]) {
+    __m256i st[25];
+    for (int i = 0; i < 25; ++i) st[i] = _mm256_setzero_si256();
+    uint8_t last[4][RATE];
+    const uint8_t* block[4];
+    for (size_t b = 0; b < blocks; ++b) {
+        for (int k = 0; k < 4; ++k) {
+            if (b + 1 < blocks) {
+                block[k] = data[k] + b * RATE;
+            } else {
+                pad_block(data[k] + b * RATE, sizes[k] - b * RATE, last[k]);
+                block[k] = last[k];
+            }
+        }
+        for (size_t i = 0; i < RATE / 8; ++i) {
+            __m256i lanes = _mm256_set_epi64x(
+                static_cast<long long>(load64(block[3] + 8 * i)), static_cast<long long>(load64(block[2] + 8 * i)),
+                static_cast<long long>(load64(block[1] + 8 * i)), static_cast<long long>(load64(block[0] + 8 * i)));
+            st[i] = _mm256_xor_si256(st[i], lanes);
+        }
+        keccak_f1600_x4(st);
+    }
+    alignas(32) uint64_t lanes[4][4];
+    for (int i = 0; i < 4; ++i) _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[i]), st[i]);
+    for (int k = 0; k < 4; ++k) {
+        uint64_t state[25];
+        for (int i = 0; i < 4; ++i) state[i] = lanes[i][k];
+        squeeze(state, out[k]);
+    }
+}
+
+bool avx2_available() {
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+}
+
+#endif
+
+} // namespace
+
+void keccak256(const uint8_t* data, size_t size, uint8_t out[32]) {
+    uint64_t st[25] = {};
+    for (; size >= RATE; size -= RATE, data += RATE) absorb_block(st, data);
+
+    uint8_t last[RATE];
+    pad_block(data, size, last);
+    absorb_block(st, last);
+    squeeze(st, out);
+}
+
+void keccak256_many(size_t count, const uint8_t* const* data, const size_t* sizes, uint8_t* const* out) {
+#ifdef KECCAK_HAVE_AVX2
+    if (avx2_available() && count >= 4) {
+        // Agrupa pelo número de blocos absorvidos; cada grupo de quatro
+        // termina a permutação junto
+        std::vector<std::pair<size_t, size_t>> order(count);
+        for (size_t i = 0; i < count; ++i) order[i] = { sizes[i] / RATE + 1, i };
+        std::sort(order.begin(), order.end());
+        std::vector<size_t> rest;
+        size_t i = 0;
+        while (i < count) {
+            size_t j = i;
+            while (j < count && order[j].first == order[i].first) ++j;
+            for (; i + 4 <= j; i += 4) {
+                const uint8_t* d[4];
+                size_t s[4];
+                uint8_t* o[4];
+                for (int k = 0; k < 4; ++k) {
+                    size_t m = order[i + k].second;
+                    d[k] = data[m];
+                    s[k] = sizes[m];
+                    o[k] = out[m];
+                }
+                keccak256_x4(d, s, order[i].first, o);
+            }
+            for (; i < j; ++i) rest.push_back(order[i].second);
+        }
+        for (size_t m : rest) keccak256(data[m], sizes[m], out[m]);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) keccak256(data[i], sizes[i], out[i]);
+}
+
+const char* keccak_many_impl() {
+#ifdef KECCAK_HAVE_AVX2
+    if (avx2_available()) return "avx2x4";
+#endif
+    return "escalar";
+}
@@ -0,0 +1,17 @@
+// keccak.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Keccak-256 com o padding original (0x01 ... 0x80), não o do SHA3: é o
+// cn_fast_hash do Monero, usado nos ids de bloco e de transação
+void keccak256(const uint8_t* data, size_t size, uint8_t out[32]);
+
+// Vários Keccak-256 independentes: out[i] = keccak256(data[i], sizes[i]).
+// Em x86-64 com AVX2, as mensagens com o mesmo número de blocos de 136
+// bytes passam de quatro em quatro pela permutação, uma em cada faixa de
+// 64 bits dos registradores; as que sobram (e todas, sem AVX2) vão uma a uma.
+void keccak256_many(size_t count, const uint8_t* const* data, const size_t* sizes, uint8_t* const* out);
+
+// Caminho usado por keccak256_many nesta CPU: "avx2x4" ou "escalar"
+const char* keccak_many_impl();
@@ -0,0 +1,72 @@
+// linkage.cpp
+#include "linkage.hpp"
+
+void ChainLinker::seed(int height, const Hash32& hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tails_[height] = hash;
+}
+
+bool ChainLinker::link_head(int height, const Hash32& prev, Hash32* found) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_.erase(height - 1)) return true; // Sem o anterior, nada a conferir
+    auto it = tails_.find(height - 1);
+    if (it == tails_.end()) {
+        heads_[height] = prev;
+        return true;
+    }
+    bool ok = it->second == prev;
+    if (found) *found = it->second;
+    tails_.erase(it);
+    checked_++;
+    if (!ok) breaks_++;
+    return ok;
+}
+
+bool ChainLinker::link_tail(int height, const Hash32& hash, Hash32* found) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = heads_.find(height + 1);
+    if (it == heads_.end()) {
+        tails_[height] = hash;
+        return true;
+    }
+    bool ok = it->second == hash;
+    if (found) *found = it->second;
+    heads_.erase(it);
+    checked_++;
+    if (!ok) breaks_++;
+    return ok;
+}
+
+void ChainLinker::drop(int height, bool next_pending) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tails_.erase(height - 1);
+    failed_.erase(height - 1);
+    auto it = heads_.find(height + 1);
+    if (it != heads_.end()) {
+        heads_.erase(it);
+    } else if (next_pending) {
+        failed_.insert(height);
+    }
+}
+
+bool ChainLinker::head_links(int height, const Hash32& prev) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tails_.find(height - 1);
+    return it == tails_.end() || it->second == prev;
+}
+
+bool ChainLinker::tail_links(int height, const Hash32& hash) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = heads_.find(height + 1);
+    return it == heads_.end() || it->second == hash;
+}
+
+uint64_t ChainLinker::checked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return checked_;
+}
+
+uint64_t ChainLinker::breaks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return breaks_;
+}
@@ -0,0 +1,47 @@
+// linkage.hpp
+#pragma once
+#include <cstdint>
+#include <map>
+#include <set>
+#include <mutex>
+#include "block_binary.hpp"
+
+// Conferência da ligação prev_hash -> hash anterior entre trechos auditados
+// por threads diferentes. Cada thread confere a ligação dos blocos dentro do
+// seu trecho e registra aqui só as pontas: o prev_hash do primeiro bloco e o
+// hash do último. A ponta que chega primeiro fica guardada até a vizinha
+// chegar; a conferência acontece uma vez, seja qual for a ordem, e o par é
+// descartado, então só as pontas ainda sem vizinha ocupam memória.
+class ChainLinker {
+public:
+    // Hash já conhecido de um bloco anterior ao início (ponto de retomada)
+    void seed(int height, const Hash32& hash);
+
+    // Ponta esquerda de um trecho: o bloco 'height' aponta para 'prev'. Com o
+    // hash do bloco anterior já registrado, confere e retorna false se não
+    // liga ('found' recebe esse hash); senão guarda 'prev' até ele chegar.
+    bool link_head(int height, const Hash32& prev, Hash32* found = nullptr);
+    // Ponta direita: o bloco 'height' tem o hash 'hash'. Com o prev_hash do
+    // bloco seguinte já registrado, confere ('found' recebe esse prev_hash).
+    bool link_tail(int height, const Hash32& hash, Hash32* found = nullptr);
+
+    // O bloco 'height' falhou e não vai chegar: descarta as pontas que
+    // esperavam por ele. Com 'next_pending', o bloco seguinte ainda vai
+    // chegar e a ponta esquerda dele não fica esperando.
+    void drop(int height, bool next_pending);
+
+    // As mesmas conferências sem registrar nada (antes de decidir buscar de novo)
+    bool head_links(int height, const Hash32& prev) const;
+    bool tail_links(int height, const Hash32& hash) const;
+
+    uint64_t checked() const;
+    uint64_t breaks() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<int, Hash32> heads_; // Altura -> prev_hash, à espera do bloco anterior
+    std::map<int, Hash32> tails_; // Altura -> hash, à espera do bloco seguinte
+    std::set<int> failed_;        // Blocos que falharam, à espera do seguinte
+    uint64_t checked_ = 0;
+    uint64_t breaks_ = 0;
+};
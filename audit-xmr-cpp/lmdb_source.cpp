@@ -0,0 +1,308 @@
+// lmdb_source.cpp
+#include "lmdb_source.hpp"
+#include "audit.hpp" // g_log_path e log_message
+#include <atomic>
+
+static std::atomic<bool> g_id_check(false);
+
+void set_lmdb_id_check(bool enabled) {
+    g_id_check = enabled;
+}
+
+#ifdef AUDIT_XMR_HAVE_LMDB
+
+#include "block_binary.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <lmdb.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Registro de "block_info" a partir da versão 4 do banco (mdb_block_info_4
+// em db_lmdb.cpp). Todas as entradas ficam como duplicatas de uma chave
+// zero, ordenadas por bi_height.
+struct BlockInfo {
+    uint64_t height;
+    uint64_t timestamp;
+    uint64_t coins;            // Moedas geradas até este bloco (sem taxas)
+    uint64_t weight;
+    uint64_t diff_lo;
+    uint64_t diff_hi;
+    uint8_t hash[32];
+    uint64_t cum_rct;
+    uint64_t long_term_weight;
+};
+static_assert(sizeof(BlockInfo) == 96, "layout de mdb_block_info_4");
+
+const uint32_t MIN_DB_VERSION = 4; // Primeira com mdb_block_info_4
+const uint32_t MAX_DB_VERSION = 5;
+const uint64_t ZERO_KEY = 0;
+
+MDB_env* g_env = nullptr;
+MDB_dbi g_blocks = 0;
+MDB_dbi g_block_info = 0;
+
+// Mesma comparação que o monerod registra para as duplicatas de block_info
+int compare_uint64(const MDB_val* a, const MDB_val* b) {
+    uint64_t va, vb;
+    std::memcpy(&va, a->mv_data, sizeof(va));
+    std::memcpy(&vb, b->mv_data, sizeof(vb));
+    return va < vb ? -1 : va > vb;
+}
+
+// Transação de leitura da thread, reaproveitada entre lotes
+struct ReadTxn {
+    MDB_txn* txn = nullptr;
+    ~ReadTxn() {
+        if (txn) mdb_txn_abort(txn);
+    }
+};
+
+void log_error(const std::string& message) {
+    log_message(g_log_path, "[ERRO] " + message);
+}
+
+} // namespace
+
+bool lmdb_supported() {
+    return true;
+}
+
+bool open_lmdb_source(const std::string& path, std::string* error) {
+    auto fail = [&](const std::string& what, int rc) {
+        if (error) *error = what + ": " + mdb_strerror(rc);
+        if (g_env) mdb_env_close(g_env);
+        g_env = nullptr;
+        return false;
+    };
+
+    // Diretório do monerod, diretório lmdb/ ou o arquivo data.mdb
+    std::error_code ec;
+    fs::path db = path;
+    unsigned int flags = MDB_RDONLY | MDB_NOTLS;
+    if (fs::is_directory(db / "lmdb", ec)) db /= "lmdb";
+    if (fs::is_regular_file(db, ec)) {
+        flags |= MDB_NOSUBDIR;
+    } else if (!fs::exists(db / "data.mdb", ec)) {
+        if (error) *error = "data.mdb não encontrado em " + db.string();
+        return false;
+    }
+
+    int rc = mdb_env_create(&g_env);
+    if (rc) return fail("mdb_env_create", rc);
+    mdb_env_set_maxdbs(g_env, 32); // O monerod abre pouco mais de 20 tabelas
+    rc = mdb_env_open(g_env, db.c_str(), flags, 0644);
+    if (rc == EACCES || rc == EROFS) {
+        // Sem permissão de escrita no lock.mdb: típico de uma cópia ou de um
+        // banco de outro usuário. Sem trava, o monerod não pode estar gravando.
+        log_message(g_log_path, "[AVISO] Sem acesso ao lock.mdb em " + db.string() + "; abrindo sem trava (MDB_NOLOCK)");
+        mdb_env_close(g_env);
+        g_env = nullptr;
+        rc = mdb_env_create(&g_env);
+        if (rc) return fail("mdb_env_create", rc);
+        mdb_env_set_maxdbs(g_env, 32);
+        rc = mdb_env_open(g_env, db.c_str(), flags | MDB_NOLOCK, 0644);
+    }
+    if (rc) return fail("mdb_env_open " + db.string(), rc);
+
+    // Abre as tabelas com as mesmas flags do monerod e confere a versão
+    MDB_txn* txn = nullptr;
+    rc = mdb_txn_begin(g_env, nullptr, MDB_RDONLY, &txn);
+    if (rc) return fail("mdb_txn_begin", rc);
+    MDB_dbi properties;
+    if ((rc = mdb_dbi_open(txn, "blocks", MDB_INTEGERKEY, &g_blocks)) ||
+        (rc = mdb_dbi_open(txn, "block_info", MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED, &g_block_info)) ||
+        (rc = mdb_set_dupsort(txn, g_block_info, compare_uint64)) ||
+        (rc = mdb_dbi_open(txn, "properties", 0, &properties))) {
+        mdb_txn_abort(txn);
+        return fail("tabelas do monerod", rc);
+    }
+    MDB_val key{ sizeof("version"), const_cast<char*>("version") };
+    MDB_val value;
+    uint32_t version = 0;
+    rc = mdb_get(txn, properties, &key, &value);
+    if (rc == 0 && value.mv_size == sizeof(version)) std::memcpy(&version, value.mv_data, sizeof(version));
+    // Mantém os handles das tabelas: commit em vez de abort
+    mdb_txn_commit(txn);
+    if (version < MIN_DB_VERSION) {
+        if (error) *error = "versão do banco " + std::to_string(version) + " não suportada (mínimo "
+                            + std::to_string(MIN_DB_VERSION) + "; abra com um monerod recente para migrar)";
+        mdb_env_close(g_env);
+        g_env = nullptr;
+        return false;
+    }
+    if (version > MAX_DB_VERSION) {
+        log_message(g_log_path, "[AVISO] Versão do banco LMDB " + std::to_string(version)
+                                + " mais nova que a conhecida (" + std::to_string(MAX_DB_VERSION) + ")");
+    }
+    return true;
+}
+
+int get_blockchain_height_lmdb() {
+    if (!g_env) return -1;
+    MDB_txn* txn = nullptr;
+    if (mdb_txn_begin(g_env, nullptr, MDB_RDONLY, &txn)) return -1;
+    MDB_stat stat;
+    int rc = mdb_stat(txn, g_blocks, &stat);
+    mdb_txn_abort(txn);
+    return rc ? -1 : static_cast<int>(stat.ms_entries);
+}
+
+bool get_blocks_fields_lmdb(int from, int to, std::vector<BlockFields>& out) {
+    out.clear();
+    if (!g_env || from < 0 || to < from) return false;
+    std::stringstream ss;
+
+    // Cada lote vê um snapshot próprio do banco (renew), e entre lotes a
+    // transação fica em reset para não segurar páginas antigas do monerod
+    thread_local ReadTxn reader;
+    int rc = reader.txn ? mdb_txn_renew(reader.txn) : mdb_txn_begin(g_env, nullptr, MDB_RDONLY, &reader.txn);
+    if (rc) {
+        log_error(std::string("mdb_txn_begin: ") + mdb_strerror(rc));
+        return false;
+    }
+    MDB_cursor* blocks = nullptr;
+    MDB_cursor* infos = nullptr;
+    struct Release {
+        MDB_txn* txn;
+        MDB_cursor*& blocks;
+        MDB_cursor*& infos;
+        ~Release() {
+            if (blocks) mdb_cursor_close(blocks);
+            if (infos) mdb_cursor_close(infos);
+            mdb_txn_reset(txn);
+        }
+    } release{ reader.txn, blocks, infos };
+    if ((rc = mdb_cursor_open(reader.txn, g_blocks, &blocks)) ||
+        (rc = mdb_cursor_open(reader.txn, g_block_info, &infos))) {
+        log_error(std::string("mdb_cursor_open: ") + mdb_strerror(rc));
+        return false;
+    }
+
+    // Moedas geradas até o bloco anterior ao lote: a emissão de cada bloco é
+    // a diferença, e as taxas são o que a coinbase tem além dela
+    uint64_t prev_coins = 0;
+    if (from > 0) {
+        uint64_t before = static_cast<uint64_t>(from - 1);
+        MDB_val key{ sizeof(ZERO_KEY), const_cast<uint64_t*>(&ZERO_KEY) };
+        MDB_val val{ sizeof(before), &before };
+        rc = mdb_cursor_get(infos, &key, &val, MDB_GET_BOTH);
+        if (rc || val.mv_size < sizeof(BlockInfo)) {
+            ss << "[ERRO] block_info do bloco " << before << " ausente no LMDB: " << (rc ? mdb_strerror(rc) : "registro curto");
+            log_message(g_log_path, ss.str());
+            return false;
+        }
+        std::memcpy(&prev_coins, static_cast<const uint8_t*>(val.mv_data) + offsetof(BlockInfo, coins), sizeof(prev_coins));
+    }
+
+    // Os dois cursores andam juntos, em ordem de altura
+    uint64_t first = static_cast<uint64_t>(from);
+    MDB_val block_key{ sizeof(first), &first };
+    MDB_val block_val;
+    MDB_val info_key{ sizeof(ZERO_KEY), const_cast<uint64_t*>(&ZERO_KEY) };
+    MDB_val info_val{ sizeof(first), &first };
+    int rc_block = mdb_cursor_get(blocks, &block_key, &block_val, MDB_SET_KEY);
+    int rc_info = mdb_cursor_get(infos, &info_key, &info_val, MDB_GET_BOTH);
+
+    out.resize(static_cast<size_t>(to - from) + 1);
+    std::string error;
+    // Com a verificação de id, os blobs (válidos até o fim da transação) são
+    // guardados e os ids calculados juntos no fim do lote
+    bool check_ids = g_id_check;
+    std::vector<ParsedBlock> parsed(check_ids ? out.size() : 0);
+    std::vector<BlockBlob> blobs;
+    for (int h = from; h <= to; ++h) {
+        if (rc_block || rc_info) {
+            ss << "[ERRO] Bloco " << h << " ausente no LMDB: " << mdb_strerror(rc_block ? rc_block : rc_info);
+            log_message(g_log_path, ss.str());
+            out.clear();
+            return false;
+        }
+        uint64_t key_height;
+        BlockInfo info;
+        std::memcpy(&key_height, block_key.mv_data, sizeof(key_height));
+        if (info_val.mv_size < sizeof(info)) {
+            ss << "[ERRO] Registro block_info curto demais no bloco " << h << " (" << info_val.mv_size << " bytes)";
+            log_message(g_log_path, ss.str());
+            out.clear();
+            return false;
+        }
+        std::memcpy(&info, info_val.mv_data, sizeof(info));
+        if (key_height != static_cast<uint64_t>(h) || info.height != static_cast<uint64_t>(h)) {
+            ss << "[ERRO] LMDB fora de sequência no bloco " << h << " (blocks " << key_height
+               << ", block_info " << info.height << ")";
+            log_message(g_log_path, ss.str());
+            out.clear();
+            return false;
+        }
+
+        ParsedBlock local;
+        ParsedBlock& block = check_ids ? parsed[static_cast<size_t>(h - from)] : local;
+        if (!parse_block_blob(static_cast<const uint8_t*>(block_val.mv_data), block_val.mv_size, block, &error)) {
+            ss << "[ERRO] Blob inválido no LMDB no bloco " << h << ": " << error;
+            log_message(g_log_path, ss.str());
+            out.clear();
+            return false;
+        }
+        BlockFields& f = out[static_cast<size_t>(h - from)];
+        f.hash = to_hex(info.hash, sizeof(info.hash));
+        f.prev_hash = to_hex(block.prev_id.data(), block.prev_id.size());
+        f.reward = block.miner_tx.vout_sum;
+        f.coinbase_sum = block.miner_tx.vout_sum;
+        f.vin_count = block.miner_tx.vin_count;
+        f.gen_height = block.miner_tx.gen_height;
+        f.major_version = block.major_version;
+        f.weight = info.weight;
+        f.generated = prev_coins;
+        uint64_t emission = info.coins - prev_coins;
+        if (info.coins >= prev_coins && block.miner_tx.vout_sum >= emission) {
+            f.fees = block.miner_tx.vout_sum - emission;
+        } else {
+            ss.str("");
+            ss << "[AVISO] Moedas geradas no LMDB (" << info.coins << ") não batem com a coinbase do bloco " << h
+               << "; taxas desconhecidas";
+            log_message(g_log_path, ss.str());
+        }
+        prev_coins = info.coins;
+        if (check_ids) blobs.push_back({ static_cast<const uint8_t*>(block_val.mv_data), block_val.mv_size, &block });
+
+        if (h < to) {
+            rc_block = mdb_cursor_get(blocks, &block_key, &block_val, MDB_NEXT);
+            rc_info = mdb_cursor_get(infos, &info_key, &info_val, MDB_NEXT_DUP);
+        }
+    }
+    if (check_ids) {
+        std::vector<Hash32> ids;
+        block_ids(blobs, ids);
+        for (size_t k = 0; k < ids.size(); ++k) out[k].computed_id = ids[k];
+    }
+    return true;
+}
+
+#else // Sem liblmdb
+
+bool lmdb_supported() {
+    return false;
+}
+
+bool open_lmdb_source(const std::string&, std::string* error) {
+    if (error) *error = "compilado sem suporte a LMDB (instale liblmdb e recompile)";
+    return false;
+}
+
+int get_blockchain_height_lmdb() {
+    return -1;
+}
+
+bool get_blocks_fields_lmdb(int, int, std::vector<BlockFields>& out) {
+    out.clear();
+    return false;
+}
+
+#endif
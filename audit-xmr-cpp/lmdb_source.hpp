@@ -0,0 +1,31 @@
+// lmdb_source.hpp
+#pragma once
+#include <string>
+#include <vector>
+#include "block_parse.hpp"
+
+// Fonte offline: lê os blocos direto do banco LMDB do monerod
+// (~/.bitmonero/lmdb/data.mdb), somente leitura, sem RPC. Usa as tabelas
+// "blocks" (altura -> blob do bloco, com a miner tx embutida) e
+// "block_info" (altura -> hash e demais metadados). Só funciona quando
+// compilado com liblmdb (AUDIT_XMR_HAVE_LMDB); sem ela, open_lmdb_source
+// falha com uma mensagem explicando isso.
+
+bool lmdb_supported();
+
+// Abre o banco: aceita o diretório do monerod, o diretório lmdb/ ou o
+// próprio data.mdb. Chame uma vez, antes das threads de leitura.
+bool open_lmdb_source(const std::string& path, std::string* error = nullptr);
+
+int get_blockchain_height_lmdb(); // Blocos no banco (-1 se não aberto)
+
+// Blocos [from, to] numa única transação de leitura da thread chamadora.
+// Cada thread reaproveita a própria transação (reset/renew entre chamadas),
+// então várias leem em paralelo sem se bloquear. O reward é a soma das
+// saídas da miner tx, como o monerod devolve em block_header.reward, e as
+// taxas saem das moedas geradas que o block_info guarda.
+bool get_blocks_fields_lmdb(int from, int to, std::vector<BlockFields>& out);
+
+// Verificação do id (--verify-id): recalcula o id de cada blob em
+// BlockFields::computed_id, para comparar com o hash do block_info
+void set_lmdb_id_check(bool enabled);
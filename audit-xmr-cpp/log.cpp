@@ -1,30 +1,291 @@
 // log.cpp
 #include "log.hpp"
-#include <fstream>
-#include <mutex>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct LogEntry {
+    uint32_t path_id = 0;
+    bool is_block_end = false;
+    std::time_t time = 0;
+    std::string text;
+};
+
+// Fila circular limitada, lock-free para vários produtores e um único
+// consumidor (algoritmo de D. Vyukov). Cada célula carrega um número de
+// sequência que indica se está livre para o produtor ou pronta para o
+// consumidor.
+class LogQueue {
+public:
+    explicit LogQueue(size_t capacity) : mask_(capacity - 1), cells_(new Cell[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(LogEntry&& entry) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // Cheia
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->entry = std::move(entry);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Apenas a thread de escrita chama pop()
+    bool pop(LogEntry& entry) {
+        Cell* cell = &cells_[dequeue_pos_ & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(dequeue_pos_ + 1) < 0) return false;
+        entry = std::move(cell->entry);
+        cell->seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        LogEntry entry;
+    };
+
+    size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;
+};
+
+struct LogFile {
+    std::string path;
+    FILE* file = nullptr;
+    uint64_t size = 0;
+};
+
+class AsyncLogger {
+public:
+    AsyncLogger() : queue_(1 << 14) {
+        writer_ = std::thread([this] { run(); });
+    }
+
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (writer_.joinable()) writer_.join();
+        for (auto& f : files_) {
+            if (f.file) std::fclose(f.file);
+        }
+    }
+
+    void enqueue(const std::string& path, const std::string& message, bool is_block_end) {
+        LogEntry entry;
+        entry.path_id = path_id(path);
+        entry.is_block_end = is_block_end;
+        entry.time = std::time(nullptr);
+        entry.text = message;
+        if (!queue_.push(std::move(entry))) {
+            dropped++;
+            return;
+        }
+        // seq_cst aqui e em run(): ou o escritor vê o novo contador, ou nós
+        // vemos que ele está dormindo e o acordamos
+        enqueued_.fetch_add(1);
+        if (sleeping_.load()) cv_.notify_one();
+    }
+
+    void flush() {
+        uint64_t target = enqueued_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.notify_all();
+        flushed_cv_.wait(lock, [&] { return written_ >= target || stop_; });
+    }
+
+    std::atomic<int> level{static_cast<int>(LogLevel::Info)};
+    std::atomic<uint64_t> max_size{0};
+    std::atomic<uint64_t> dropped{0};
+
+private:
+    // Os caminhos são poucos (normalmente um); cada thread guarda o último usado
+    // para não passar pelo mutex da tabela a cada mensagem
+    uint32_t path_id(const std::string& path) {
+        thread_local const AsyncLogger* cached_owner = nullptr;
+        thread_local std::string cached_path;
+        thread_local uint32_t cached_id = 0;
+        if (cached_owner == this && cached_path == path) return cached_id;
+
+        std::lock_guard<std::mutex> lock(paths_mutex_);
+        uint32_t id = 0;
+        while (id < paths_.size() && paths_[id] != path) ++id;
+        if (id == paths_.size()) paths_.push_back(path);
+        cached_owner = this;
+        cached_path = path;
+        cached_id = id;
+        return id;
+    }
+
+    LogFile* file_for(uint32_t id) {
+        if (id >= files_.size()) files_.resize(id + 1);
+        LogFile& f = files_[id];
+        if (f.file) return &f;
+        {
+            std::lock_guard<std::mutex> lock(paths_mutex_);
+            f.path = paths_[id];
+        }
+        if (f.path.empty()) return nullptr;
+        f.file = std::fopen(f.path.c_str(), "a");
+        if (!f.file) return nullptr;
+        std::setvbuf(f.file, nullptr, _IOFBF, 1 << 16);
+        std::fseek(f.file, 0, SEEK_END);
+        long pos = std::ftell(f.file);
+        f.size = pos > 0 ? static_cast<uint64_t>(pos) : 0;
+        return &f;
+    }
+
+    void rotate(LogFile& f) {
+        std::fclose(f.file);
+        f.file = nullptr;
+        std::string rotated = f.path + ".1";
+        std::rename(f.path.c_str(), rotated.c_str());
+    }
+
+    void write(const LogEntry& entry) {
+        LogFile* f = file_for(entry.path_id);
+        if (!f) return;
+
+        // localtime_r é reentrante; o timestamp formatado é reaproveitado
+        // enquanto o segundo não mudar
+        if (entry.time != last_time_) {
+            std::tm tm_buf;
+            localtime_r(&entry.time, &tm_buf);
+            std::strftime(timestamp_, sizeof(timestamp_), "%Y-%m-%d %H:%M:%S", &tm_buf);
+            last_time_ = entry.time;
+        }
+
+        int n = std::fprintf(f->file, "[%s] %s\n", timestamp_, entry.text.c_str());
+        if (n > 0) f->size += static_cast<uint64_t>(n);
+        if (entry.is_block_end) {
+            std::fputs("-----\n", f->file);
+            f->size += 6;
+        }
+
+        uint64_t limit = max_size.load(std::memory_order_relaxed);
+        if (limit > 0 && f->size >= limit) rotate(*f);
+    }
+
+    void run() {
+        LogEntry entry;
+        for (;;) {
+            bool any = false;
+            while (queue_.pop(entry)) {
+                write(entry);
+                ++written_local_;
+                any = true;
+            }
+            if (any) {
+                for (auto& f : files_) {
+                    if (f.file) std::fflush(f.file);
+                }
+            }
 
-static std::mutex log_mutex;
+            std::unique_lock<std::mutex> lock(mutex_);
+            written_ = written_local_;
+            flushed_cv_.notify_all();
+            if (stop_ && written_ >= enqueued_.load(std::memory_order_acquire)) break;
+
+            sleeping_.store(true);
+            if (written_ >= enqueued_.load()) {
+                cv_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            sleeping_.store(false);
+        }
+    }
+
+    LogQueue queue_;
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable flushed_cv_;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<uint64_t> enqueued_{0};
+    uint64_t written_local_ = 0; // Só a thread de escrita altera
+    uint64_t written_ = 0;       // Protegido por mutex_
+    bool stop_ = false;
+
+    std::mutex paths_mutex_;
+    std::vector<std::string> paths_;
+    std::vector<LogFile> files_; // Só a thread de escrita acessa
+
+    std::time_t last_time_ = -1;
+    char timestamp_[32] = {0};
+};
+
+AsyncLogger& logger() {
+    static AsyncLogger instance;
+    return instance;
+}
+
+LogLevel level_from_prefix(const std::string& message) {
+    if (message.compare(0, 7, "[DEBUG]") == 0) return LogLevel::Debug;
+    if (message.compare(0, 7, "[AVISO]") == 0) return LogLevel::Warn;
+    if (message.compare(0, 6, "[ERRO]") == 0) return LogLevel::Error;
+    return LogLevel::Info;
+}
+
+} // namespace
 
 void log_message(const std::string& log_path, const std::string& message) {
     log_message(log_path, message, false);
 }
 
 void log_message(const std::string& log_path, const std::string& message, bool is_block_end) {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    std::stringstream timestamp;
-    timestamp << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+    if (!log_enabled(level_from_prefix(message))) return;
+    logger().enqueue(log_path, message, is_block_end);
+}
 
-    std::lock_guard<std::mutex> lock(log_mutex);
-    std::ofstream log_file(log_path, std::ios::app);
-    if (log_file.is_open()) {
-        log_file << "[" << timestamp.str() << "] " << message << std::endl;
-        if (is_block_end) {
-            log_file << "-----" << std::endl;
-        }
-    }
+void set_log_level(LogLevel level) {
+    logger().level = static_cast<int>(level);
+}
+
+LogLevel get_log_level() {
+    return static_cast<LogLevel>(logger().level.load(std::memory_order_relaxed));
+}
+
+bool parse_log_level(const std::string& name, LogLevel& level) {
+    if (name == "debug") level = LogLevel::Debug;
+    else if (name == "info") level = LogLevel::Info;
+    else if (name == "aviso" || name == "warn") level = LogLevel::Warn;
+    else if (name == "erro" || name == "error") level = LogLevel::Error;
+    else return false;
+    return true;
+}
+
+void set_log_max_size(uint64_t bytes) {
+    logger().max_size = bytes;
+}
+
+uint64_t log_dropped_count() {
+    return logger().dropped.load();
+}
+
+void log_flush() {
+    logger().flush();
 }
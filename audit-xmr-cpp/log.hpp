@@ -1,7 +1,42 @@
 // log.hpp
 #pragma once
 #include <string>
+#include <cstdint>
 
-// Funções de log com e sem separador
+// Níveis de log, do mais detalhado ao mais grave
+enum class LogLevel { Debug = 0, Info = 1, Warn = 2, Error = 3 };
+
+// Funções de log com e sem separador. O nível é deduzido do prefixo da
+// mensagem ([DEBUG], [INFO], [AVISO], [ERRO]); sem prefixo vale INFO.
+// As mensagens vão para um buffer em memória e são gravadas por uma thread
+// dedicada, que mantém o arquivo aberto.
 void log_message(const std::string& log_path, const std::string& message);
 void log_message(const std::string& log_path, const std::string& message, bool is_block_end);
+
+// Configuração do logger (chaves log_level e log_max_size do cfg)
+void set_log_level(LogLevel level);
+LogLevel get_log_level();
+bool parse_log_level(const std::string& name, LogLevel& level); // debug|info|aviso|erro
+void set_log_max_size(uint64_t bytes); // Rotaciona para <arquivo>.1 ao exceder (0 = sem limite)
+
+inline bool log_enabled(LogLevel level) {
+    return static_cast<int>(level) >= static_cast<int>(get_log_level());
+}
+
+// Mensagens descartadas porque o buffer estava cheio
+uint64_t log_dropped_count();
+
+// Espera a thread de escrita gravar tudo o que já foi enfileirado
+void log_flush();
+
+// Mensagens de DEBUG: em builds de release (NDEBUG) a chamada e a montagem
+// da mensagem desaparecem por completo
+#ifdef NDEBUG
+#define LOG_DEBUG(log_path, ...) do { } while (0)
+#else
+#define LOG_DEBUG(log_path, ...)                          \
+    do {                                                  \
+        if (log_enabled(LogLevel::Debug))                 \
+            log_message((log_path), __VA_ARGS__);         \
+    } while (0)
+#endif
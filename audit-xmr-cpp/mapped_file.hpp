@@ -0,0 +1,43 @@
+// mapped_file.hpp
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Arquivo mapeado em memória, somente leitura. 'advice' vai para o madvise
+// (MADV_SEQUENTIAL para leituras em ordem, MADV_WILLNEED para as paralelas).
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_ && size_) munmap(const_cast<char*>(data_), size_);
+    }
+    bool open(const std::string& path, int advice = MADV_SEQUENTIAL) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        size_ = ok ? static_cast<size_t>(st.st_size) : 0;
+        if (ok && size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok) {
+                data_ = static_cast<const char*>(p);
+                madvise(p, size_, advice);
+            }
+        }
+        ::close(fd);
+        return ok;
+    }
+    std::string_view view() const { return std::string_view(data_ ? data_ : "", size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
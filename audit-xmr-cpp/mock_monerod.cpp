@@ -0,0 +1,124 @@
+// mock_monerod.cpp
+// Nó monerod simulado para rodar o audit-xmr sem um nó sincronizado:
+//   ./mock-monerod --port 18081 --height 200000 --latency 20 --jitter 5 --error-rate 0.01
+// e então ./audit-xmr --server 127.0.0.1:18081 --range 0 9999
+// Com --write-lmdb <dir> grava a mesma cadeia num banco LMDB e sai:
+//   ./mock-monerod --height 5000 --write-lmdb fixture && ./audit-xmr --source lmdb --lmdb-path fixture
+// e com --write-raw <arquivo>, num blockchain.raw:
+//   ./mock-monerod --height 5000 --write-raw blockchain.raw && ./audit-xmr --input-raw blockchain.raw
+#include "mock_server.hpp"
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void on_signal(int) {
+    g_stop = 1;
+}
+
+int main(int argc, char* argv[]) {
+    MockOptions options;
+    std::string lmdb_dir;
+    std::string raw_file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            options.port = std::stoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            options.height = std::stoi(argv[++i]);
+        } else if (arg == "--latency" && i + 1 < argc) {
+            options.latency_ms = std::stod(argv[++i]);
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            options.jitter_ms = std::stod(argv[++i]);
+        } else if (arg == "--error-rate" && i + 1 < argc) {
+            options.error_rate = std::stod(argv[++i]);
+        } else if (arg == "--stall" && i + 2 < argc) {
+            options.stall_rate = std::stod(argv[++i]);
+            options.stall_ms = std::stod(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--reorg-height" && i + 1 < argc) {
+            options.reorg_height = std::stoi(argv[++i]);
+        } else if (arg == "--reorg-at" && i + 1 < argc) {
+            options.reorg_at = std::stoi(argv[++i]);
+        } else if (arg == "--grow" && i + 2 < argc) {
+            options.grow_start = std::stoi(argv[++i]);
+            options.grow_ms = std::stod(argv[++i]);
+        } else if (arg == "--zmq-pub" && i + 1 < argc) {
+            options.zmq_pub = argv[++i];
+        } else if (arg == "--write-lmdb" && i + 1 < argc) {
+            lmdb_dir = argv[++i];
+        } else if (arg == "--write-raw" && i + 1 < argc) {
+            raw_file = argv[++i];
+        } else if (arg == "--unrestricted") {
+            options.restricted = false;
+        } else if (arg == "--real-ids") {
+            options.real_ids = true;
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "\nUso: ./mock-monerod [opções]\n"
+                      << "  --port <N>           Porta (padrão 18081; 0 escolhe uma livre)\n"
+                      << "  --height <N>         Altura da cadeia sintética (padrão 200000)\n"
+                      << "  --latency <ms>       Atraso fixo por requisição\n"
+                      << "  --jitter <ms>        Atraso extra aleatório em [0, ms]\n"
+                      << "  --error-rate <f>     Fração de respostas HTTP 500 (0 a 1)\n"
+                      << "  --stall <f> <ms>     Fração de requisições com um atraso extra de ms (cauda)\n"
+                      << "  --seed <N>           Semente dos hashes sintéticos\n"
+                      << "  --reorg-height <N>   Blocos diferentes a partir de N, como após uma reorganização\n"
+                      << "  --reorg-at <N>       Com --reorg-height, a troca só acontece quando a cadeia chega a N\n"
+                      << "  --grow <N> <ms>      Começa com N blocos e revela mais um a cada ms (para o --follow)\n"
+                      << "  --zmq-pub <end>      Publica json-minimal-chain_main a cada bloco novo (requer libzmq)\n"
+                      << "  --unrestricted       Sem os limites do RPC restrito\n"
+                      << "  --real-ids           Hashes de bloco calculados dos blobs, para o --verify-id do audit-xmr\n"
+                      << "  --write-lmdb <dir>   Grava a cadeia num banco LMDB em <dir> e sai\n"
+                      << "  --write-raw <arq>    Grava a cadeia num blockchain.raw e sai\n";
+            return 0;
+        }
+    }
+
+    // Os ids reais são calculados uma vez, na abertura, para uma só cadeia
+    if (options.real_ids && options.reorg_at >= 0) {
+        std::cerr << "[ERRO] --reorg-at não se aplica com --real-ids.\n";
+        return 1;
+    }
+    MockServer server(options);
+    std::string error;
+    if (!lmdb_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(lmdb_dir, ec);
+        if (!server.write_lmdb(lmdb_dir, &error)) {
+            std::cerr << "[ERRO] Falha ao gravar o LMDB em " << lmdb_dir << ": " << error << "\n";
+            return 1;
+        }
+        std::cout << "[INFO] Cadeia de " << options.height << " blocos gravada em " << lmdb_dir << std::endl;
+        return 0;
+    }
+    if (!raw_file.empty()) {
+        if (!server.write_raw(raw_file, 0, -1, &error)) {
+            std::cerr << "[ERRO] Falha ao gravar " << raw_file << ": " << error << "\n";
+            return 1;
+        }
+        std::cout << "[INFO] Cadeia de " << options.height << " blocos gravada em " << raw_file << std::endl;
+        return 0;
+    }
+    if (!server.start(&error)) {
+        std::cerr << "[ERRO] Falha ao abrir a porta " << options.port << ": " << error << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::cout << "[INFO] mock-monerod em 127.0.0.1:" << server.port()
+              << " (altura " << options.height << ")" << std::endl;
+    if (options.grow_ms > 0) {
+        std::cout << "[INFO] Cadeia crescendo de " << options.grow_start << " blocos, um a cada " << options.grow_ms
+                  << " ms" << std::endl;
+    }
+
+    while (!g_stop) pause();
+
+    server.stop();
+    std::cout << "[INFO] Requisições atendidas: " << server.requests() << std::endl;
+    return 0;
+}
@@ -0,0 +1,864 @@
+// mock_server.cpp
+#include "mock_server.hpp"
+#include "portable_storage.hpp"
+#include "block_binary.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef AUDIT_XMR_HAVE_ZMQ
+#include <zmq.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+const uint64_t MONEY_SUPPLY = ~uint64_t(0);
+const uint64_t FINAL_SUBSIDY = 600000000000ULL; // 0,6 XMR por bloco (tail emission)
+const uint64_t GENESIS_TIMESTAMP = 1397818193;
+
+// Alturas de ativação dos hard forks da mainnet (versão maior = índice + 1)
+const int HARD_FORKS[] = { 0, 1009827, 1141317, 1220516, 1288616, 1400000, 1546000, 1685555,
+                           1686275, 1788000, 1788720, 1978433, 2210000, 2210720, 2688888, 2689608 };
+
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+std::string hex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(bytes.size() * 2, '0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        uint8_t b = static_cast<uint8_t>(bytes[i]);
+        out[2 * i] = digits[b >> 4];
+        out[2 * i + 1] = digits[b & 15];
+    }
+    return out;
+}
+
+} // namespace
+
+// Cadeia sintética: a emissão segue a fórmula do Monero (sem penalidade de
+// tamanho) e a coinbase cobra a base mais as taxas das txs do bloco, então
+// reward == soma das saídas da coinbase == base + taxas
+class MockChain {
+public:
+    MockChain(int height, uint32_t seed, int reorg_height, bool real_ids, int visible = -1, int reorg_at = -1)
+        : seed_(seed), reorg_height_(reorg_height), reorg_at_(reorg_at), rewards_(std::max(1, height)),
+          visible_(visible < 1 || visible > height ? std::max(1, height) : visible) {
+        uint64_t generated = 0;
+        for (int h = 0; h < static_cast<int>(rewards_.size()); ++h) {
+            int speed = major_version(h) < 2 ? 20 : 19; // Alvo de 60 s e depois 120 s
+            uint64_t base = (MONEY_SUPPLY - generated) >> speed;
+            if (base < FINAL_SUBSIDY) base = FINAL_SUBSIDY;
+            rewards_[h] = base + block_fees(h);
+            generated += base;
+        }
+        // Cada blob leva o id do anterior, então os ids saem em sequência
+        if (real_ids) {
+            ids_.reserve(rewards_.size());
+            for (int h = 0; h < static_cast<int>(rewards_.size()); ++h) {
+                std::string blob = block_blob(h);
+                ParsedBlock block;
+                parse_block_blob(reinterpret_cast<const uint8_t*>(blob.data()), blob.size(), block);
+                ids_.push_back(block_id(reinterpret_cast<const uint8_t*>(blob.data()), blob.size(), block));
+            }
+        }
+    }
+
+    // Blocos já revelados (com --grow, a cadeia cresce até o total gerado)
+    int height() const { return visible_.load(); }
+    int full_height() const { return static_cast<int>(rewards_.size()); }
+    bool grow() {
+        int n = visible_.load();
+        if (n >= full_height()) return false;
+        visible_ = n + 1;
+        return true;
+    }
+    uint64_t reward(int h) const { return rewards_[h]; }
+    uint64_t emission(int h) const { return rewards_[h] - block_fees(h); } // Sem as taxas, como already_generated_coins
+
+    static int major_version(int h) {
+        int v = 1;
+        for (int i = 1; i < static_cast<int>(sizeof(HARD_FORKS) / sizeof(HARD_FORKS[0])); ++i) {
+            if (h >= HARD_FORKS[i]) v = i + 1;
+        }
+        return v;
+    }
+
+    uint64_t timestamp(int h) const {
+        int v2 = HARD_FORKS[1];
+        return h < v2 ? GENESIS_TIMESTAMP + uint64_t(h) * 60
+                      : GENESIS_TIMESTAMP + uint64_t(v2) * 60 + uint64_t(h - v2) * 120;
+    }
+
+    int tx_count(int h) const { return h < 1000 ? 0 : static_cast<int>((uint64_t(h) * 7919) % 6); }
+
+    // Entre 0,00001 e 0,0005 XMR por tx
+    static uint64_t tx_fee(int h, int i) { return 10000000ULL * (1 + (uint64_t(h) * 8 + uint64_t(i)) % 50); }
+    uint64_t block_fees(int h) const {
+        uint64_t fees = 0;
+        for (int i = 0; i < tx_count(h); ++i) fees += tx_fee(h, i);
+        return fees;
+    }
+
+    // Hashes sintéticos; a altura fica nos últimos 8 bytes para a busca reversa
+    std::string fake_hash(uint64_t tag, int h, uint64_t variant = 0) const {
+        uint64_t x = (uint64_t(seed_) << 32) ^ (tag << 56) ^ static_cast<uint64_t>(h) ^ (variant * 0xd6e8feb86659fd93ULL);
+        std::string out(32, '\0');
+        for (int i = 0; i < 3; ++i) {
+            uint64_t r = splitmix64(x);
+            std::memcpy(&out[i * 8], &r, 8);
+        }
+        uint64_t hh = static_cast<uint64_t>(h);
+        std::memcpy(&out[24], &hh, 8);
+        return out;
+    }
+    // A partir de reorg_height os blocos são outros, como depois de uma
+    // reorganização; com reorg_at, só depois que a cadeia chega a essa altura
+    bool reorged(int h) const {
+        return reorg_height_ >= 0 && h >= reorg_height_ && (reorg_at_ < 0 || visible_.load() >= reorg_at_);
+    }
+    int reorg_height() const { return reorg_height_; }
+    int reorg_at() const { return reorg_at_; }
+    std::string block_hash(int h) const {
+        if (!ids_.empty()) return std::string(reinterpret_cast<const char*>(ids_[h].data()), ids_[h].size());
+        return fake_hash(1, h, reorged(h) ? reorg_height_ + 1 : 0);
+    }
+    std::string miner_tx_hash(int h) const { return fake_hash(2, h, reorged(h) ? reorg_height_ + 1 : 0); }
+    std::string tx_hash(int h, int i) const { return fake_hash(4, h * 8 + i); } // height_of devolve h * 8 + i
+
+    static int height_of(const std::string& hash_hex) {
+        if (hash_hex.size() != 64) return -1;
+        uint64_t h = 0;
+        for (int i = 7; i >= 0; --i) {
+            h = (h << 8) | std::stoul(hash_hex.substr(48 + i * 2, 2), nullptr, 16);
+        }
+        return h > static_cast<uint64_t>(INT32_MAX) ? -1 : static_cast<int>(h);
+    }
+
+    // Saídas da coinbase: decompostas em dígitos antes do RingCT, uma só depois
+    std::vector<uint64_t> outputs(int h) const {
+        uint64_t reward = rewards_[h];
+        std::vector<uint64_t> out;
+        if (major_version(h) >= 4) {
+            out.push_back(reward);
+            return out;
+        }
+        uint64_t order = 1;
+        while (reward > 0) {
+            uint64_t digit = reward % 10;
+            if (digit) out.push_back(digit * order);
+            reward /= 10;
+            order *= 10;
+        }
+        return out;
+    }
+
+    std::string extra(int h) const {
+        std::string e;
+        e.push_back(0x01); // tx pubkey
+        uint64_t x = uint64_t(h) ^ 0x5555 ^ (reorged(h) ? uint64_t(reorg_height_ + 1) << 32 : 0);
+        for (int i = 0; i < 4; ++i) {
+            uint64_t r = splitmix64(x);
+            e.append(reinterpret_cast<const char*>(&r), 8);
+        }
+        return e;
+    }
+
+    std::string miner_tx_blob(int h) const {
+        int major = major_version(h);
+        std::string tx;
+        put_varint(tx, major >= 4 ? 2 : 1);
+        put_varint(tx, uint64_t(h) + 60);
+        put_varint(tx, 1);
+        tx.push_back(static_cast<char>(0xff));
+        put_varint(tx, uint64_t(h));
+        auto outs = outputs(h);
+        put_varint(tx, outs.size());
+        for (size_t i = 0; i < outs.size(); ++i) {
+            put_varint(tx, outs[i]);
+            std::string key = fake_hash(3, h * 31 + static_cast<int>(i));
+            if (major >= 15) {
+                tx.push_back(0x03);
+                tx += key;
+                tx.push_back(static_cast<char>(i & 0xff)); // view tag
+            } else {
+                tx.push_back(0x02);
+                tx += key;
+            }
+        }
+        std::string e = extra(h);
+        put_varint(tx, e.size());
+        tx += e;
+        if (major >= 4) tx.push_back(0x00); // RCTTypeNull
+        return tx;
+    }
+
+    // Tx comum do bloco: uma entrada com anel e duas saídas. Nas v1 os
+    // amounts ficam em claro (a taxa é entradas - saídas) e as assinaturas
+    // vêm depois do prefixo; nas v2, o txnFee fica na base RCT, e a versão
+    // podada (pruned_as_hex) para antes da parte prunable.
+    std::string tx_blob(int h, int i, bool pruned = false) const {
+        int major = major_version(h);
+        uint64_t fee = tx_fee(h, i);
+        uint64_t amounts[2] = { 1000000000ULL * (1 + uint64_t(h) % 7), 200000000ULL };
+        if (major >= 4) amounts[0] = amounts[1] = 0;
+        int ring = major >= 4 ? 11 : 3;
+        std::string tx;
+        put_varint(tx, major >= 4 ? 2 : 1);
+        put_varint(tx, 0);
+        put_varint(tx, 1);
+        tx.push_back(0x02); // txin_to_key
+        put_varint(tx, major >= 4 ? 0 : amounts[0] + amounts[1] + fee);
+        put_varint(tx, ring);
+        for (int k = 0; k < ring; ++k) put_varint(tx, 1000 + uint64_t(k) * 37);
+        tx += fake_hash(5, h * 8 + i); // key image
+        put_varint(tx, 2);
+        for (int o = 0; o < 2; ++o) {
+            put_varint(tx, amounts[o]);
+            tx.push_back(major >= 15 ? 0x03 : 0x02);
+            tx += fake_hash(6, h * 8 + i, o);
+            if (major >= 15) tx.push_back(static_cast<char>(o));
+        }
+        put_varint(tx, 33);
+        tx.push_back(0x01);
+        tx += fake_hash(7, h * 8 + i);
+        if (major < 4) {
+            if (!pruned) tx.append(static_cast<size_t>(ring) * 64, '\x11'); // Assinaturas em anel
+            return tx;
+        }
+        // rctSigBase: tipo (Simple, Bulletproof2, CLSAG, BulletproofPlus), txnFee, ecdhInfo e outPk
+        int type = major >= 15 ? 6 : major >= 13 ? 5 : major >= 10 ? 4 : 2;
+        tx.push_back(static_cast<char>(type));
+        put_varint(tx, fee);
+        tx.append(type >= 4 ? 2 * 8 : 2 * 64, '\x22');
+        tx.append(2 * 32, '\x33');
+        if (!pruned) tx.append(256, '\x44'); // Provas e assinaturas
+        return tx;
+    }
+
+    std::string block_blob(int h) const {
+        int major = major_version(h);
+        std::string b;
+        put_varint(b, major);
+        put_varint(b, major);
+        put_varint(b, timestamp(h));
+        b += h > 0 ? block_hash(h - 1) : std::string(32, '\0');
+        uint32_t nonce = static_cast<uint32_t>(h * 2654435761u);
+        for (int i = 0; i < 4; ++i) b.push_back(static_cast<char>((nonce >> (8 * i)) & 0xff));
+        b += miner_tx_blob(h);
+        int n = tx_count(h);
+        put_varint(b, n);
+        for (int i = 0; i < n; ++i) b += tx_hash(h, i);
+        return b;
+    }
+
+    json miner_tx_json(int h) const {
+        int major = major_version(h);
+        json tx;
+        tx["version"] = major >= 4 ? 2 : 1;
+        tx["unlock_time"] = h + 60;
+        tx["vin"] = json::array({ { {"gen", { {"height", h} } } } });
+        tx["vout"] = json::array();
+        auto outs = outputs(h);
+        for (size_t i = 0; i < outs.size(); ++i) {
+            std::string key = hex(fake_hash(3, h * 31 + static_cast<int>(i)));
+            json target;
+            if (major >= 15) {
+                char tag[3];
+                std::snprintf(tag, sizeof(tag), "%02x", static_cast<unsigned>(i & 0xff));
+                target["tagged_key"] = { {"key", key}, {"view_tag", tag} };
+            } else {
+                target["key"] = key;
+            }
+            tx["vout"].push_back({ {"amount", outs[i]}, {"target", target} });
+        }
+        std::vector<int> extra_bytes;
+        for (char c : extra(h)) extra_bytes.push_back(static_cast<uint8_t>(c));
+        tx["extra"] = extra_bytes;
+        if (major >= 4) tx["rct_signatures"] = { {"type", 0} };
+        return tx;
+    }
+
+    std::vector<std::string> tx_hashes_hex(int h) const {
+        std::vector<std::string> out;
+        for (int i = 0; i < tx_count(h); ++i) out.push_back(hex(tx_hash(h, i)));
+        return out;
+    }
+
+    json header(int h) const {
+        int major = major_version(h);
+        int n = tx_count(h);
+        return {
+            {"block_size", 300 + n * 1500}, {"block_weight", 300 + n * 1500},
+            {"cumulative_difficulty", 1000000ULL * (h + 1)}, {"cumulative_difficulty_top64", 0},
+            {"depth", height() - 1 - h}, {"difficulty", 1000000}, {"difficulty_top64", 0},
+            {"hash", hex(block_hash(h))}, {"height", h}, {"long_term_weight", 300 + n * 1500},
+            {"major_version", major}, {"miner_tx_hash", hex(miner_tx_hash(h))},
+            {"minor_version", major}, {"nonce", static_cast<uint32_t>(h * 2654435761u)}, {"num_txes", n},
+            {"orphan_status", false}, {"pow_hash", ""},
+            {"prev_hash", h > 0 ? hex(block_hash(h - 1)) : std::string(64, '0')},
+            {"reward", rewards_[h]}, {"timestamp", timestamp(h)},
+            {"wide_cumulative_difficulty", "0x0"}, {"wide_difficulty", "0x0"}
+        };
+    }
+
+    json block_json(int h) const {
+        int major = major_version(h);
+        json block;
+        block["major_version"] = major;
+        block["minor_version"] = major;
+        block["timestamp"] = timestamp(h);
+        block["prev_id"] = h > 0 ? hex(block_hash(h - 1)) : std::string(64, '0');
+        block["nonce"] = static_cast<uint32_t>(h * 2654435761u);
+        block["miner_tx"] = miner_tx_json(h);
+        block["tx_hashes"] = tx_hashes_hex(h);
+        return block;
+    }
+
+private:
+    uint32_t seed_;
+    int reorg_height_;
+    int reorg_at_;
+    std::vector<uint64_t> rewards_;
+    std::atomic<int> visible_;
+    std::vector<Hash32> ids_; // Com real_ids: ids calculados dos blobs
+};
+
+namespace {
+
+json rpc_error(const json& id, int code, const std::string& message) {
+    return { {"jsonrpc", "2.0"}, {"id", id}, {"error", { {"code", code}, {"message", message} } } };
+}
+
+json rpc_result(const json& id, json result) {
+    result["status"] = "OK";
+    result["untrusted"] = false;
+    return { {"jsonrpc", "2.0"}, {"id", id}, {"result", result} };
+}
+
+} // namespace
+
+MockServer::MockServer(const MockOptions& options)
+    : options_(options), chain_(new MockChain(options.height, options.seed, options.reorg_height, options.real_ids,
+                                              options.grow_ms > 0 ? options.grow_start : -1, options.reorg_at)) {}
+
+MockServer::~MockServer() {
+    stop();
+}
+
+bool MockServer::start(std::string* error) {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 1024) < 0) {
+        if (error) *error = std::strerror(errno);
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    if (!options_.zmq_pub.empty()) {
+#ifdef AUDIT_XMR_HAVE_ZMQ
+        zmq_context_ = zmq_ctx_new();
+        zmq_socket_ = zmq_context_ ? zmq_socket(zmq_context_, ZMQ_PUB) : nullptr;
+        if (!zmq_socket_ || zmq_bind(zmq_socket_, options_.zmq_pub.c_str()) != 0) {
+            if (error) *error = std::string("ZMQ ") + options_.zmq_pub + ": " + zmq_strerror(zmq_errno());
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+#else
+        if (error) *error = "compilado sem libzmq (--zmq-pub)";
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+#endif
+    }
+
+    running_ = true;
+    accept_thread_ = std::thread([this] { accept_loop(); });
+    if (options_.grow_ms > 0) grow_thread_ = std::thread([this] { grow_loop(); });
+    return true;
+}
+
+void MockServer::stop() {
+    if (!running_.exchange(false)) return;
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    ::close(listen_fd_);
+    if (accept_thread_.joinable()) accept_thread_.join();
+    if (grow_thread_.joinable()) grow_thread_.join();
+#ifdef AUDIT_XMR_HAVE_ZMQ
+    if (zmq_socket_) zmq_close(zmq_socket_);
+    if (zmq_context_) zmq_ctx_term(zmq_context_);
+    zmq_socket_ = zmq_context_ = nullptr;
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : client_fds_) ::shutdown(fd, SHUT_RDWR);
+    }
+    // As threads de conexão fecham os próprios sockets ao sair
+    while (connections_.load() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+std::vector<double> MockServer::take_service_times() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<double> out;
+    out.swap(service_times_);
+    return out;
+}
+
+void MockServer::accept_loop() {
+    while (running_) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running_) break;
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_fds_.push_back(fd);
+        }
+        connections_++;
+        std::thread([this, fd] { serve(fd); }).detach();
+    }
+}
+
+// Um bloco novo a cada grow_ms. Quando a cadeia chega a reorg_at, os blocos
+// a partir de reorg_height mudam, e o aviso leva o trecho substituído inteiro.
+void MockServer::grow_loop() {
+    auto period = std::chrono::microseconds(static_cast<int64_t>(options_.grow_ms * 1000));
+    auto next = std::chrono::steady_clock::now() + period;
+    while (running_) {
+        if (std::chrono::steady_clock::now() < next) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        next += period;
+        if (!chain_->grow()) continue;
+        int top = chain_->height() - 1;
+        int first = top;
+        if (chain_->reorg_height() >= 0 && chain_->height() == chain_->reorg_at()) first = chain_->reorg_height();
+        publish(first, top);
+    }
+}
+
+void MockServer::publish(int first, int last) {
+#ifdef AUDIT_XMR_HAVE_ZMQ
+    if (!zmq_socket_) return;
+    json ids = json::array();
+    for (int h = first; h <= last; ++h) ids.push_back(hex(chain_->block_hash(h)));
+    json body = { {"first_height", first},
+                  {"first_prev_id", first > 0 ? hex(chain_->block_hash(first - 1)) : std::string(64, '0')},
+                  {"ids", ids} };
+    std::string message = "json-minimal-chain_main:" + body.dump();
+    zmq_send(zmq_socket_, message.data(), message.size(), 0);
+#else
+    (void)first;
+    (void)last;
+#endif
+}
+
+// Uma conexão keep-alive: lê requisições HTTP/1.1 até o cliente fechar
+void MockServer::serve(int fd) {
+    thread_local std::mt19937 rng(options_.seed ^ static_cast<uint32_t>(fd));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::string buffer;
+    char chunk[65536];
+
+    while (running_) {
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) goto done;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        {
+            auto received = std::chrono::steady_clock::now();
+            std::string head = buffer.substr(0, header_end);
+            size_t content_length = 0;
+            bool close_after = false;
+            std::string lower = head;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            size_t cl = lower.find("content-length:");
+            if (cl != std::string::npos) content_length = std::stoul(head.substr(cl + 15));
+            if (lower.find("connection: close") != std::string::npos) close_after = true;
+            size_t sp1 = head.find(' ');
+            size_t sp2 = head.find(' ', sp1 + 1);
+            std::string path = sp1 == std::string::npos ? "/" : head.substr(sp1 + 1, sp2 - sp1 - 1);
+
+            size_t body_start = header_end + 4;
+            while (buffer.size() < body_start + content_length) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) goto done;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            std::string body = buffer.substr(body_start, content_length);
+            buffer.erase(0, body_start + content_length);
+
+            double delay = options_.latency_ms + options_.jitter_ms * unit(rng);
+            if (options_.stall_rate > 0 && unit(rng) < options_.stall_rate) delay += options_.stall_ms;
+            if (delay > 0) std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(delay * 1000)));
+
+            int status = 200;
+            std::string content_type = "application/json";
+            std::string payload;
+            if (options_.error_rate > 0 && unit(rng) < options_.error_rate) {
+                status = 500;
+                payload = "Internal Server Error";
+                content_type = "text/plain";
+            } else {
+                payload = handle(path, body, status, content_type);
+            }
+
+            char header[256];
+            int header_len = std::snprintf(header, sizeof(header),
+                "HTTP/1.1 %d %s\r\nServer: Epee-based\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+                status, status == 200 ? "Ok" : status == 404 ? "Not Found" : "Internal Server Error",
+                content_type.c_str(), payload.size());
+            iovec iov[2] = { { header, static_cast<size_t>(header_len) },
+                             { const_cast<char*>(payload.data()), payload.size() } };
+            size_t total = static_cast<size_t>(header_len) + payload.size();
+            size_t sent = 0;
+            while (sent < total) {
+                msghdr msg{};
+                iovec rest[2];
+                int count = 0;
+                size_t skip = sent;
+                for (auto& part : iov) {
+                    if (skip >= part.iov_len) { skip -= part.iov_len; continue; }
+                    rest[count].iov_base = static_cast<char*>(part.iov_base) + skip;
+                    rest[count].iov_len = part.iov_len - skip;
+                    skip = 0;
+                    ++count;
+                }
+                msg.msg_iov = rest;
+                msg.msg_iovlen = count;
+                ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+                if (n <= 0) goto done;
+                sent += static_cast<size_t>(n);
+            }
+
+            requests_++;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - received).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                service_times_.push_back(ms);
+            }
+            if (close_after) break;
+        }
+    }
+done:
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        client_fds_.erase(std::remove(client_fds_.begin(), client_fds_.end(), fd), client_fds_.end());
+    }
+    ::close(fd);
+    connections_--;
+}
+
+std::string MockServer::handle(const std::string& path, const std::string& body, int& status, std::string& content_type) {
+    const MockChain& chain = *chain_;
+    const int top = chain.height() - 1;
+
+    if (path == "/get_blocks_by_height.bin") {
+        content_type = "application/octet-stream";
+        ps::Value request;
+        const ps::Value* heights = nullptr;
+        if (ps::decode(body, request)) heights = request.find("heights");
+        ps::Writer response;
+        std::vector<ps::Writer> blocks;
+        bool ok = heights && heights->is_array;
+        if (ok) {
+            for (const auto& item : heights->items) {
+                if (item.as_uint() > static_cast<uint64_t>(top)) { ok = false; break; }
+                int h = static_cast<int>(item.as_uint());
+                std::vector<std::string> txs;
+                for (int i = 0; i < chain.tx_count(h); ++i) txs.push_back(chain.tx_blob(h, i));
+                ps::Writer entry;
+                entry.add_string("block", chain.block_blob(h));
+                entry.add_string_array("txs", txs);
+                blocks.push_back(std::move(entry));
+            }
+        }
+        if (ok) response.add_object_array("blocks", blocks);
+        response.add_string("status", ok ? "OK" : "Failed");
+        response.add_bool("untrusted", false);
+        return response.finish();
+    }
+
+    json request = json::parse(body, nullptr, false);
+    if (request.is_discarded()) {
+        status = 500;
+        content_type = "text/plain";
+        return "Bad Request";
+    }
+
+    if (path == "/get_transactions") {
+        json response = { {"status", "OK"}, {"untrusted", false}, {"txs", json::array()} };
+        const json& hashes = request.value("txs_hashes", json::array());
+        if (options_.restricted && hashes.size() > 100) {
+            response["status"] = "Too many transactions requested";
+            return response.dump();
+        }
+        bool as_json = request.value("decode_as_json", false);
+        bool prune = request.value("prune", false);
+        json missed = json::array();
+        for (const auto& hash : hashes) {
+            std::string hash_hex = hash.get<std::string>();
+            // Miner tx (altura nos últimos bytes) ou tx comum (altura * 8 + índice)
+            int n = MockChain::height_of(hash_hex);
+            int h = n, i = -1;
+            if (n >= 0 && (n > top || hex(chain.miner_tx_hash(n)) != hash_hex)) {
+                h = n / 8;
+                i = n % 8;
+                if (h > top || i >= chain.tx_count(h) || hex(chain.tx_hash(h, i)) != hash_hex) h = -1;
+            }
+            if (h < 0) {
+                missed.push_back(hash_hex);
+                continue;
+            }
+            std::string blob = i < 0 ? chain.miner_tx_blob(h) : chain.tx_blob(h, i, prune);
+            json tx = {
+                {"as_hex", prune ? "" : hex(blob)}, {"block_height", h},
+                {"block_timestamp", chain.timestamp(h)}, {"double_spend_seen", false},
+                {"in_pool", false}, {"output_indices", json::array()},
+                {"prunable_as_hex", ""}, {"prunable_hash", std::string(64, '0')},
+                {"pruned_as_hex", prune ? hex(blob) : ""}, {"tx_hash", hash_hex}
+            };
+            if (as_json && i < 0) tx["as_json"] = chain.miner_tx_json(h).dump();
+            response["txs"].push_back(tx);
+        }
+        if (!missed.empty()) response["missed_tx"] = missed;
+        return response.dump();
+    }
+
+    if (path != "/json_rpc") {
+        status = 404;
+        content_type = "text/plain";
+        return "Not Found";
+    }
+
+    json id = request.value("id", json("0"));
+    std::string method = request.value("method", std::string());
+    json params = request.value("params", json::object());
+
+    if (method == "get_block_count") {
+        return rpc_result(id, { {"count", chain.height()} }).dump();
+    }
+    if (method == "get_last_block_header") {
+        return rpc_result(id, { {"block_header", chain.header(top)} }).dump();
+    }
+    if (method == "get_block_header_by_height") {
+        int h = params.value("height", -1);
+        if (h < 0 || h > top) return rpc_error(id, -2, "Requested block height: " + std::to_string(h) +
+                                               " greater than current top block height: " + std::to_string(top)).dump();
+        return rpc_result(id, { {"block_header", chain.header(h)} }).dump();
+    }
+    if (method == "get_block") {
+        int h = params.value("height", -1);
+        if (h < 0 || h > top) return rpc_error(id, -2, "Requested block height: " + std::to_string(h) +
+                                               " greater than current top block height: " + std::to_string(top)).dump();
+        json result = {
+            {"blob", hex(chain.block_blob(h))},
+            {"block_header", chain.header(h)},
+            {"credits", 0},
+            {"json", chain.block_json(h).dump(2)},
+            {"miner_tx_hash", hex(chain.miner_tx_hash(h))},
+            {"top_hash", ""},
+            {"tx_hashes", chain.tx_hashes_hex(h)}
+        };
+        return rpc_result(id, result).dump(2);
+    }
+    if (method == "get_block_headers_range") {
+        int start = params.value("start_height", -1);
+        int end = params.value("end_height", -1);
+        if (start < 0 || end < start || end > top) return rpc_error(id, -5, "Invalid start/end heights.").dump();
+        if (options_.restricted && end - start >= 1000) return rpc_error(id, -1, "Too many block headers requested.").dump();
+        json headers = json::array();
+        for (int h = start; h <= end; ++h) headers.push_back(chain.header(h));
+        return rpc_result(id, { {"headers", headers} }).dump();
+    }
+    return rpc_error(id, -32601, "Method not found").dump();
+}
+
+bool MockServer::write_raw(const std::string& path, int first, int last, std::string* error) const {
+    const MockChain& chain = *chain_;
+    if (last < 0 || last >= chain.height()) last = chain.height() - 1;
+    if (first < 0 || first > last) {
+        if (error) *error = "intervalo inválido";
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    auto put32 = [](std::string& s, uint32_t v) {
+        for (int i = 0; i < 4; ++i) s.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    };
+
+    // magic + cabeçalho de 1024 bytes, como o BootstrapFile: file_info
+    // (versão 0.1, header_size em varint) e blocks_info (três varints), cada
+    // um precedido do tamanho em uint32
+    const uint32_t header_size = 1024;
+    std::string file_info;
+    file_info.push_back(0);
+    file_info.push_back(1);
+    put_varint(file_info, header_size);
+    std::string blocks_info;
+    put_varint(blocks_info, static_cast<uint64_t>(first));
+    put_varint(blocks_info, static_cast<uint64_t>(last));
+    put_varint(blocks_info, 0);
+    std::string head;
+    put32(head, 0x28721586);
+    put32(head, static_cast<uint32_t>(file_info.size()));
+    head += file_info;
+    put32(head, static_cast<uint32_t>(blocks_info.size()));
+    head += blocks_info;
+    head.resize(4 + header_size, '\0');
+    out.write(head.data(), static_cast<std::streamsize>(head.size()));
+
+    // block_package: bloco, txs, peso, dificuldade acumulada e moedas
+    // geradas (sem as taxas), em varints
+    uint64_t coins = 0;
+    for (int h = 0; h < first; ++h) coins += chain.emission(h);
+    std::string record;
+    for (int h = first; h <= last; ++h) {
+        coins += chain.emission(h);
+        std::string package = chain.block_blob(h);
+        put_varint(package, static_cast<uint64_t>(chain.tx_count(h)));
+        for (int i = 0; i < chain.tx_count(h); ++i) package += chain.tx_blob(h, i);
+        put_varint(package, package.size());
+        put_varint(package, static_cast<uint64_t>(h) + 1);
+        put_varint(package, coins);
+        record.clear();
+        put32(record, static_cast<uint32_t>(package.size()));
+        record += package;
+        out.write(record.data(), static_cast<std::streamsize>(record.size()));
+    }
+    if (!out.flush()) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+#ifdef AUDIT_XMR_HAVE_LMDB
+#include <lmdb.h>
+
+namespace {
+
+int compare_uint64(const MDB_val* a, const MDB_val* b) {
+    uint64_t va, vb;
+    std::memcpy(&va, a->mv_data, sizeof(va));
+    std::memcpy(&vb, b->mv_data, sizeof(vb));
+    return va < vb ? -1 : va > vb;
+}
+
+} // namespace
+
+bool MockServer::write_lmdb(const std::string& dir, std::string* error) const {
+    const MockChain& chain = *chain_;
+    MDB_env* env = nullptr;
+    MDB_txn* txn = nullptr;
+    auto fail = [&](const std::string& what, int rc) {
+        if (error) *error = what + ": " + mdb_strerror(rc);
+        if (txn) mdb_txn_abort(txn);
+        if (env) mdb_env_close(env);
+        return false;
+    };
+
+    int rc = mdb_env_create(&env);
+    if (rc) return fail("mdb_env_create", rc);
+    mdb_env_set_maxdbs(env, 32);
+    // Blob médio abaixo de 300 bytes mais 96 de block_info
+    mdb_env_set_mapsize(env, (static_cast<size_t>(chain.height()) * 512 + (64 << 20)));
+    if ((rc = mdb_env_open(env, dir.c_str(), 0, 0644))) return fail("mdb_env_open " + dir, rc);
+
+    MDB_dbi blocks, block_info, properties;
+    if ((rc = mdb_txn_begin(env, nullptr, 0, &txn)) ||
+        (rc = mdb_dbi_open(txn, "blocks", MDB_INTEGERKEY | MDB_CREATE, &blocks)) ||
+        (rc = mdb_dbi_open(txn, "block_info", MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED | MDB_CREATE, &block_info)) ||
+        (rc = mdb_set_dupsort(txn, block_info, compare_uint64)) ||
+        (rc = mdb_dbi_open(txn, "properties", MDB_CREATE, &properties))) {
+        return fail("criação das tabelas", rc);
+    }
+
+    // Mesmo layout de mdb_block_info_4 lido por lmdb_source.cpp
+    struct BlockInfo {
+        uint64_t height, timestamp, coins, weight, diff_lo, diff_hi;
+        uint8_t hash[32];
+        uint64_t cum_rct, long_term_weight;
+    };
+    const uint64_t zero = 0;
+    uint64_t coins = 0;
+    for (int h = 0; h < chain.height(); ++h) {
+        std::string blob = chain.block_blob(h);
+        std::string hash = chain.block_hash(h);
+        coins += chain.emission(h);
+
+        BlockInfo info{};
+        info.height = static_cast<uint64_t>(h);
+        info.timestamp = chain.timestamp(h);
+        info.coins = coins;
+        info.weight = blob.size();
+        info.diff_lo = 1;
+        std::memcpy(info.hash, hash.data(), sizeof(info.hash));
+
+        uint64_t key = static_cast<uint64_t>(h);
+        MDB_val k{ sizeof(key), &key };
+        MDB_val v{ blob.size(), &blob[0] };
+        MDB_val zk{ sizeof(zero), const_cast<uint64_t*>(&zero) };
+        MDB_val iv{ sizeof(info), &info };
+        if ((rc = mdb_put(txn, blocks, &k, &v, MDB_APPEND)) ||
+            (rc = mdb_put(txn, block_info, &zk, &iv, MDB_APPENDDUP))) {
+            return fail("bloco " + std::to_string(h), rc);
+        }
+    }
+    uint32_t version = 5;
+    MDB_val vk{ sizeof("version"), const_cast<char*>("version") };
+    MDB_val vv{ sizeof(version), &version };
+    if ((rc = mdb_put(txn, properties, &vk, &vv, 0))) return fail("properties", rc);
+    rc = mdb_txn_commit(txn);
+    txn = nullptr;
+    if (rc) return fail("mdb_txn_commit", rc);
+    mdb_env_close(env);
+    return true;
+}
+
+#else
+
+bool MockServer::write_lmdb(const std::string&, std::string* error) const {
+    if (error) *error = "compilado sem suporte a LMDB";
+    return false;
+}
+
+#endif
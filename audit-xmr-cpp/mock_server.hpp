@@ -0,0 +1,79 @@
+// mock_server.hpp
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Nó monerod simulado para testes de desempenho sem um nó sincronizado.
+// Serve uma cadeia sintética e determinística (emissão, versões de hard
+// fork, miner tx v1/v2, saídas decompostas ou tagged_key) pelos mesmos
+// endpoints que o audit-xmr usa, com latência, jitter e erros injetáveis.
+struct MockOptions {
+    int port = 18081;          // 0 escolhe uma porta livre
+    int height = 200000;       // Número de blocos da cadeia (alturas 0..height-1)
+    double latency_ms = 0;     // Atraso fixo por requisição
+    double jitter_ms = 0;      // Atraso extra uniforme em [0, jitter_ms]
+    double error_rate = 0;     // Fração de requisições respondidas com erro
+    double stall_rate = 0;     // Fração de requisições com o atraso extra stall_ms (cauda lenta)
+    double stall_ms = 0;
+    bool restricted = true;    // Aplica os limites do RPC restrito (1000 cabeçalhos, 100 txs)
+    uint32_t seed = 1;
+    int reorg_height = -1;     // Hashes diferentes a partir desta altura (simula uma reorganização)
+    bool real_ids = false;     // Hashes de bloco iguais aos ids calculados dos blobs (sintéticos por padrão)
+    // Cadeia crescendo, para o --follow: começa com grow_start blocos e
+    // revela mais um a cada grow_ms, até 'height'
+    int grow_start = -1;
+    double grow_ms = 0;
+    int reorg_at = -1;         // Com reorg_height: a troca só acontece quando a cadeia chega a esta altura
+    std::string zmq_pub;       // Publica json-minimal-chain_main neste endereço (só com libzmq)
+};
+
+class MockChain;
+
+class MockServer {
+public:
+    explicit MockServer(const MockOptions& options);
+    ~MockServer();
+
+    bool start(std::string* error = nullptr);
+    void stop();
+    int port() const { return port_; }
+
+    // Tempos de atendimento (ms) desde a última chamada, para percentis
+    std::vector<double> take_service_times();
+    uint64_t requests() const { return requests_.load(); }
+
+    // Grava a cadeia num banco LMDB com o layout do monerod (tabelas blocks,
+    // block_info e properties), para testar a fonte offline. Só com liblmdb.
+    bool write_lmdb(const std::string& dir, std::string* error = nullptr) const;
+
+    // Grava os blocos [first, last] (last < 0: até o fim) no formato do
+    // blockchain.raw do monero-blockchain-export, para a fonte raw
+    bool write_raw(const std::string& path, int first = 0, int last = -1, std::string* error = nullptr) const;
+
+private:
+    void accept_loop();
+    void grow_loop();
+    void publish(int first, int last); // Mensagem chain_main com os blocos [first, last]
+    void serve(int fd);
+    std::string handle(const std::string& path, const std::string& body, int& status, std::string& content_type);
+
+    MockOptions options_;
+    std::unique_ptr<MockChain> chain_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<int> connections_{0};
+    std::thread accept_thread_;
+    std::thread grow_thread_;
+    void* zmq_context_ = nullptr;
+    void* zmq_socket_ = nullptr;
+    std::mutex mutex_;            // Protege client_fds_ e service_times_
+    std::vector<int> client_fds_;
+    std::vector<double> service_times_;
+};
@@ -0,0 +1,235 @@
+// nodes.cpp
+#include "nodes.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const size_t LATENCY_SAMPLES = 128;  // Janela do p95
+const size_t WARMUP_SAMPLES = 20;    // Antes disso o nó ainda não tem p95 nem média confiáveis
+const double SMOOTHING = 0.2;        // Peso de cada amostra na média móvel
+const uint64_t PROBE_EVERY = 50;     // 1 escolha em 50 vai ao próximo nó da fila
+const int MAX_DOWN_SHIFT = 6;        // Afastamento máximo: 500 ms << 6 = 32 s
+
+struct Node {
+    std::string url;
+    std::string base;
+    std::atomic<int> inflight{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> hedges{0};
+    std::atomic<uint64_t> hedges_won{0};
+
+    std::mutex mutex; // Protege os campos abaixo
+    std::array<double, LATENCY_SAMPLES> samples{};
+    size_t sample_count = 0;
+    double mean_ms = 0;
+    double p95_ms = 0;
+    int consecutive_failures = 0;
+    Clock::time_point down_until;
+};
+
+std::vector<std::unique_ptr<Node>> g_nodes;
+std::atomic<uint64_t> g_picks(0);
+std::atomic<bool> g_hedging(true);
+thread_local int t_pinned = -1;
+
+Node* node_at(int node) {
+    return node >= 0 && static_cast<size_t>(node) < g_nodes.size() ? g_nodes[node].get() : nullptr;
+}
+
+} // namespace
+
+std::string server_to_rpc_url(const std::string& server) {
+    std::string url = server;
+    size_t scheme = url.find("://");
+    if (scheme == std::string::npos) {
+        url = "http://" + url;
+        scheme = 4;
+    }
+    size_t host = scheme + 3;
+    size_t path = url.find('/', host);
+    if (path == std::string::npos) path = url.size();
+    // Porta padrão do RPC do monerod quando só o host foi dado
+    if (url.find(':', host) > path) {
+        url.insert(path, ":18081");
+        path += 6;
+    }
+    // Um caminho já dado (/json_rpc ou o de um proxy) fica como está
+    if (path + 1 < url.size()) return url;
+    return url.substr(0, path) + "/json_rpc";
+}
+
+std::vector<std::string> parse_server_list(const std::string& list) {
+    std::vector<std::string> out;
+    std::string item;
+    for (size_t i = 0; i <= list.size(); ++i) {
+        char c = i < list.size() ? list[i] : ',';
+        if (c == ',' || c == ' ' || c == '\t') {
+            if (!item.empty()) out.push_back(server_to_rpc_url(item));
+            item.clear();
+        } else {
+            item += c;
+        }
+    }
+    return out;
+}
+
+void set_rpc_nodes(const std::vector<std::string>& urls) {
+    g_nodes.clear();
+    const std::string suffix = "/json_rpc";
+    for (const auto& url : urls) {
+        std::unique_ptr<Node> node(new Node);
+        node->url = url;
+        node->base = url;
+        if (url.size() >= suffix.size() && url.compare(url.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            node->base = url.substr(0, url.size() - suffix.size());
+        }
+        g_nodes.push_back(std::move(node));
+    }
+}
+
+size_t rpc_node_count() {
+    return g_nodes.size();
+}
+
+std::string rpc_node_url(int node) {
+    Node* n = node_at(node);
+    return n ? n->url : std::string();
+}
+
+std::string rpc_node_base_url(int node) {
+    Node* n = node_at(node);
+    return n ? n->base : std::string();
+}
+
+int pick_rpc_node(int exclude) {
+    int count = static_cast<int>(g_nodes.size());
+    if (count == 0 || (count == 1 && exclude == 0)) return -1;
+    if (count == 1) return 0;
+
+    auto now = Clock::now();
+    uint64_t tick = g_picks++;
+    // Um nó lento só recebe as sondagens; sem elas a média dele nunca
+    // melhoraria depois que a rede se recupera
+    if (tick % PROBE_EVERY == 0) {
+        int probe = static_cast<int>((tick / PROBE_EVERY) % count);
+        Node& n = *g_nodes[probe];
+        std::lock_guard<std::mutex> lock(n.mutex);
+        if (probe != exclude && n.down_until <= now) return probe;
+    }
+
+    int best = -1;
+    double best_score = std::numeric_limits<double>::infinity();
+    int soonest = -1; // Se todos estiverem fora, o que volta primeiro
+    Clock::time_point soonest_at = Clock::time_point::max();
+    for (int i = 0; i < count; ++i) {
+        if (i == exclude) continue;
+        Node& n = *g_nodes[i];
+        std::lock_guard<std::mutex> lock(n.mutex);
+        if (n.down_until > now) {
+            if (n.down_until < soonest_at) {
+                soonest_at = n.down_until;
+                soonest = i;
+            }
+            continue;
+        }
+        // Nó ainda sem amostras suficientes: vai na frente para ser medido
+        double latency = n.sample_count < WARMUP_SAMPLES ? 0.0 : n.mean_ms;
+        double score = latency * (1 + n.inflight.load()) + n.inflight.load() * 1e-3;
+        if (score < best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+    return best >= 0 ? best : soonest;
+}
+
+void rpc_node_started(int node) {
+    if (Node* n = node_at(node)) n->inflight++;
+}
+
+void rpc_node_finished(int node, bool ok, double latency_ms) {
+    Node* n = node_at(node);
+    if (!n) return;
+    n->inflight--;
+    n->requests++;
+    std::lock_guard<std::mutex> lock(n->mutex);
+    if (!ok) {
+        n->failures++;
+        // Fora por 500 ms, 1 s, 2 s... enquanto as falhas se repetirem
+        int shift = std::min(n->consecutive_failures++, MAX_DOWN_SHIFT);
+        n->down_until = Clock::now() + std::chrono::milliseconds(500 << shift);
+        return;
+    }
+    n->consecutive_failures = 0;
+    n->samples[n->sample_count % LATENCY_SAMPLES] = latency_ms;
+    n->mean_ms = n->sample_count == 0 ? latency_ms : n->mean_ms + SMOOTHING * (latency_ms - n->mean_ms);
+    ++n->sample_count;
+    // O p95 é refeito a cada 8 amostras sobre a janela
+    if (n->sample_count >= WARMUP_SAMPLES && n->sample_count % 8 == 0) {
+        size_t size = std::min(n->sample_count, LATENCY_SAMPLES);
+        std::array<double, LATENCY_SAMPLES> window = n->samples;
+        size_t index = (size * 95) / 100;
+        std::nth_element(window.begin(), window.begin() + index, window.begin() + size);
+        n->p95_ms = window[index];
+    }
+}
+
+double rpc_node_p95(int node) {
+    Node* n = node_at(node);
+    if (!n) return 0;
+    std::lock_guard<std::mutex> lock(n->mutex);
+    return n->p95_ms;
+}
+
+void rpc_node_hedged(int node, bool won) {
+    Node* n = node_at(node);
+    if (!n) return;
+    n->hedges++;
+    if (won) n->hedges_won++;
+}
+
+void set_rpc_hedging(bool enabled) {
+    g_hedging = enabled;
+}
+
+bool rpc_hedging() {
+    return g_hedging && g_nodes.size() > 1;
+}
+
+RpcNodePin::RpcNodePin(int node) : previous_(t_pinned) {
+    t_pinned = node;
+}
+
+RpcNodePin::~RpcNodePin() {
+    t_pinned = previous_;
+}
+
+int pinned_rpc_node() {
+    return t_pinned;
+}
+
+std::vector<NodeStats> get_rpc_node_stats() {
+    std::vector<NodeStats> out;
+    for (const auto& n : g_nodes) {
+        NodeStats stats;
+        stats.url = n->url;
+        stats.requests = n->requests.load();
+        stats.failures = n->failures.load();
+        stats.hedges = n->hedges.load();
+        stats.hedges_won = n->hedges_won.load();
+        std::lock_guard<std::mutex> lock(n->mutex);
+        stats.mean_ms = n->mean_ms;
+        stats.p95_ms = n->p95_ms;
+        out.push_back(stats);
+    }
+    return out;
+}
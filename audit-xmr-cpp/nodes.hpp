@@ -0,0 +1,61 @@
+// nodes.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Vários nós RPC (chave servers= do audit-xmr.cfg ou --servers). Cada
+// requisição vai ao nó com a menor latência estimada (média móvel vezes as
+// requisições em voo nele), e um nó que falha fica de fora por um tempo
+// crescente. O primeiro da lista vira RPC_URL; com um só nó tudo se comporta
+// como antes.
+
+// "host", "host:porta" ou uma URL completa -> http://host:porta/json_rpc
+std::string server_to_rpc_url(const std::string& server);
+// Lista separada por vírgulas ou espaços, já convertida com server_to_rpc_url
+std::vector<std::string> parse_server_list(const std::string& list);
+
+// Define os nós (URLs terminadas em /json_rpc). Chame antes das threads.
+void set_rpc_nodes(const std::vector<std::string>& urls);
+size_t rpc_node_count();
+std::string rpc_node_url(int node);      // Endpoint JSON-RPC do nó
+std::string rpc_node_base_url(int node); // Sem o sufixo /json_rpc
+
+// Nó da próxima requisição, diferente de 'exclude' (-1 se não houver outro)
+int pick_rpc_node(int exclude = -1);
+void rpc_node_started(int node);
+void rpc_node_finished(int node, bool ok, double latency_ms);
+// p95 recente da latência do nó: o limiar do pedido duplicado. 0 enquanto
+// houver poucas amostras.
+double rpc_node_p95(int node);
+void rpc_node_hedged(int node, bool won); // Duplicado enviado a 'node' (e se venceu)
+
+// Duplicado em outro nó quando a resposta passa do p95 (padrão ligado;
+// só tem efeito com mais de um nó)
+void set_rpc_hedging(bool enabled);
+bool rpc_hedging();
+
+// Fixa o nó das requisições da thread enquanto existir, sem balanceamento
+// nem duplicado (usado para perguntar a cada nó no quórum)
+class RpcNodePin {
+public:
+    explicit RpcNodePin(int node);
+    ~RpcNodePin();
+    RpcNodePin(const RpcNodePin&) = delete;
+    RpcNodePin& operator=(const RpcNodePin&) = delete;
+
+private:
+    int previous_;
+};
+int pinned_rpc_node(); // -1 se a thread não fixou nenhum
+
+struct NodeStats {
+    std::string url;
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t hedges = 0;     // Duplicados enviados a este nó
+    uint64_t hedges_won = 0; // Dos quais responderam antes do original
+    double mean_ms = 0;      // Média móvel da latência
+    double p95_ms = 0;
+};
+std::vector<NodeStats> get_rpc_node_stats();
@@ -0,0 +1,241 @@
+// portable_storage.cpp
+#include "portable_storage.hpp"
+#include <cstring>
+
+namespace ps {
+
+namespace {
+
+const uint32_t SIGNATURE_A = 0x01011101;
+const uint32_t SIGNATURE_B = 0x01020101;
+const uint8_t FORMAT_VERSION = 1;
+const int MAX_DEPTH = 64;
+
+class Reader {
+public:
+    explicit Reader(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+    bool read_bytes(void* out, size_t n) {
+        if (static_cast<size_t>(end_ - p_) < n) return fail("fim inesperado dos dados");
+        std::memcpy(out, p_, n);
+        p_ += n;
+        return true;
+    }
+
+    // Inteiro little-endian de tamanho fixo
+    template <typename T>
+    bool read_le(T& value) {
+        uint8_t buf[sizeof(T)];
+        if (!read_bytes(buf, sizeof(T))) return false;
+        uint64_t v = 0;
+        for (size_t k = 0; k < sizeof(T); ++k) v |= static_cast<uint64_t>(buf[k]) << (8 * k);
+        value = static_cast<T>(v);
+        return true;
+    }
+
+    // Varint do epee: os 2 bits baixos do primeiro byte dão o tamanho (1, 2, 4 ou 8 bytes)
+    bool read_varint(uint64_t& value) {
+        if (p_ >= end_) return fail("fim inesperado dos dados");
+        uint8_t mark = static_cast<uint8_t>(*p_) & 0x03;
+        size_t size = size_t(1) << mark;
+        if (static_cast<size_t>(end_ - p_) < size) return fail("varint truncado");
+        uint64_t raw = 0;
+        for (size_t k = 0; k < size; ++k) raw |= static_cast<uint64_t>(static_cast<uint8_t>(p_[k])) << (8 * k);
+        p_ += size;
+        value = raw >> 2;
+        return true;
+    }
+
+    bool read_view(size_t n, std::string_view& out) {
+        if (static_cast<size_t>(end_ - p_) < n) return fail("string truncada");
+        out = std::string_view(p_, n);
+        p_ += n;
+        return true;
+    }
+
+    bool read_section(Object& obj, int depth) {
+        if (depth > MAX_DEPTH) return fail("aninhamento excessivo");
+        uint64_t count;
+        if (!read_varint(count)) return false;
+        if (count > static_cast<uint64_t>(end_ - p_)) return fail("seção com contagem inválida");
+        obj.reserve(obj.size() + count);
+        for (uint64_t k = 0; k < count; ++k) {
+            uint8_t name_len;
+            if (!read_le(name_len)) return false;
+            std::string_view name;
+            if (!read_view(name_len, name)) return false;
+            uint8_t type;
+            if (!read_le(type)) return false;
+            Value v;
+            if (!read_value(type, v, depth)) return false;
+            obj.emplace_back(name, std::move(v));
+        }
+        return true;
+    }
+
+    bool read_value(uint8_t type, Value& v, int depth) {
+        if (type & FLAG_ARRAY) {
+            v.is_array = true;
+            v.type = type & ~FLAG_ARRAY;
+            uint64_t count;
+            if (!read_varint(count)) return false;
+            if (count > static_cast<uint64_t>(end_ - p_)) return fail("array com contagem inválida");
+            v.items.resize(count);
+            for (auto& item : v.items) {
+                if (!read_single(v.type, item, depth)) return false;
+            }
+            return true;
+        }
+        return read_single(type, v, depth);
+    }
+
+    bool read_single(uint8_t type, Value& v, int depth) {
+        v.type = type;
+        switch (type) {
+            case TYPE_INT64: { int64_t x; if (!read_le(x)) return false; v.i = x; return true; }
+            case TYPE_INT32: { int32_t x; if (!read_le(x)) return false; v.i = x; return true; }
+            case TYPE_INT16: { int16_t x; if (!read_le(x)) return false; v.i = x; return true; }
+            case TYPE_INT8: { int8_t x; if (!read_le(x)) return false; v.i = x; return true; }
+            case TYPE_UINT64: { uint64_t x; if (!read_le(x)) return false; v.u = x; return true; }
+            case TYPE_UINT32: { uint32_t x; if (!read_le(x)) return false; v.u = x; return true; }
+            case TYPE_UINT16: { uint16_t x; if (!read_le(x)) return false; v.u = x; return true; }
+            case TYPE_UINT8: { uint8_t x; if (!read_le(x)) return false; v.u = x; return true; }
+            case TYPE_BOOL: { uint8_t x; if (!read_le(x)) return false; v.u = x != 0; return true; }
+            case TYPE_DOUBLE: return read_bytes(&v.d, sizeof(double));
+            case TYPE_STRING: {
+                uint64_t len;
+                if (!read_varint(len)) return false;
+                return read_view(static_cast<size_t>(len), v.s);
+            }
+            case TYPE_OBJECT:
+                v.obj = std::make_shared<Object>();
+                return read_section(*v.obj, depth + 1);
+            case TYPE_ARRAY: {
+                // Array de arrays: cada elemento traz o próprio tipo
+                uint8_t inner;
+                if (!read_le(inner)) return false;
+                return read_value(inner, v, depth + 1);
+            }
+            default:
+                return fail("tipo desconhecido " + std::to_string(type));
+        }
+    }
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) error_ = message;
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    const char* p_;
+    const char* end_;
+    std::string error_;
+};
+
+void write_le(std::string& out, uint64_t value, size_t size) {
+    for (size_t k = 0; k < size; ++k) out.push_back(static_cast<char>((value >> (8 * k)) & 0xff));
+}
+
+void write_varint(std::string& out, uint64_t value) {
+    if (value <= 63) write_le(out, (value << 2) | 0, 1);
+    else if (value <= 16383) write_le(out, (value << 2) | 1, 2);
+    else if (value <= 1073741823) write_le(out, (value << 2) | 2, 4);
+    else write_le(out, (value << 2) | 3, 8);
+}
+
+} // namespace
+
+const Value* Value::find(std::string_view name) const {
+    if (!obj) return nullptr;
+    for (const auto& member : *obj) {
+        if (member.first == name) return &member.second;
+    }
+    return nullptr;
+}
+
+bool decode(std::string_view data, Value& root, std::string* error) {
+    Reader reader(data);
+    uint32_t sig_a = 0, sig_b = 0;
+    uint8_t version = 0;
+    if (!reader.read_le(sig_a) || !reader.read_le(sig_b) || !reader.read_le(version) ||
+        sig_a != SIGNATURE_A || sig_b != SIGNATURE_B || version != FORMAT_VERSION) {
+        if (error) *error = "assinatura de portable storage inválida";
+        return false;
+    }
+    root = Value();
+    root.type = TYPE_OBJECT;
+    root.obj = std::make_shared<Object>();
+    if (!reader.read_section(*root.obj, 0)) {
+        if (error) *error = reader.error();
+        return false;
+    }
+    return true;
+}
+
+Writer::Writer() {}
+
+void Writer::name(std::string_view n) {
+    body_.push_back(static_cast<char>(n.size()));
+    body_.append(n.data(), n.size());
+    ++count_;
+}
+
+void Writer::add_uint64_array(std::string_view n, const std::vector<uint64_t>& values) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_UINT64 | FLAG_ARRAY));
+    write_varint(body_, values.size());
+    for (uint64_t v : values) write_le(body_, v, 8);
+}
+
+void Writer::add_string(std::string_view n, std::string_view value) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_STRING));
+    write_varint(body_, value.size());
+    body_.append(value.data(), value.size());
+}
+
+void Writer::add_bool(std::string_view n, bool value) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_BOOL));
+    body_.push_back(value ? 1 : 0);
+}
+
+void Writer::add_uint64(std::string_view n, uint64_t value) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_UINT64));
+    write_le(body_, value, 8);
+}
+
+void Writer::add_string_array(std::string_view n, const std::vector<std::string>& values) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_STRING | FLAG_ARRAY));
+    write_varint(body_, values.size());
+    for (const auto& v : values) {
+        write_varint(body_, v.size());
+        body_ += v;
+    }
+}
+
+void Writer::add_object_array(std::string_view n, const std::vector<Writer>& items) {
+    name(n);
+    body_.push_back(static_cast<char>(TYPE_OBJECT | FLAG_ARRAY));
+    write_varint(body_, items.size());
+    for (const auto& item : items) {
+        write_varint(body_, item.count_);
+        body_ += item.body_;
+    }
+}
+
+std::string Writer::finish() {
+    std::string out;
+    write_le(out, SIGNATURE_A, 4);
+    write_le(out, SIGNATURE_B, 4);
+    out.push_back(static_cast<char>(FORMAT_VERSION));
+    write_varint(out, count_);
+    out += body_;
+    return out;
+}
+
+} // namespace ps
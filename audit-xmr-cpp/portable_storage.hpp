@@ -0,0 +1,71 @@
+// portable_storage.hpp
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Formato binário "portable storage" do epee, usado pelos endpoints .bin do
+// monerod. Implementa apenas o necessário para montar requisições e ler as
+// respostas: as strings decodificadas apontam para o buffer original, que
+// precisa continuar vivo enquanto o valor for usado.
+namespace ps {
+
+enum Type : uint8_t {
+    TYPE_INT64 = 1,
+    TYPE_INT32 = 2,
+    TYPE_INT16 = 3,
+    TYPE_INT8 = 4,
+    TYPE_UINT64 = 5,
+    TYPE_UINT32 = 6,
+    TYPE_UINT16 = 7,
+    TYPE_UINT8 = 8,
+    TYPE_DOUBLE = 9,
+    TYPE_STRING = 10,
+    TYPE_BOOL = 11,
+    TYPE_OBJECT = 12,
+    TYPE_ARRAY = 13,
+    FLAG_ARRAY = 0x80
+};
+
+struct Value;
+using Object = std::vector<std::pair<std::string_view, Value>>;
+
+struct Value {
+    uint8_t type = 0;            // Tipo do elemento (sem FLAG_ARRAY)
+    bool is_array = false;
+    uint64_t u = 0;              // Inteiros sem sinal e bool
+    int64_t i = 0;               // Inteiros com sinal
+    double d = 0;
+    std::string_view s;          // Strings (blobs binários)
+    std::shared_ptr<Object> obj;
+    std::vector<Value> items;    // Elementos quando is_array
+
+    const Value* find(std::string_view name) const; // Membro de um objeto
+    uint64_t as_uint() const { return type == TYPE_INT64 || type == TYPE_INT32 || type == TYPE_INT16 || type == TYPE_INT8 ? static_cast<uint64_t>(i) : u; }
+};
+
+// Decodifica um documento completo; retorna false se estiver malformado
+bool decode(std::string_view data, Value& root, std::string* error = nullptr);
+
+// Monta um documento campo a campo
+class Writer {
+public:
+    Writer();
+    void add_uint64_array(std::string_view name, const std::vector<uint64_t>& values);
+    void add_string(std::string_view name, std::string_view value);
+    void add_bool(std::string_view name, bool value);
+    void add_uint64(std::string_view name, uint64_t value);
+    void add_string_array(std::string_view name, const std::vector<std::string>& values);
+    void add_object_array(std::string_view name, const std::vector<Writer>& items); // Cada Writer vira uma seção
+    std::string finish(); // Fecha a seção raiz e devolve o buffer
+
+private:
+    void name(std::string_view n);
+    std::string body_;
+    size_t count_ = 0;
+};
+
+} // namespace ps
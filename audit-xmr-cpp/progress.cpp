@@ -0,0 +1,66 @@
+// progress.cpp
+#include "progress.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const double RATE_SMOOTHING = 0.3; // Peso do último intervalo na taxa exibida
+
+std::string format_duration(double seconds) {
+    if (seconds < 0 || seconds > 99.0 * 3600) return "--:--:--";
+    long s = static_cast<long>(seconds + 0.5);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%ld:%02ld:%02ld", s / 3600, (s / 60) % 60, s % 60);
+    return buf;
+}
+
+} // namespace
+
+ProgressReporter::ProgressReporter(uint64_t total, std::chrono::milliseconds interval)
+    : total_(total), interval_(interval),
+      started_(std::chrono::steady_clock::now()), last_draw_(started_) {}
+
+void ProgressReporter::update(uint64_t done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_draw_ < interval_) return;
+
+    double elapsed = std::chrono::duration<double>(now - last_draw_).count();
+    double instant = (done - last_done_) / elapsed;
+    rate_ = rate_ == 0 ? instant : rate_ + (instant - rate_) * RATE_SMOOTHING;
+    last_draw_ = now;
+    last_done_ = done;
+    draw(done, rate_, rate_ > 0 ? (total_ - done) / rate_ : -1);
+}
+
+void ProgressReporter::finish(uint64_t done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    draw(done, elapsed > 0 ? done / elapsed : 0, 0);
+    std::cout << "\n" << std::flush;
+}
+
+void ProgressReporter::draw(uint64_t done, double rate, double eta_seconds) {
+    const int bar_width = 20;
+    double progress = total_ > 0 ? static_cast<double>(done) / total_ : 1.0;
+    int pos = static_cast<int>(bar_width * progress);
+
+    std::string line = "\rProgresso: [";
+    for (int i = 0; i < bar_width; ++i) {
+        if (i < pos) line += '=';
+        else if (i == pos) line += '>';
+        else line += ' ';
+    }
+    char tail[128];
+    std::snprintf(tail, sizeof(tail), "] %d%% (%llu/%llu) %.0f blocos/s, ETA %s",
+                  static_cast<int>(progress * 100.0), static_cast<unsigned long long>(done),
+                  static_cast<unsigned long long>(total_), rate, format_duration(eta_seconds).c_str());
+    line += tail;
+    // Apaga restos de uma linha anterior mais longa
+    size_t width = line.size();
+    if (width < last_width_) line.append(last_width_ - width, ' ');
+    last_width_ = width;
+    std::cout << line << std::flush;
+}
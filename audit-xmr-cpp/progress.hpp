@@ -0,0 +1,29 @@
+// progress.hpp
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Barra de progresso com taxa (blocos/s) e tempo restante estimado. As
+// chamadas a update() são baratas: a linha só é redesenhada a cada
+// 'interval', não a cada bloco.
+class ProgressReporter {
+public:
+    explicit ProgressReporter(uint64_t total, std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+    void update(uint64_t done);
+    // Desenha a linha final com a taxa média e quebra a linha
+    void finish(uint64_t done);
+
+private:
+    void draw(uint64_t done, double rate, double eta_seconds);
+
+    std::mutex mutex_;
+    uint64_t total_;
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point last_draw_;
+    uint64_t last_done_ = 0;
+    double rate_ = 0; // Média móvel da taxa entre redesenhos
+    size_t last_width_ = 0;
+};
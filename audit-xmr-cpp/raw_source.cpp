@@ -0,0 +1,193 @@
+// raw_source.cpp
+#include "raw_source.hpp"
+#include "audit.hpp" // g_log_path e log_message
+#include "block_binary.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+const uint32_t RAW_MAGIC = 0x28721586; // blockchain_raw_magic (bootstrap_file.h)
+
+MappedFile g_file;
+const uint8_t* g_data = nullptr;
+int g_first_height = 0;
+std::vector<uint64_t> g_offsets; // Início de cada registro (depois do tamanho)
+std::vector<uint32_t> g_sizes;
+
+// Inteiros da serialização binária do Monero: little-endian de largura fixa
+uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Início do varint que termina em 'end': só o último byte não tem o bit de continuação
+const uint8_t* varint_start(const uint8_t* begin, const uint8_t* end) {
+    if (end == begin || (end[-1] & 0x80)) return nullptr;
+    const uint8_t* p = end - 1;
+    while (p > begin && (p[-1] & 0x80)) --p;
+    return p;
+}
+
+// O block_package termina em três varints: peso, dificuldade acumulada (que
+// já passa de 64 bits) e moedas geradas até o bloco. Lidos de trás para
+// frente, dispensam percorrer as txs.
+bool package_tail(size_t index, uint64_t& weight, uint64_t& coins) {
+    const uint8_t* begin = g_data + g_offsets[index];
+    const uint8_t* end = begin + g_sizes[index];
+    const uint8_t* coins_at = varint_start(begin, end);
+    const uint8_t* difficulty_at = coins_at ? varint_start(begin, coins_at) : nullptr;
+    const uint8_t* weight_at = difficulty_at ? varint_start(begin, difficulty_at) : nullptr;
+    if (!weight_at) return false;
+    const uint8_t* p = coins_at;
+    if (!read_varint(p, end, coins)) return false;
+    p = weight_at;
+    return read_varint(p, difficulty_at, weight);
+}
+
+} // namespace
+
+bool open_raw_source(const std::string& path, std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    if (!g_file.open(path, MADV_WILLNEED)) return fail("não foi possível mapear " + path);
+    std::string_view file = g_file.view();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+    size_t size = file.size();
+
+    // magic, depois o cabeçalho (bootstrap_file.cpp): [uint32 n][file_info]
+    // [uint32 n][blocks_info] e zeros até completar header_size. As duas
+    // estruturas vêm na serialização binária: file_info é major e minor
+    // (uint8) e header_size (varint); blocks_info é block_first, block_last
+    // e block_last_pos, todos varints
+    if (size < 4 + 4 || load32(data) != RAW_MAGIC) return fail("não é um blockchain.raw (magic inválido)");
+    uint32_t file_info_size = load32(data + 4);
+    if (file_info_size < 3 || 8 + static_cast<uint64_t>(file_info_size) > size) return fail("file_info inválido");
+    const uint8_t* p = data + 8 + 2;
+    const uint8_t* file_info_end = data + 8 + file_info_size;
+    uint64_t header_size = 0;
+    if (!read_varint(p, file_info_end, header_size)) return fail("file_info inválido");
+    if (header_size == 0 || 4 + header_size > size) return fail("header_size inválido");
+    const uint8_t* header_end = data + 4 + header_size;
+
+    // blocks_info é opcional para a leitura: o exportador grava block_first
+    // = 0 e não o atualiza, e a altura da coinbase confere abaixo
+    uint64_t first_block = 0;
+    if (file_info_end + 4 <= header_end) {
+        uint32_t blocks_info_size = load32(file_info_end);
+        p = file_info_end + 4;
+        const uint8_t* blocks_info_end = p + blocks_info_size;
+        if (blocks_info_end > header_end || !read_varint(p, blocks_info_end, first_block)) first_block = 0;
+    }
+    if (first_block > static_cast<uint64_t>(INT32_MAX)) return fail("block_first inválido");
+    g_first_height = static_cast<int>(first_block);
+
+    // Passada única pelos tamanhos (um bloco por registro, como o exportador
+    // grava): só toca uma página por registro
+    g_offsets.clear();
+    g_sizes.clear();
+    g_offsets.reserve(size / 2048);
+    g_sizes.reserve(size / 2048);
+    uint64_t pos = 4 + header_size;
+    while (pos + 4 <= size) {
+        uint32_t chunk = load32(data + pos);
+        if (chunk == 0 || pos + 4 + chunk > size) {
+            std::stringstream ss;
+            ss << "[AVISO] Registro truncado na posição " << pos << " de " << path << "; lendo só os "
+               << g_offsets.size() << " blocos anteriores";
+            log_message(g_log_path, ss.str());
+            break;
+        }
+        g_offsets.push_back(pos + 4);
+        g_sizes.push_back(chunk);
+        pos += 4 + static_cast<uint64_t>(chunk);
+    }
+    if (g_offsets.empty()) return fail("nenhum bloco no arquivo");
+
+    // Exportações antigas gravam block_first = 0 mesmo começando depois; a
+    // altura da coinbase do primeiro bloco decide
+    ParsedBlock first;
+    size_t first_size = 0;
+    std::string parse_error;
+    if (parse_block_blob(data + g_offsets[0], g_sizes[0], first, &parse_error, &first_size) &&
+        first.miner_tx.gen_height >= 0 && first.miner_tx.gen_height != g_first_height &&
+        first.miner_tx.gen_height <= INT32_MAX) {
+        log_message(g_log_path, "[AVISO] block_first do cabeçalho (" + std::to_string(g_first_height)
+                                + ") difere da altura do primeiro bloco (" + std::to_string(first.miner_tx.gen_height)
+                                + "); usando a do bloco");
+        g_first_height = static_cast<int>(first.miner_tx.gen_height);
+    }
+    g_data = data;
+    return true;
+}
+
+int get_raw_first_height() {
+    return g_first_height;
+}
+
+int get_blockchain_height_raw() {
+    return g_data ? g_first_height + static_cast<int>(g_offsets.size()) : -1;
+}
+
+bool get_blocks_fields_raw(int from, int to, std::vector<BlockFields>& out) {
+    out.clear();
+    if (!g_data || from < g_first_height || to < from || to >= get_blockchain_height_raw()) {
+        std::stringstream ss;
+        ss << "[ERRO] Blocos " << from << ".." << to << " fora do blockchain.raw (" << g_first_height
+           << ".." << get_blockchain_height_raw() - 1 << ")";
+        log_message(g_log_path, ss.str());
+        return false;
+    }
+
+    out.resize(static_cast<size_t>(to - from) + 1);
+    std::string error;
+    // Moedas geradas antes do lote; desconhecidas no primeiro bloco de uma
+    // exportação que não começa na altura 0
+    uint64_t weight = 0, coins = 0;
+    bool prev_known = from == 0;
+    uint64_t prev_coins = 0;
+    if (from > g_first_height && package_tail(static_cast<size_t>(from - 1 - g_first_height), weight, coins)) {
+        prev_known = true;
+        prev_coins = coins;
+    }
+    for (int h = from; h <= to; ++h) {
+        size_t index = static_cast<size_t>(h - g_first_height);
+        const uint8_t* record = g_data + g_offsets[index];
+        // O bloco abre o block_package; as txs e os demais campos vêm depois dele
+        ParsedBlock block;
+        size_t block_size = 0;
+        if (!parse_block_blob(record, g_sizes[index], block, &error, &block_size)) {
+            std::stringstream ss;
+            ss << "[ERRO] Bloco inválido no blockchain.raw na altura " << h << ": " << error;
+            log_message(g_log_path, ss.str());
+            out.clear();
+            return false;
+        }
+        Hash32 id = block_id(record, block_size, block);
+        BlockFields& f = out[static_cast<size_t>(h - from)];
+        f.hash = to_hex(id.data(), id.size());
+        f.prev_hash = to_hex(block.prev_id.data(), block.prev_id.size());
+        f.reward = block.miner_tx.vout_sum;
+        f.coinbase_sum = block.miner_tx.vout_sum;
+        f.vin_count = block.miner_tx.vin_count;
+        f.gen_height = block.miner_tx.gen_height;
+        f.major_version = block.major_version;
+        if (!package_tail(index, weight, coins)) {
+            prev_known = false;
+            continue;
+        }
+        f.weight = weight;
+        uint64_t emission = coins - prev_coins;
+        if (prev_known && coins >= prev_coins && block.miner_tx.vout_sum >= emission) {
+            f.generated = prev_coins;
+            f.fees = block.miner_tx.vout_sum - emission;
+        }
+        prev_known = true;
+        prev_coins = coins;
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+// raw_source.hpp
+#pragma once
+#include <string>
+#include <vector>
+#include "block_parse.hpp"
+
+// Fonte offline: exportação blockchain.raw do monero-blockchain-export.
+// O arquivo é mapeado em memória; depois do magic e de um cabeçalho de
+// tamanho fixo vêm os blocos, cada um num registro "uint32 tamanho +
+// block_package" (bloco, txs, peso, dificuldade e moedas geradas). Uma
+// passada só pelos tamanhos indexa os registros, e os lotes são lidos em
+// paralelo. O arquivo não traz o hash dos blocos: ele é calculado do blob.
+// As moedas geradas do registro dão a emissão e as taxas de cada bloco.
+
+bool open_raw_source(const std::string& path, std::string* error = nullptr); // Chame antes das threads
+
+int get_raw_first_height();      // Primeira altura da exportação (block_first do cabeçalho)
+int get_blockchain_height_raw(); // Altura seguinte ao último bloco do arquivo (-1 se não aberto)
+
+// Blocos [from, to], que precisam estar no arquivo. O reward é a soma das
+// saídas da miner tx, como o monerod devolve em block_header.reward.
+bool get_blocks_fields_raw(int from, int to, std::vector<BlockFields>& out);
@@ -1,62 +1,327 @@
 #include "rpc.hpp"
 #include "audit.hpp" // Incluído para acessar a declaração de log_message
+#include "log.hpp"
+#include "nodes.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
+#include "block_binary.hpp"
+#include "portable_storage.hpp"
 
 using json = nlohmann::json;
 
 std::string RPC_URL = "http://127.0.0.1:18081/json_rpc";
 extern std::string g_log_path; // Definido em audit-xmr.cpp
 
-void set_rpc_url(const std::string& url) {
-    RPC_URL = url;
-    std::stringstream ss;
-    ss << "[DEBUG] RPC_URL definida como " << url;
-    log_message(g_log_path, ss.str(), false);
+// Pool de conexões: cada thread reaproveita o seu próprio handle CURL entre
+// chamadas (keep-alive), e todos os handles compartilham o cache de DNS e de
+// conexões através de um CURLSH. Assim uma auditoria longa abre poucas
+// conexões TCP em vez de uma por bloco.
+static std::once_flag curl_init_flag;
+static CURLSH* curl_share = nullptr;
+static std::mutex curl_share_locks[CURL_LOCK_DATA_LAST];
+static std::atomic<long> rpc_timeout_seconds(10);
+static std::atomic<int> tx_batch_size(MAX_TX_BATCH);
+static std::atomic<bool> fee_audit(false);
+static std::atomic<bool> id_check(false);
+static std::atomic<uint64_t> rpc_request_count(0);
+static std::atomic<uint64_t> rpc_connect_count(0);
+static const double MIN_HEDGE_MS = 5.0;
+
+static void share_lock(CURL*, curl_lock_data data, curl_lock_access, void*) {
+    curl_share_locks[data].lock();
+}
+
+static void share_unlock(CURL*, curl_lock_data data, void*) {
+    curl_share_locks[data].unlock();
 }
 
+static void init_curl_share() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    curl_share = curl_share_init();
+    if (!curl_share) return;
+    curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+// Handle persistente da thread; liberado automaticamente quando a thread
+// termina. Com vários nós, 'hedge' e 'multi' levam o pedido duplicado.
+struct PooledHandle {
+    CURL* curl = nullptr;
+    CURL* hedge = nullptr;
+    CURLM* multi = nullptr;
+    curl_slist* json_headers = nullptr;
+    curl_slist* bin_headers = nullptr;
+
+    ~PooledHandle() {
+        if (multi) curl_multi_cleanup(multi);
+        if (curl) curl_easy_cleanup(curl);
+        if (hedge) curl_easy_cleanup(hedge);
+        if (json_headers) curl_slist_free_all(json_headers);
+        if (bin_headers) curl_slist_free_all(bin_headers);
+    }
+};
+
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
     ((std::string*)userp)->append((char*)contents, size * nmemb);
     return size * nmemb;
 }
 
-std::string rpc_call(const std::string& method, const std::string& params_json) {
-    std::stringstream ss;
-    ss << "[DEBUG] Chamando RPC: " << method << " com params " << params_json;
-    log_message(g_log_path, ss.str(), false);
+CURL* rpc_new_handle() {
+    std::call_once(curl_init_flag, init_curl_share);
 
     CURL* curl = curl_easy_init();
-    if (!curl) return "";
-
-    std::string response_string;
-    std::string post_fields = R"({"jsonrpc":"2.0","id":"0","method":")"
-                                + method + R"(","params":)" + params_json + "}";
+    if (!curl) return nullptr;
 
-    curl_easy_setopt(curl, CURLOPT_URL, RPC_URL.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_fields.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+    // "" aceita todas as codificações suportadas pela libcurl (gzip, deflate...)
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    // O cache compartilhado mantém no máximo MAXCONNECTS conexões abertas
+    // (padrão 5); com mais threads que isso as conexões seriam descartadas
+    curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, 1024L);
+    if (curl_share) curl_easy_setopt(curl, CURLOPT_SHARE, curl_share);
+    return curl;
+}
+
+void rpc_prepare_post(CURL* curl, const std::string& url, const std::string& body, std::string* response) {
+    response->clear();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, rpc_timeout_seconds.load());
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
+bool rpc_finish_transfer(CURL* curl, CURLcode res, const std::string& what) {
+    long new_connects = 0;
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connects);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    rpc_request_count++;
+    rpc_connect_count += new_connects;
 
     if (res != CURLE_OK) {
-        ss.str("");
-        ss << "[ERRO] Falha na chamada CURL para " << method << ": "
+        std::stringstream ss;
+        ss << "[ERRO] Falha na chamada CURL para " << what << ": "
            << curl_easy_strerror(res);
         log_message(g_log_path, ss.str(), false);
-        return "";
+        return false;
+    }
+    if (http_code != 200) {
+        std::stringstream ss;
+        ss << "[ERRO] HTTP " << http_code << " na chamada " << what;
+        log_message(g_log_path, ss.str(), false);
+        return false;
     }
+    return true;
+}
 
-    ss.str("");
-    ss << "[DEBUG] Resposta RPC " << method << ": " << response_string;
-    log_message(g_log_path, ss.str(), false);
+std::string rpc_json_body(const std::string& method, const std::string& params_json) {
+    return R"({"jsonrpc":"2.0","id":"0","method":")" + method + R"(","params":)" + params_json + "}";
+}
+
+static PooledHandle* acquire_handle() {
+    thread_local PooledHandle handle;
+    if (handle.curl) return &handle;
+
+    handle.curl = rpc_new_handle();
+    if (!handle.curl) return nullptr;
+
+    handle.json_headers = curl_slist_append(nullptr, "Content-Type: application/json");
+    handle.bin_headers = curl_slist_append(nullptr, "Content-Type: application/octet-stream");
+    return &handle;
+}
+
+// Endpoint de 'path' no nó; vazio é o próprio JSON-RPC
+static std::string node_endpoint(int node, const std::string& path) {
+    if (node < 0) return path.empty() ? RPC_URL : rpc_base_url() + path; // Nenhum nó definido
+    return path.empty() ? rpc_node_url(node) : rpc_node_base_url(node) + path;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Envia ao nó 'node' e, se a resposta passar de hedge_ms (o p95 dele) ou o
+// nó falhar antes disso, repete o pedido no melhor dos outros nós. Vale a
+// primeira resposta boa; a outra transferência é cancelada.
+static bool post_hedged(PooledHandle* handle, int node, double hedge_ms, const std::string& path,
+                        const std::string& body, curl_slist* headers, const std::string& what,
+                        std::string& response) {
+    CURL* easy[2] = { handle->curl, handle->hedge };
+    int nodes[2] = { node, -1 };
+    bool running[2] = { false, false };
+    std::chrono::steady_clock::time_point started[2];
+    std::string hedge_response;
+    std::string* responses[2] = { &response, &hedge_response };
+    bool hedge_tried = false;
+    int winner = -1;
+
+    auto start = [&](int k) {
+        rpc_prepare_post(easy[k], node_endpoint(nodes[k], path), body, responses[k]);
+        curl_easy_setopt(easy[k], CURLOPT_HTTPHEADER, headers);
+        rpc_node_started(nodes[k]);
+        started[k] = std::chrono::steady_clock::now();
+        curl_multi_add_handle(handle->multi, easy[k]);
+        running[k] = true;
+    };
+    start(0);
+
+    while (winner < 0 && (running[0] || running[1])) {
+        int still = 0;
+        curl_multi_perform(handle->multi, &still);
+        CURLMsg* msg;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(handle->multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            int k = msg->easy_handle == easy[0] ? 0 : 1;
+            curl_multi_remove_handle(handle->multi, easy[k]);
+            running[k] = false;
+            bool ok = rpc_finish_transfer(easy[k], msg->data.result, what);
+            rpc_node_finished(nodes[k], ok, elapsed_ms(started[k]));
+            if (ok && winner < 0) winner = k;
+        }
+        if (winner >= 0) break;
+
+        double waited = elapsed_ms(started[0]);
+        if (!hedge_tried && (waited >= hedge_ms || !running[0])) {
+            hedge_tried = true;
+            nodes[1] = pick_rpc_node(node);
+            if (nodes[1] >= 0) {
+                start(1);
+                LOG_DEBUG(g_log_path, "[DEBUG] " + what + " duplicado em " + rpc_node_url(nodes[1])
+                          + " após " + std::to_string(static_cast<int>(waited)) + " ms");
+            }
+            continue;
+        }
+        int timeout_ms = hedge_tried ? 100 : std::max(1, static_cast<int>(hedge_ms - waited));
+        curl_multi_poll(handle->multi, nullptr, 0, timeout_ms, nullptr);
+    }
+
+    // Cancela a que ficou para trás: a latência até aqui entra como amostra
+    // (um limite inferior), o que já afasta o nó lento das próximas escolhas
+    for (int k = 0; k < 2; ++k) {
+        if (!running[k]) continue;
+        curl_multi_remove_handle(handle->multi, easy[k]);
+        rpc_request_count++;
+        rpc_node_finished(nodes[k], true, elapsed_ms(started[k]));
+    }
+    if (nodes[1] >= 0) rpc_node_hedged(nodes[1], winner == 1);
+    if (winner == 1) response.swap(hedge_response);
+    return winner >= 0;
+}
+
+// POST com o handle da thread no nó escolhido pelo balanceamento (ou no
+// fixado pela thread). 'path' vazio é o endpoint JSON-RPC; 'what'
+// identifica a chamada nos logs.
+static bool http_post(const std::string& path, const std::string& body, bool binary,
+                      const std::string& what, std::string& response) {
+    PooledHandle* handle = acquire_handle();
+    if (!handle) return false;
+    curl_slist* headers = binary ? handle->bin_headers : handle->json_headers;
+
+    int node = pinned_rpc_node();
+    bool pinned = node >= 0;
+    if (!pinned) node = pick_rpc_node();
+    // O duplicado só sai depois que o nó tem um p95 medido, e nunca antes de
+    // MIN_HEDGE_MS: abaixo disso a espera custa menos que a conexão que o
+    // cancelamento derruba
+    double hedge_ms = !pinned && rpc_hedging() ? rpc_node_p95(node) : 0;
+    if (hedge_ms > 0) hedge_ms = std::max(hedge_ms, MIN_HEDGE_MS);
+    if (hedge_ms > 0 && !handle->multi) {
+        handle->hedge = rpc_new_handle();
+        handle->multi = handle->hedge ? curl_multi_init() : nullptr;
+        // O limite padrão do multi (4 por handle) fecharia as conexões das
+        // outras threads no cache compartilhado
+        if (handle->multi) curl_multi_setopt(handle->multi, CURLMOPT_MAXCONNECTS, 1024L);
+    }
+
+    bool ok;
+    if (hedge_ms > 0 && handle->multi) {
+        ok = post_hedged(handle, node, hedge_ms, path, body, headers, what, response);
+    } else {
+        CURL* curl = handle->curl;
+        rpc_prepare_post(curl, node_endpoint(node, path), body, &response);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        rpc_node_started(node);
+        auto t0 = std::chrono::steady_clock::now();
+        CURLcode res = curl_easy_perform(curl);
+        ok = rpc_finish_transfer(curl, res, what);
+        rpc_node_finished(node, ok, elapsed_ms(t0));
+    }
+    if (!ok) return false;
+
+    // Só o tamanho: o corpo de um get_block tem dezenas de KB
+    LOG_DEBUG(g_log_path, "[DEBUG] Resposta RPC " + what + ": " + std::to_string(response.size()) + " bytes");
+    return true;
+}
+
+void set_rpc_timeout(long seconds) {
+    if (seconds <= 0) return;
+    rpc_timeout_seconds = seconds;
+    LOG_DEBUG(g_log_path, "[DEBUG] Timeout RPC definido como " + std::to_string(seconds) + "s");
+}
+
+void set_tx_batch_size(int size) {
+    tx_batch_size = std::max(1, std::min(size, MAX_TX_BATCH));
+}
+
+RpcStats get_rpc_stats() {
+    RpcStats stats;
+    stats.requests = rpc_request_count.load();
+    stats.connects = rpc_connect_count.load();
+    return stats;
+}
+
+void set_rpc_url(const std::string& url) {
+    RPC_URL = url;
+    set_rpc_nodes({ url });
+    LOG_DEBUG(g_log_path, "[DEBUG] RPC_URL definida como " + url);
+}
+
+std::string rpc_call(const std::string& method, const std::string& params_json) {
+    LOG_DEBUG(g_log_path, "[DEBUG] Chamando RPC: " + method + " com params " + params_json);
+
+    std::string response_string;
+    if (!http_post("", rpc_json_body(method, params_json), false, method, response_string)) return "";
     return response_string;
 }
 
+std::string rpc_base_url() {
+    const std::string suffix = "/json_rpc";
+    if (RPC_URL.size() >= suffix.size() &&
+        RPC_URL.compare(RPC_URL.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return RPC_URL.substr(0, RPC_URL.size() - suffix.size());
+    }
+    return RPC_URL;
+}
+
+std::string rpc_call_path(const std::string& path, const std::string& body_json) {
+    LOG_DEBUG(g_log_path, "[DEBUG] Chamando endpoint " + path);
+    std::string response;
+    if (!http_post(path, body_json, false, path, response)) return "";
+    return response;
+}
+
+std::string rpc_call_bin(const std::string& path, const std::string& body) {
+    LOG_DEBUG(g_log_path, "[DEBUG] Chamando endpoint binário " + path);
+    std::string response;
+    if (!http_post(path, body, true, path, response)) return "";
+    return response;
+}
+
 int get_blockchain_height() {
     std::string res = rpc_call("get_block_count", "{}");
     if (res.empty()) {
@@ -99,6 +364,490 @@ json get_block_info(int height) {
     }
 }
 
+static BlockHeader parse_block_header(const json& h) {
+    BlockHeader header;
+    header.height = h.at("height").get<int>();
+    header.hash = h.at("hash").get<std::string>();
+    header.prev_hash = h.value("prev_hash", std::string());
+    header.miner_tx_hash = h.value("miner_tx_hash", std::string());
+    header.reward = h.at("reward").get<uint64_t>();
+    header.num_txes = h.value("num_txes", 0);
+    header.major_version = h.value("major_version", uint64_t(0));
+    header.block_weight = h.value("block_weight", uint64_t(0));
+    return header;
+}
+
+bool get_last_block_header(BlockHeader& out) {
+    std::string res = rpc_call("get_last_block_header", "{}");
+    if (res.empty()) return false;
+    try {
+        json parsed = json::parse(res);
+        if (parsed.contains("error")) {
+            log_message(g_log_path, "[ERRO] RPC get_last_block_header retornou erro: " + parsed["error"].dump(), false);
+            return false;
+        }
+        out = parse_block_header(parsed.at("result").at("block_header"));
+        return true;
+    } catch (const std::exception& ex) {
+        log_message(g_log_path, std::string("[ERRO] Falha ao parsear get_last_block_header: ") + ex.what(), false);
+        return false;
+    }
+}
+
+bool get_block_headers_range(int start_height, int end_height, std::vector<BlockHeader>& out) {
+    out.clear();
+    json params = { {"start_height", start_height}, {"end_height", end_height} };
+    std::string res = rpc_call("get_block_headers_range", params.dump());
+    if (res.empty()) return false;
+    try {
+        json parsed = json::parse(res);
+        if (parsed.contains("error")) {
+            std::stringstream ss;
+            ss << "[ERRO] RPC get_block_headers_range retornou erro para " << start_height
+               << ".." << end_height << ": " << parsed["error"];
+            log_message(g_log_path, ss.str(), false);
+            return false;
+        }
+        const json& headers = parsed.at("result").at("headers");
+        out.reserve(headers.size());
+        for (const auto& h : headers) out.push_back(parse_block_header(h));
+    } catch (const std::exception& ex) {
+        std::stringstream ss;
+        ss << "[ERRO] Falha ao parsear get_block_headers_range " << start_height
+           << ".." << end_height << ": " << ex.what();
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    if (out.size() != static_cast<size_t>(end_height - start_height + 1)) {
+        std::stringstream ss;
+        ss << "[ERRO] get_block_headers_range devolveu " << out.size() << " cabeçalhos para "
+           << start_height << ".." << end_height;
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    return true;
+}
+
+bool check_node_quorum(int from, int to, const std::vector<BlockFields>& fields,
+                       std::vector<std::string>& disagree) {
+    disagree.assign(fields.size(), std::string());
+    int answered = 0;
+    for (int node = 0; node < static_cast<int>(rpc_node_count()); ++node) {
+        RpcNodePin pin(node);
+        bool ok = true;
+        std::vector<BlockHeader> headers;
+        for (int first = from; first <= to && ok; first += MAX_HEADER_RANGE) {
+            int last = std::min(to, first + MAX_HEADER_RANGE - 1);
+            ok = get_block_headers_range(first, last, headers);
+            for (size_t k = 0; ok && k < headers.size(); ++k) {
+                size_t i = static_cast<size_t>(first - from) + k;
+                const BlockFields& f = fields[i];
+                if (f.hash.empty() || (headers[k].hash == f.hash && headers[k].reward == f.reward)) continue;
+                std::stringstream ss;
+                if (!disagree[i].empty()) ss << "; ";
+                ss << rpc_node_url(node) << ": hash " << headers[k].hash << ", reward " << headers[k].reward;
+                disagree[i] += ss.str();
+            }
+        }
+        if (ok) {
+            ++answered;
+        } else {
+            std::stringstream ss;
+            ss << "[AVISO] Quórum: " << rpc_node_url(node) << " não respondeu pelos blocos " << from << ".." << to;
+            log_message(g_log_path, ss.str(), false);
+        }
+    }
+    return answered >= 2;
+}
+
+void set_fee_audit(bool enabled) {
+    fee_audit = enabled;
+}
+
+void set_id_check(bool enabled) {
+    id_check = enabled;
+}
+
+// Taxas das txs que acompanham o bloco em get_blocks_by_height.bin: cada
+// uma é um blob (ou, em nós recentes, um objeto com o blob)
+static bool read_bin_fees(const ps::Value& entry, size_t expected, uint64_t height, uint64_t& fees) {
+    std::stringstream ss;
+    const ps::Value* txs = entry.find("txs");
+    size_t count = txs && txs->is_array ? txs->items.size() : 0;
+    if (count != expected) {
+        ss << "[ERRO] get_blocks_by_height.bin devolveu " << count << " de " << expected << " txs do bloco " << height;
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    fees = 0;
+    std::string error;
+    for (size_t k = 0; k < count; ++k) {
+        const ps::Value& tx = txs->items[k];
+        const ps::Value* blob = tx.type == ps::TYPE_OBJECT ? tx.find("blob") : &tx;
+        uint64_t fee = 0;
+        if (!blob || !parse_tx_fee(reinterpret_cast<const uint8_t*>(blob->s.data()), blob->s.size(), fee, &error)) {
+            ss << "[ERRO] Tx " << k << " inválida no bloco " << height << ": " << (blob ? error : "sem blob");
+            log_message(g_log_path, ss.str(), false);
+            return false;
+        }
+        fees += fee;
+    }
+    return true;
+}
+
+bool fetch_on_one_node(const std::function<bool()>& fetch) {
+    if (pinned_rpc_node() >= 0) return fetch();
+    int node = pick_rpc_node();
+    {
+        RpcNodePin pin(node);
+        if (fetch()) return true;
+    }
+    // O duplicado por chamada misturaria os nós: o lote inteiro vai ao outro
+    int other = rpc_hedging() ? pick_rpc_node(node) : -1;
+    if (other < 0) return false;
+    std::stringstream ss;
+    ss << "[AVISO] Lote falhou em " << rpc_node_url(node) << "; repetindo inteiro em " << rpc_node_url(other);
+    log_message(g_log_path, ss.str(), false);
+    RpcNodePin pin(other);
+    return fetch();
+}
+
+static bool get_blocks_fields_bin_on_node(int from, int to, std::vector<BlockFields>& out) {
+    out.clear();
+    std::stringstream ss;
+
+    // Hash e reward vêm do cabeçalho: nem o blob nem a resposta .bin os trazem
+    std::vector<BlockHeader> headers;
+    if (!get_block_headers_range(from, to, headers)) return false;
+
+    std::vector<uint64_t> heights;
+    for (int h = from; h <= to; ++h) heights.push_back(static_cast<uint64_t>(h));
+    ps::Writer request;
+    request.add_uint64_array("heights", heights);
+
+    std::string res = rpc_call_bin("/get_blocks_by_height.bin", request.finish());
+    if (res.empty()) return false;
+
+    ps::Value root;
+    std::string error;
+    if (!ps::decode(res, root, &error)) {
+        ss << "[ERRO] Resposta de get_blocks_by_height.bin inválida (" << from << ".." << to << "): " << error;
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    const ps::Value* status = root.find("status");
+    if (status && status->s != "OK") {
+        ss << "[ERRO] get_blocks_by_height.bin retornou status " << std::string(status->s);
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    const ps::Value* blocks = root.find("blocks");
+    if (!blocks || !blocks->is_array || blocks->items.size() != heights.size()) {
+        ss << "[ERRO] get_blocks_by_height.bin devolveu contagem de blocos inesperada para " << from << ".." << to;
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+
+    out.resize(heights.size());
+    std::vector<ParsedBlock> parsed(heights.size());
+    std::vector<BlockBlob> blobs;
+    for (size_t k = 0; k < heights.size(); ++k) {
+        const ps::Value* blob = blocks->items[k].find("block");
+        ParsedBlock& block = parsed[k];
+        if (!blob || !parse_block_blob(reinterpret_cast<const uint8_t*>(blob->s.data()), blob->s.size(), block, &error)) {
+            ss.str("");
+            ss << "[ERRO] Blob binário inválido no bloco " << heights[k] << ": " << error;
+            log_message(g_log_path, ss.str(), false);
+            out.clear();
+            return false;
+        }
+        // Hash e reward são emparelhados por posição: um cabeçalho fora de
+        // ordem atribuiria o hash de um bloco ao blob de outro
+        if (headers[k].height != static_cast<int>(heights[k])) {
+            ss.str("");
+            ss << "[ERRO] get_block_headers_range devolveu altura " << headers[k].height
+               << " na posição do bloco " << heights[k];
+            log_message(g_log_path, ss.str(), false);
+            out.clear();
+            return false;
+        }
+        BlockFields& f = out[k];
+        f.hash = headers[k].hash;
+        f.prev_hash = to_hex(block.prev_id.data(), block.prev_id.size());
+        f.reward = headers[k].reward;
+        f.coinbase_sum = block.miner_tx.vout_sum;
+        f.vin_count = block.miner_tx.vin_count;
+        f.gen_height = block.miner_tx.gen_height;
+        f.major_version = block.major_version;
+        f.weight = headers[k].block_weight;
+        if (fee_audit) {
+            uint64_t fees = 0;
+            if (!read_bin_fees(blocks->items[k], block.tx_hashes.size(), heights[k], fees)) {
+                out.clear();
+                return false;
+            }
+            f.fees = fees;
+        }
+        if (id_check) blobs.push_back({ reinterpret_cast<const uint8_t*>(blob->s.data()), blob->s.size(), &block });
+    }
+    if (id_check) {
+        std::vector<Hash32> ids;
+        block_ids(blobs, ids);
+        for (size_t k = 0; k < ids.size(); ++k) out[k].computed_id = ids[k];
+    }
+    return true;
+}
+
+bool get_blocks_fields_bin(int from, int to, std::vector<BlockFields>& out) {
+    return fetch_on_one_node([&] { return get_blocks_fields_bin_on_node(from, to, out); });
+}
+
+static bool get_blocks_fields_batch_on_node(int from, int to, std::vector<BlockFields>& out) {
+    out.clear();
+    std::stringstream ss;
+
+    std::vector<BlockHeader> headers;
+    if (!get_block_headers_range(from, to, headers)) return false;
+
+    // Miner txs do intervalo em grupos de tx_batch_size hashes por /get_transactions
+    std::vector<BlockFields> fields(headers.size());
+    const size_t group = static_cast<size_t>(tx_batch_size.load());
+    std::string blob;
+    std::string error;
+    for (size_t first = 0; first < headers.size(); first += group) {
+        size_t last = std::min(headers.size(), first + group);
+        json hashes = json::array();
+        for (size_t k = first; k < last; ++k) hashes.push_back(headers[k].miner_tx_hash);
+        json params = { {"txs_hashes", hashes}, {"decode_as_json", false} };
+
+        std::string res = rpc_call_path("/get_transactions", params.dump());
+        if (res.empty()) return false;
+        try {
+            json parsed = json::parse(res);
+            if (parsed.value("status", std::string()) != "OK") {
+                ss << "[ERRO] get_transactions retornou status " << parsed.value("status", std::string("?"))
+                   << " para os blocos " << headers[first].height << ".." << headers[last - 1].height;
+                log_message(g_log_path, ss.str(), false);
+                return false;
+            }
+            const json& txs = parsed.at("txs");
+            if (txs.size() != last - first) {
+                ss << "[ERRO] get_transactions devolveu " << txs.size() << " de " << (last - first)
+                   << " miner txs para os blocos " << headers[first].height << ".." << headers[last - 1].height;
+                log_message(g_log_path, ss.str(), false);
+                return false;
+            }
+            for (size_t k = first; k < last; ++k) {
+                const json& tx = txs[k - first];
+                if (tx.value("tx_hash", std::string()) != headers[k].miner_tx_hash) {
+                    ss << "[ERRO] get_transactions fora de ordem no bloco " << headers[k].height;
+                    log_message(g_log_path, ss.str(), false);
+                    return false;
+                }
+                // Nós podados devolvem a miner tx só em pruned_as_hex
+                std::string hex = tx.value("as_hex", std::string());
+                if (hex.empty()) hex = tx.value("pruned_as_hex", std::string());
+                ParsedTx miner_tx;
+                const uint8_t* p = nullptr;
+                bool ok = from_hex(hex, blob);
+                if (ok) {
+                    p = reinterpret_cast<const uint8_t*>(blob.data());
+                    ok = parse_miner_tx(p, p + blob.size(), miner_tx, &error);
+                }
+                if (!ok) {
+                    ss << "[ERRO] Miner tx inválida no bloco " << headers[k].height << ": "
+                       << (error.empty() ? "hex inválido" : error);
+                    log_message(g_log_path, ss.str(), false);
+                    return false;
+                }
+                BlockFields& f = fields[k];
+                f.hash = headers[k].hash;
+                f.prev_hash = headers[k].prev_hash;
+                f.reward = headers[k].reward;
+                f.coinbase_sum = miner_tx.vout_sum;
+                f.vin_count = miner_tx.vin_count;
+                f.gen_height = miner_tx.gen_height;
+                f.major_version = headers[k].major_version;
+                f.weight = headers[k].block_weight;
+            }
+        } catch (const std::exception& ex) {
+            ss << "[ERRO] Falha ao parsear get_transactions dos blocos " << headers[first].height
+               << ".." << headers[last - 1].height << ": " << ex.what();
+            log_message(g_log_path, ss.str(), false);
+            return false;
+        }
+    }
+    out.swap(fields);
+    return true;
+}
+
+bool get_blocks_fields_batch(int from, int to, std::vector<BlockFields>& out) {
+    return fetch_on_one_node([&] { return get_blocks_fields_batch_on_node(from, to, out); });
+}
+
+static std::atomic<bool> parse_validation(false);
+
+void set_parse_validation(bool enabled) {
+    parse_validation = enabled;
+}
+
+bool get_block_fields(int height, BlockFields& out) {
+    json params = { {"height", height} };
+    std::string res = rpc_call("get_block", params.dump());
+    if (res.empty()) {
+        std::stringstream ss;
+        ss << "[ERRO] Falha ao obter bloco " << height;
+        log_message(g_log_path, ss.str(), false);
+        return false;
+    }
+    return parse_block_response(height, res, out);
+}
+
+// Taxas de blocos já obtidos por get_block, a partir dos tx_hashes
+static bool resolve_fees(int from, int to, std::vector<BlockFields>& blocks) {
+    std::stringstream ss;
+    std::unordered_map<std::string, uint64_t> fee_of;
+    std::vector<const std::string*> pending;
+    for (const auto& b : blocks) {
+        for (const auto& hash : b.tx_hashes) {
+            if (fee_of.emplace(hash, 0).second) pending.push_back(&hash);
+        }
+    }
+
+    const size_t group = static_cast<size_t>(tx_batch_size.load());
+    std::string blob;
+    std::string error;
+    for (size_t first = 0; first < pending.size(); first += group) {
+        size_t last = std::min(pending.size(), first + group);
+        json hashes = json::array();
+        for (size_t k = first; k < last; ++k) hashes.push_back(*pending[k]);
+        json params = { {"txs_hashes", hashes}, {"decode_as_json", false}, {"prune", true} };
+
+        std::string res = rpc_call_path("/get_transactions", params.dump());
+        if (res.empty()) return false;
+        try {
+            json parsed = json::parse(res);
+            const json& txs = parsed.value("txs", json::array());
+            if (parsed.value("status", std::string()) != "OK" || txs.size() != last - first) {
+                ss << "[ERRO] get_transactions devolveu " << txs.size() << " de " << (last - first)
+                   << " txs dos blocos " << from << ".." << to << " (status "
+                   << parsed.value("status", std::string("?")) << ")";
+                log_message(g_log_path, ss.str(), false);
+                return false;
+            }
+            for (const auto& tx : txs) {
+                auto it = fee_of.find(tx.value("tx_hash", std::string()));
+                std::string hex = tx.value("pruned_as_hex", std::string());
+                if (hex.empty()) hex = tx.value("as_hex", std::string());
+                bool ok = it != fee_of.end() && from_hex(hex, blob);
+                error = ok ? "" : "hash inesperado ou hex inválido";
+                if (ok) ok = parse_tx_fee(reinterpret_cast<const uint8_t*>(blob.data()), blob.size(), it->second, &error);
+                if (!ok) {
+                    ss << "[ERRO] Tx " << tx.value("tx_hash", std::string("?")) << " inválida nos blocos "
+                       << from << ".." << to << ": " << error;
+                    log_message(g_log_path, ss.str(), false);
+                    return false;
+                }
+            }
+        } catch (const std::exception& ex) {
+            ss << "[ERRO] Falha ao parsear get_transactions dos blocos " << from << ".." << to << ": " << ex.what();
+            log_message(g_log_path, ss.str(), false);
+            return false;
+        }
+    }
+
+    for (auto& b : blocks) {
+        uint64_t fees = 0;
+        for (const auto& hash : b.tx_hashes) fees += fee_of[hash];
+        b.fees = fees;
+    }
+    return true;
+}
+
+static bool get_blocks_fields_json_on_node(int from, int to, std::vector<BlockFields>& out) {
+    out.assign(static_cast<size_t>(to - from) + 1, BlockFields());
+    for (int h = from; h <= to; ++h) {
+        if (!get_block_fields(h, out[h - from])) {
+            out.clear();
+            return false;
+        }
+    }
+    if (fee_audit && !resolve_fees(from, to, out)) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool get_blocks_fields_json(int from, int to, std::vector<BlockFields>& out) {
+    return fetch_on_one_node([&] { return get_blocks_fields_json_on_node(from, to, out); });
+}
+
+// Verificação do id na fonte json: recalcula o id a partir de result.blob e
+// passa a usar a miner tx, os hashes das txs e o prev_id do blob, que é o
+// que o id garante
+static void check_json_blob(int height, const std::string& hex, BlockFields& out) {
+    thread_local std::string bytes;
+    ParsedBlock block;
+    std::string error = "blob ausente";
+    if (hex.empty() || !from_hex(hex, bytes) ||
+        !parse_block_blob(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), block, &error)) {
+        std::stringstream ss;
+        ss << "[AVISO] Id do bloco " << height << " não verificado: " << error;
+        log_message(g_log_path, ss.str(), false);
+        return;
+    }
+    std::vector<Hash32> ids;
+    block_ids({ { reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), &block } }, ids);
+    out.computed_id = ids[0];
+    out.prev_hash = to_hex(block.prev_id.data(), block.prev_id.size());
+
+    std::vector<std::string> tx_hashes;
+    tx_hashes.reserve(block.tx_hashes.size());
+    for (const auto& h : block.tx_hashes) tx_hashes.push_back(to_hex(h.data(), h.size()));
+    if (out.coinbase_sum != block.miner_tx.vout_sum || out.vin_count != block.miner_tx.vin_count ||
+        out.gen_height != block.miner_tx.gen_height || out.tx_hashes != tx_hashes) {
+        std::stringstream ss;
+        ss << "[AVISO] JSON do bloco " << height << " diverge do blob (coinbase " << out.coinbase_sum << " x "
+           << block.miner_tx.vout_sum << ", txs " << out.tx_hashes.size() << " x " << tx_hashes.size()
+           << "); usados os campos do blob";
+        log_message(g_log_path, ss.str(), false);
+        out.coinbase_sum = block.miner_tx.vout_sum;
+        out.vin_count = block.miner_tx.vin_count;
+        out.gen_height = block.miner_tx.gen_height;
+        out.tx_hashes = std::move(tx_hashes);
+    }
+}
+
+bool parse_block_response(int height, const std::string& res, BlockFields& out) {
+    thread_local std::string blob_hex;
+    std::string* blob = id_check ? &blob_hex : nullptr;
+    std::string error;
+    if (!parse_get_block_fast(res, out, &error, blob)) {
+        // Estrutura inesperada: tenta o caminho DOM antes de desistir
+        std::string dom_error;
+        if (!parse_get_block_dom(res, out, &dom_error, blob)) {
+            std::stringstream ss;
+            ss << "[ERRO] Falha ao parsear bloco " << height << ": " << dom_error;
+            log_message(g_log_path, ss.str(), false);
+            return false;
+        }
+        std::stringstream ss;
+        ss << "[AVISO] Extração rápida falhou para o bloco " << height << " (" << error << "); usado DOM";
+        log_message(g_log_path, ss.str(), false);
+    } else if (parse_validation) {
+        BlockFields dom;
+        if (!parse_get_block_dom(res, dom) || dom != out) {
+            std::stringstream ss;
+            ss << "[ERRO] Extração rápida diverge do DOM no bloco " << height << "; usado DOM";
+            log_message(g_log_path, ss.str(), false);
+            out = dom;
+        }
+    }
+    if (id_check) check_json_blob(height, blob_hex, out);
+    return true;
+}
+
 json get_transaction_details(const std::string& tx_hash) {
     json params = {
         {"txs_hashes", {tx_hash}},
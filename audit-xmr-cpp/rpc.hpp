@@ -1,17 +1,99 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <curl/curl.h>
 #include <nlohmann/json.hpp>
+#include "block_parse.hpp"
 
 extern std::string RPC_URL;
 extern std::string g_log_path; // Variável global para o caminho do log
 
 // Funções RPC e auxiliares
 void set_rpc_url(const std::string& url);
+void set_rpc_timeout(long seconds); // Timeout por requisição (chave "timeout" do cfg)
 std::string rpc_call(const std::string& method, const std::string& params_json);
+std::string rpc_base_url(); // RPC_URL sem o sufixo /json_rpc
+std::string rpc_call_path(const std::string& path, const std::string& body_json); // Endpoints JSON fora do /json_rpc
+std::string rpc_call_bin(const std::string& path, const std::string& body);       // Endpoints .bin (portable storage)
 int get_blockchain_height();  // Retorna um int, conforme a implementação
 nlohmann::json get_block_info(int height);
+bool get_block_fields(int height, BlockFields& out); // get_block com extração sob demanda
+bool get_blocks_fields_json(int from, int to, std::vector<BlockFields>& out); // Um get_block por altura, em sequência, num só nó
+bool parse_block_response(int height, const std::string& res, BlockFields& out); // Resposta de get_block já recebida
+void set_parse_validation(bool enabled); // Confere a extração rápida contra o DOM
+
+// Cabeçalho de bloco como devolvido por get_block_headers_range
+struct BlockHeader {
+    int height = 0;
+    std::string hash;
+    std::string prev_hash;
+    std::string miner_tx_hash;
+    uint64_t reward = 0;
+    int num_txes = 0;
+    uint64_t major_version = 0;
+    uint64_t block_weight = 0;
+};
+bool get_block_headers_range(int start_height, int end_height, std::vector<BlockHeader>& out);
+bool get_last_block_header(BlockHeader& out); // Topo da cadeia do nó
+
+// Quórum entre os nós configurados (nodes.hpp): pede os cabeçalhos de
+// [from, to] a cada nó e compara hash e reward com 'fields'. disagree[k]
+// descreve os nós que divergem na altura from+k (vazio se todos concordam;
+// campos sem hash são pulados). Retorna false se menos de dois nós
+// responderam; os que falham só vão para o log.
+bool check_node_quorum(int from, int to, const std::vector<BlockFields>& fields,
+                       std::vector<std::string>& disagree);
+
+// Roda 'fetch' com todas as requisições num só nó (nodes.hpp), para um lote
+// não juntar o cabeçalho de um nó ao blob de outro. Se falhar e o duplicado
+// estiver ligado, repete o lote inteiro em outro nó. Com a thread já fixada
+// num nó, só roda 'fetch'.
+bool fetch_on_one_node(const std::function<bool()>& fetch);
+
+// Fonte binária: blocos [from, to] via /get_blocks_by_height.bin (um único
+// pedido) mais os cabeçalhos do intervalo para hash e reward, do mesmo nó
+bool get_blocks_fields_bin(int from, int to, std::vector<BlockFields>& out);
+
+// Modo em lote: cabeçalhos de [from, to] num get_block_headers_range e as
+// miner txs em grupos por /get_transactions, do mesmo nó. Os limites abaixo são os do
+// RPC restrito do monerod.
+const int MAX_HEADER_RANGE = 1000; // Cabeçalhos por get_block_headers_range
+const int MAX_TX_BATCH = 100;      // Hashes por /get_transactions
+void set_tx_batch_size(int size);  // Limitado a [1, MAX_TX_BATCH]
+bool get_blocks_fields_batch(int from, int to, std::vector<BlockFields>& out);
+
+// Auditoria de taxas: as fontes json e bin passam a preencher
+// BlockFields::fees. Na bin as txs já vêm com os blocos; na json os
+// tx_hashes do lote inteiro vão juntos, sem repetição, em grupos de
+// tx_batch_size por /get_transactions podado (prefixo e base RCT, onde
+// fica o txnFee). A fonte batch não tem os hashes das txs.
+void set_fee_audit(bool enabled);
+
+// Verificação do id: as fontes json e bin recalculam o id de cada bloco a
+// partir do blob (Keccak da miner tx, árvore com os hashes das txs e blob
+// de hashing) em BlockFields::computed_id, que a auditoria compara com o
+// hash do cabeçalho. Na json, as saídas da miner tx e os hashes das txs
+// passam a vir do blob, que é o que o id garante.
+void set_id_check(bool enabled);
+
 nlohmann::json get_transaction_details(const std::string& tx_hash);
 
+// Peças usadas pelo motor assíncrono (engine.cpp) para montar as próprias
+// transferências com as mesmas opções e contadores das chamadas síncronas
+CURL* rpc_new_handle(); // Handle com as opções comuns; o chamador libera com curl_easy_cleanup
+void rpc_prepare_post(CURL* curl, const std::string& url, const std::string& body, std::string* response);
+bool rpc_finish_transfer(CURL* curl, CURLcode result, const std::string& what); // Conta e registra erros
+std::string rpc_json_body(const std::string& method, const std::string& params_json);
+
+// Estatísticas do pool de conexões RPC
+struct RpcStats {
+    uint64_t requests = 0; // Requisições realizadas
+    uint64_t connects = 0; // Novas conexões TCP (handshakes) abertas
+};
+RpcStats get_rpc_stats();
+
 // Funções de log
 void log_message(const std::string& log_path, const std::string& message);
 void log_message(const std::string& log_path, const std::string& message, bool is_block_end); // Sobrecarga com separador
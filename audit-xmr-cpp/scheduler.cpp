@@ -0,0 +1,101 @@
+// scheduler.cpp
+#include "scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+
+BlockScheduler::BlockScheduler(int start, int end, int batch_size, int window)
+    : start_(start),
+      end_(end),
+      batch_size_(std::max(1, batch_size)),
+      window_(std::max(window, std::max(1, batch_size))),
+      batch_count_(0),
+      next_to_write_(start) {
+    int total = end_ >= start_ ? end_ - start_ + 1 : 0;
+    batch_count_ = (total + batch_size_ - 1) / batch_size_;
+    batches_.reset(new Batch[batch_count_]);
+    for (int i = 0; i < batch_count_; ++i) {
+        batches_[i].begin = start_ + i * batch_size_;
+        batches_[i].end = std::min(end_, batches_[i].begin + batch_size_ - 1);
+        batches_[i].cursor = batches_[i].begin;
+    }
+}
+
+bool BlockScheduler::take_from(Batch& batch, int& from, int& to, int max_count) {
+    if (batch.cursor.load(std::memory_order_relaxed) > batch.end) return false;
+    int first = batch.cursor.fetch_add(max_count);
+    if (first > batch.end) return false;
+    from = first;
+    to = std::min(batch.end, first + max_count - 1);
+    return true;
+}
+
+// Procura o lote mais antigo que ainda tem alturas não reservadas. Todos os
+// lotes anteriores a next_to_write_ já foram consumidos, então a busca fica
+// restrita à janela.
+BlockScheduler::Batch* BlockScheduler::steal() {
+    int first = (next_to_write_.load() - start_) / batch_size_;
+    int last = std::min(next_batch_.load(), batch_count_);
+    for (int i = std::max(0, first); i < last; ++i) {
+        if (batches_[i].cursor.load(std::memory_order_relaxed) <= batches_[i].end) {
+            return &batches_[i];
+        }
+    }
+    return nullptr;
+}
+
+BlockScheduler::Claim BlockScheduler::try_next(Cursor& cursor, int& from, int& to, int max_count) {
+    max_count = std::max(1, max_count);
+    while (!cancelled_) {
+        if (cursor.batch >= 0) {
+            if (take_from(batches_[cursor.batch], from, to, max_count)) return Claim::Ok;
+            cursor.batch = -1;
+        }
+
+        int b = next_batch_.load();
+        if (b < batch_count_) {
+            if (batches_[b].begin < next_to_write_.load() + window_) {
+                if (next_batch_.compare_exchange_weak(b, b + 1)) cursor.batch = b;
+                continue;
+            }
+            // Janela cheia: ajuda o lote atrasado em vez de ficar parado
+            Batch* victim = steal();
+            if (victim && take_from(*victim, from, to, max_count)) return Claim::Ok;
+            return Claim::Wait;
+        }
+
+        Batch* victim = steal();
+        if (!victim) return Claim::Done;
+        if (take_from(*victim, from, to, max_count)) return Claim::Ok;
+    }
+    return Claim::Done;
+}
+
+bool BlockScheduler::next(Cursor& cursor, int& from, int& to, int max_count) {
+    while (true) {
+        Claim claim = try_next(cursor, from, to, max_count);
+        if (claim == Claim::Ok) return true;
+        if (claim == Claim::Done) return false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(20), [&] {
+            int b = next_batch_.load();
+            return cancelled_ || b >= batch_count_ || batches_[b].begin < next_to_write_.load() + window_;
+        });
+    }
+}
+
+void BlockScheduler::advance(int next_to_write) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next_to_write_ = next_to_write;
+    }
+    cv_.notify_all();
+}
+
+void BlockScheduler::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    cv_.notify_all();
+}
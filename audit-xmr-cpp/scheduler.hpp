@@ -0,0 +1,114 @@
+// scheduler.hpp
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Distribui as alturas de [start, end] em lotes pequenos, entregues em ordem
+// crescente. Quando a janela está cheia ou não há mais lotes novos, as
+// threads ociosas "roubam" alturas do lote pendente mais antigo, para que um
+// lote lento não segure a escrita ordenada. Nenhuma altura é entregue além de next_to_write + window
+// (backpressure), o que limita a memória usada pela janela de reordenação.
+class BlockScheduler {
+public:
+    // Estado de cada worker: o lote que ele está processando
+    struct Cursor {
+        int batch = -1;
+    };
+
+    BlockScheduler(int start, int end, int batch_size, int window);
+
+    // Reserva até max_count alturas contíguas. Com a janela cheia tenta roubar
+    // do lote mais antigo antes de bloquear. Retorna false quando acabou.
+    bool next(Cursor& cursor, int& from, int& to, int max_count = 1);
+
+    // Versão sem bloqueio de next(), para laços de eventos: Wait indica que a
+    // janela está cheia e nada pode ser roubado agora
+    enum class Claim { Ok, Wait, Done };
+    Claim try_next(Cursor& cursor, int& from, int& to, int max_count = 1);
+
+    // Informa a próxima altura ainda não escrita, liberando a janela
+    void advance(int next_to_write);
+
+    // Acorda todos os workers e faz next() retornar false
+    void cancel();
+
+    // Capacidade necessária para a janela de reordenação (window + um lote)
+    int capacity() const { return window_ + batch_size_; }
+    int batch_size() const { return batch_size_; }
+
+private:
+    struct Batch {
+        int begin = 0;
+        int end = 0;
+        std::atomic<int> cursor{0};
+    };
+
+    bool take_from(Batch& batch, int& from, int& to, int max_count);
+    Batch* steal();
+
+    int start_;
+    int end_;
+    int batch_size_;
+    int window_;
+    int batch_count_;
+    std::unique_ptr<Batch[]> batches_;
+    std::atomic<int> next_batch_{0};
+    std::atomic<int> next_to_write_;
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// Janela circular de tamanho fixo que recebe resultados fora de ordem e os
+// devolve em ordem de altura. Um slot vazio (std::nullopt) marca um bloco que
+// falhou definitivamente e deve ser pulado. Não é thread-safe: o chamador
+// deve serializar o acesso.
+template <typename T>
+class ReorderWindow {
+public:
+    ReorderWindow(int first_height, int capacity)
+        : next_(first_height), slots_(capacity), ready_(capacity, false) {}
+
+    void put(int height, std::optional<T> value) {
+        size_t i = index(height);
+        slots_[i] = std::move(value);
+        ready_[i] = true;
+    }
+
+    // Entrega em ordem todos os resultados prontos a partir de next_height()
+    template <typename Fn>
+    int drain(Fn&& fn) {
+        int count = 0;
+        while (true) {
+            size_t i = index(next_);
+            if (!ready_[i]) break;
+            fn(next_, slots_[i]);
+            slots_[i].reset();
+            ready_[i] = false;
+            ++next_;
+            ++count;
+        }
+        return count;
+    }
+
+    int next_height() const { return next_; }
+
+    // Resultado já entregue e ainda não escoado, para marcar um problema
+    // achado depois; nullptr se não chegou ou já saiu da janela
+    std::optional<T>* pending(int height) {
+        if (height < next_ || height >= next_ + static_cast<int>(slots_.size())) return nullptr;
+        size_t i = index(height);
+        return ready_[i] ? &slots_[i] : nullptr;
+    }
+
+private:
+    size_t index(int height) const { return static_cast<size_t>(height) % slots_.size(); }
+
+    int next_;
+    std::vector<std::optional<T>> slots_;
+    std::vector<bool> ready_;
+};
@@ -0,0 +1,189 @@
+// shard.cpp
+#include "shard.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char MANIFEST_VERSION[] = "1";
+
+bool parse_height_ranges(const std::string& text, std::vector<int>& heights) {
+    std::istringstream ss(text);
+    std::string item;
+    try {
+        while (std::getline(ss, item, ',')) {
+            item.erase(0, item.find_first_not_of(' '));
+            if (item.empty()) continue;
+            size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first) return false;
+            for (int h = first; h <= last; ++h) heights.push_back(h);
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parse_shard(const std::string& text, int& index, int& count) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) return false;
+    try {
+        size_t used = 0;
+        index = std::stoi(text.substr(0, slash), &used);
+        if (used != slash) return false;
+        count = std::stoi(text.substr(slash + 1), &used);
+        if (used != text.size() - slash - 1) return false;
+    } catch (...) {
+        return false;
+    }
+    return count >= 1 && index >= 1 && index <= count;
+}
+
+ShardPlan::ShardPlan(int start, int end, int index, int count, int span) {
+    if (end < start) return;
+    if (count <= 1) {
+        spans_.push_back({ start, 0, end - start + 1 });
+        size_ = end - start + 1;
+        return;
+    }
+    for (int k = start / span; static_cast<int64_t>(k) * span <= end; ++k) {
+        if (k % count != index - 1) continue;
+        int first = std::max(start, k * span);
+        int last = static_cast<int>(std::min<int64_t>(end, static_cast<int64_t>(k + 1) * span - 1));
+        spans_.push_back({ first, size_, last - first + 1 });
+        size_ += last - first + 1;
+    }
+}
+
+const ShardPlan::Span& ShardPlan::span_at(int position) const {
+    // Trecho com o maior first_position <= position
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), position,
+                               [](int p, const Span& s) { return p < s.first_position; });
+    return *(it - 1);
+}
+
+int ShardPlan::height_of(int position) const {
+    const Span& s = span_at(position);
+    return s.first_height + (position - s.first_position);
+}
+
+int ShardPlan::position_of(int height) const {
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), height,
+                               [](int h, const Span& s) { return h < s.first_height; });
+    if (it == spans_.begin()) return -1;
+    const Span& s = *(it - 1);
+    return height < s.first_height + s.count ? s.first_position + (height - s.first_height) : -1;
+}
+
+int ShardPlan::contiguous_until(int position, int last) const {
+    const Span& s = span_at(position);
+    return std::min(last, s.first_position + s.count - 1);
+}
+
+std::string shard_file_stem(int index, int count) {
+    return "auditoria_monero.shard-" + std::to_string(index) + "-" + std::to_string(count);
+}
+
+bool save_shard_manifest(const std::string& path, const ShardManifest& manifest, std::string* error) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        if (!file.is_open()) {
+            if (error) *error = std::strerror(errno);
+            return false;
+        }
+        file << "# Manifesto do audit-xmr --shard; junte as partes com o audit-xmr-merge\n";
+        file << "version=" << MANIFEST_VERSION << "\n";
+        file << "shard=" << manifest.index << "/" << manifest.count << "\n";
+        file << "span=" << manifest.span << "\n";
+        file << "range=" << manifest.start << "," << manifest.end << "\n";
+        file << "csv=" << manifest.csv << "\n";
+        file << "rows=" << manifest.rows << "\n";
+        file << "failed=" << format_height_ranges(manifest.failed) << "\n";
+        file.flush();
+        if (!file) {
+            if (error) *error = std::strerror(errno);
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool load_shard_manifest(const std::string& path, ShardManifest& manifest, std::string* error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        if (error) *error = "arquivo inexistente";
+        return false;
+    }
+    manifest = ShardManifest();
+    bool version_ok = false, has_shard = false, has_range = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        bool ok = true;
+        try {
+            if (key == "version") {
+                version_ok = value == MANIFEST_VERSION;
+            } else if (key == "shard") {
+                ok = has_shard = parse_shard(value, manifest.index, manifest.count);
+            } else if (key == "span") {
+                manifest.span = std::stoi(value);
+                ok = manifest.span > 0;
+            } else if (key == "range") {
+                size_t comma = value.find(',');
+                ok = has_range = comma != std::string::npos;
+                if (ok) {
+                    manifest.start = std::stoi(value.substr(0, comma));
+                    manifest.end = std::stoi(value.substr(comma + 1));
+                }
+            } else if (key == "csv") {
+                manifest.csv = value;
+            } else if (key == "rows") {
+                manifest.rows = std::stoull(value);
+            } else if (key == "failed") {
+                ok = parse_height_ranges(value, manifest.failed);
+            }
+        } catch (...) {
+            ok = false;
+        }
+        if (!ok) {
+            if (error) *error = "linha inválida: " + line;
+            return false;
+        }
+    }
+    if (!version_ok || !has_shard || !has_range || manifest.csv.empty()) {
+        if (error) *error = !version_ok ? "versão desconhecida" : "campos obrigatórios ausentes";
+        return false;
+    }
+    return true;
+}
+
+std::string format_height_ranges(std::vector<int> heights) {
+    std::sort(heights.begin(), heights.end());
+    std::string list;
+    for (size_t i = 0; i < heights.size(); ++i) {
+        size_t j = i;
+        while (j + 1 < heights.size() && heights[j + 1] == heights[j] + 1) ++j;
+        if (!list.empty()) list += ", ";
+        list += std::to_string(heights[i]);
+        if (j > i) list += "-" + std::to_string(heights[j]);
+        i = j;
+    }
+    return list;
+}
@@ -0,0 +1,56 @@
+// shard.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Auditoria dividida entre processos (--shard i/N). As alturas são agrupadas
+// em trechos de SHARD_SPAN blocos alinhados na altura 0, e a parte i fica
+// com os trechos k em que k % N == i - 1: todas as partes cobrem todas as
+// eras da cadeia (blocos antigos e pequenos, recentes e com mais txs).
+const int SHARD_SPAN = 10000;
+
+bool parse_shard(const std::string& text, int& index, int& count); // "i/N", 1 <= i <= N
+
+// Alturas de [start, end] que cabem à parte, numeradas em ordem pelas
+// posições 0..size()-1. Sem divisão (count 1), posição = altura - start.
+class ShardPlan {
+public:
+    ShardPlan(int start, int end, int index = 1, int count = 1, int span = SHARD_SPAN);
+
+    int size() const { return size_; }
+    int height_of(int position) const;
+    int position_of(int height) const; // -1 se a altura não é da parte
+    // Última posição em [position, last] cujas alturas seguem contíguas
+    int contiguous_until(int position, int last) const;
+
+private:
+    struct Span {
+        int first_height;
+        int first_position;
+        int count;
+    };
+    const Span& span_at(int position) const;
+
+    std::vector<Span> spans_;
+    int size_ = 0;
+};
+
+// Manifesto de uma parte, gravado ao lado do CSV dela ao fim da execução
+struct ShardManifest {
+    int index = 0;
+    int count = 0;
+    int span = SHARD_SPAN;
+    int start = 0;
+    int end = -1;
+    std::string csv;         // Nome do CSV da parte, no diretório do manifesto
+    uint64_t rows = 0;       // Linhas gravadas
+    std::vector<int> failed; // Alturas com falha definitiva (fora do CSV)
+};
+
+std::string shard_file_stem(int index, int count); // "auditoria_monero.shard-2-4"
+bool save_shard_manifest(const std::string& path, const ShardManifest& manifest, std::string* error = nullptr);
+bool load_shard_manifest(const std::string& path, ShardManifest& manifest, std::string* error = nullptr);
+
+// Alturas agrupadas em intervalos contíguos ("5, 9-12"); ordena 'heights'
+std::string format_height_ranges(std::vector<int> heights);
@@ -0,0 +1,187 @@
+// state.cpp
+#include "state.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char STATE_VERSION[] = "1";
+
+bool parse_checkpoint(const std::string& value, Checkpoint& cp) {
+    std::istringstream ss(value);
+    std::string height, hash, supply, bytes, fees;
+    if (!std::getline(ss, height, ',') || !std::getline(ss, hash, ',') ||
+        !std::getline(ss, supply, ',') || !std::getline(ss, bytes, ',')) {
+        return false;
+    }
+    try {
+        cp.height = std::stoi(height);
+        cp.hash = hash;
+        cp.supply = std::stoull(supply);
+        cp.csv_bytes = std::stoull(bytes);
+        // Campo opcional: estados sem a auditoria de taxas não o têm
+        cp.fees = std::getline(ss, fees) && !fees.empty() ? std::optional<uint64_t>(std::stoull(fees)) : std::nullopt;
+    } catch (...) {
+        return false;
+    }
+    return cp.height >= 0 && cp.hash.size() == 64;
+}
+
+} // namespace
+
+AuditState::AuditState(const std::string& path) : path_(path) {}
+
+bool AuditState::load(std::string* error) {
+    reset();
+    std::ifstream file(path_);
+    if (!file.is_open()) {
+        if (error) *error = "arquivo inexistente";
+        return false;
+    }
+    std::string line;
+    bool version_ok = false;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        if (key == "version") {
+            version_ok = value == STATE_VERSION;
+        } else if (key == "checkpoint") {
+            Checkpoint cp;
+            if (!parse_checkpoint(value, cp) ||
+                (!recent_.empty() && (cp.height <= recent_.back().height ||
+                                      cp.csv_bytes < recent_.back().csv_bytes))) {
+                if (error) *error = "ponto de retomada inválido: " + value;
+                reset();
+                return false;
+            }
+            recent_.push_back(cp);
+        }
+    }
+    if (!version_ok) {
+        if (error) *error = "versão desconhecida";
+        reset();
+        return false;
+    }
+    if (recent_.empty()) {
+        if (error) *error = "sem pontos de retomada";
+        return false;
+    }
+    // Tudo vai para recent_ e os excedentes descem para sparse_ como em extend()
+    while (recent_.size() > RECENT_CHECKPOINTS) {
+        sparse_.push_back(recent_.front());
+        recent_.pop_front();
+    }
+    tip_ = recent_.back();
+    return true;
+}
+
+bool AuditState::save(std::string* error) const {
+    // Sem nada auditado não há de onde retomar: um estado vazio só faria a
+    // próxima execução ler um arquivo sem pontos de retomada
+    if (tip_.height < 0) {
+        std::remove(path_.c_str());
+        return true;
+    }
+    std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        if (!file.is_open()) {
+            if (error) *error = "não foi possível criar " + tmp;
+            return false;
+        }
+        file << "# Estado do audit-xmr: altura,hash,supply,bytes do CSV[,taxas]\n";
+        file << "version=" << STATE_VERSION << "\n";
+        for (const auto& cp : checkpoints()) {
+            file << "checkpoint=" << cp.height << ',' << cp.hash << ',' << cp.supply << ',' << cp.csv_bytes;
+            if (cp.fees) file << ',' << *cp.fees;
+            file << "\n";
+        }
+        if (!file.flush()) {
+            if (error) *error = "falha ao gravar " + tmp;
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void AuditState::remove() {
+    std::remove(path_.c_str());
+    reset();
+}
+
+bool AuditState::extend(int height, const Hash32& hash, uint64_t coinbase_outputs, uint64_t csv_bytes,
+                        std::optional<uint64_t> fees) {
+    if (height != tip_.height + 1) return false;
+    tip_.height = height;
+    tip_.hash.resize(2 * hash.size());
+    to_hex(hash.data(), hash.size(), &tip_.hash[0]);
+    tip_.supply += coinbase_outputs;
+    tip_.csv_bytes = csv_bytes;
+    tip_.fees = tip_.fees && fees ? std::optional<uint64_t>(*tip_.fees + *fees) : std::nullopt;
+    // O mais antigo dos recentes só fica se for múltiplo do espaçamento;
+    // senão ele é reaproveitado para o novo topo, sem alocar outro hash
+    if (recent_.size() >= RECENT_CHECKPOINTS) {
+        Checkpoint oldest = std::move(recent_.front());
+        recent_.pop_front();
+        if (oldest.height % CHECKPOINT_SPACING == 0) {
+            sparse_.push_back(std::move(oldest));
+        } else {
+            oldest = tip_;
+            recent_.push_back(std::move(oldest));
+            return true;
+        }
+    }
+    recent_.push_back(tip_);
+    return true;
+}
+
+void AuditState::rewind(const Checkpoint& cp) {
+    while (!recent_.empty() && recent_.back().height > cp.height) recent_.pop_back();
+    while (!sparse_.empty() && sparse_.back().height > cp.height) sparse_.pop_back();
+    if (recent_.empty()) {
+        // Os recentes acabaram: o mais novo dos esparsos volta a ser o topo
+        if (!sparse_.empty() && sparse_.back().height == cp.height) sparse_.pop_back();
+        recent_.push_back(cp);
+    }
+    tip_ = cp;
+}
+
+void AuditState::reset() {
+    tip_ = Checkpoint();
+    sparse_.clear();
+    recent_.clear();
+}
+
+std::vector<Checkpoint> AuditState::checkpoints() const {
+    std::vector<Checkpoint> out(sparse_);
+    out.insert(out.end(), recent_.begin(), recent_.end());
+    return out;
+}
+
+bool csv_matches_checkpoint(const std::string& csv_path, const Checkpoint& cp) {
+    std::ifstream csv(csv_path, std::ios::binary);
+    if (!csv.is_open() || cp.csv_bytes == 0) return false;
+    csv.seekg(0, std::ios::end);
+    if (static_cast<uint64_t>(csv.tellg()) < cp.csv_bytes) return false;
+
+    // A linha cabe com folga em 512 bytes: altura, hash, três valores e os problemas
+    uint64_t window = std::min<uint64_t>(cp.csv_bytes, 512);
+    std::string tail(window, '\0');
+    csv.seekg(static_cast<std::streamoff>(cp.csv_bytes - window));
+    if (!csv.read(&tail[0], static_cast<std::streamsize>(window)) || tail.back() != '\n') return false;
+    size_t start = tail.rfind('\n', tail.size() - 2);
+    start = start == std::string::npos ? 0 : start + 1;
+    std::string prefix = std::to_string(cp.height) + "," + cp.hash + ",";
+    return tail.compare(start, prefix.size(), prefix) == 0;
+}
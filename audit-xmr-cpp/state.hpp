@@ -0,0 +1,60 @@
+// state.hpp
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+#include "block_binary.hpp"
+
+// Ponto de retomada: tudo até 'height' (inclusive) está auditado, em
+// sequência, nos primeiros 'csv_bytes' bytes do CSV
+struct Checkpoint {
+    int height = -1;
+    std::string hash;      // Hash do bloco 'height', para detectar reorganizações
+    uint64_t supply = 0;   // Soma das saídas coinbase de 0..height
+    uint64_t csv_bytes = 0;
+    // Soma das taxas de 0..height, se a auditoria de taxas acompanhou todos
+    // os blocos; supply - fees são as moedas geradas (emission.hpp)
+    std::optional<uint64_t> fees = 0;
+};
+
+// Estado persistente da auditoria (audit_state.txt em output_dir). Guarda
+// os últimos pontos de retomada, para reorganizações rasas, e um a cada
+// CHECKPOINT_SPACING alturas, para as profundas.
+class AuditState {
+public:
+    static const int CHECKPOINT_SPACING = 1000;
+    static const int RECENT_CHECKPOINTS = 32;
+
+    explicit AuditState(const std::string& path);
+
+    // false se o arquivo não existe, está malformado ou não tem nenhum ponto
+    // de retomada; com true, tip() e checkpoints() têm ao menos um
+    bool load(std::string* error = nullptr);
+    bool save(std::string* error = nullptr) const; // Grava num temporário e renomeia; sem topo, apaga o arquivo
+    void remove();
+
+    // Acrescenta a próxima linha gravada; ignora (e retorna false) alturas
+    // fora de sequência, como as que seguem um bloco que falhou
+    bool extend(int height, const Hash32& hash, uint64_t coinbase_outputs, uint64_t csv_bytes,
+                std::optional<uint64_t> fees = std::nullopt);
+
+    // Volta para o ponto de retomada 'cp' (descarta os posteriores)
+    void rewind(const Checkpoint& cp);
+    void reset(); // Sem nada auditado
+
+    const Checkpoint& tip() const { return tip_; }
+    std::vector<Checkpoint> checkpoints() const; // Em ordem crescente de altura, terminando em tip()
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    Checkpoint tip_;
+    std::vector<Checkpoint> sparse_;  // Múltiplos de CHECKPOINT_SPACING mais antigos que recent_
+    std::deque<Checkpoint> recent_;   // Os mais novos, terminando em tip_
+};
+
+// Confere se o CSV tem ao menos cp.csv_bytes bytes e se a linha que termina
+// ali é a do bloco cp.height com o hash cp.hash
+bool csv_matches_checkpoint(const std::string& csv_path, const Checkpoint& cp);